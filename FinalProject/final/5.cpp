@@ -4,6 +4,7 @@
 #include "allocore/io/al_App.hpp"
 #include "Gamma/Oscillator.h"
 #include "Gamma/SamplePlayer.h"
+#include "CELL_GRID_3D.h"
 
 
 using namespace al;
@@ -29,16 +30,11 @@ bool wireframe = false;
 bool tangent = false;
 
 
-struct CELL{
-	Vec3f pos;
-	int alive;
-};
-
 class MySimulation : public Window, public Drawable{
 public:
 
-	 std::vector<CELL> cells;
-	 std::vector<int> indices;
+	 // how alive each cell is, and the next generation, see CELL_GRID_3D.h
+	 CELL_GRID_3D<int> cells, next;
 	 // std::vector<GRAIN> allGrains;
 	 // gam::SamplePlayer<> samplePlayer;
 	 // gam::SamplePlayer<float, gam::ipl::Cubic, gam::tap::Wrap> rmsPlayer, zcrPlayer;
@@ -46,15 +42,13 @@ public:
 	 MySimulation(){
 
 
-	 	cells.resize(N*N*N);
+	 	cells.resizeAndWipe(N, N, N);
+	 	next.resizeAndWipe(N, N, N);
 	 	int index = 0;
 	 	for (int i = 0; i < N; ++i){
 			for (int j = 0; j < N; ++j){
 				for (int k = 0; k < N; ++k){
-					cells[index].pos = Vec3f(i,j,k);
-					//else cells[index].pos = Vec3f(rand()%N,rand()%N,rand()%N);
-					cells[index].alive = index % 7 == 0 ? 1 : 0;
-					indices.push_back(i*N*N + j*N + k);
+					cells(i,j,k) = index % 7 == 0 ? 1 : 0;
 					index++;
 				}
 			}
@@ -79,13 +73,14 @@ public:
 		if(wireframe)	gl.polygonMode(gl.LINE);
 		else			gl.polygonMode(gl.FILL);
 
-		for (int i = 0; i < cells.size(); ++i){
-			if (cells[i].alive == 0) continue;
+		for (int i = 0; i < cells.totalCells(); ++i){
+			const int x = i/(N*N), y = (i/N)%N, z = i%N;
+			if (cells(x,y,z) == 0) continue;
 			else{
 				gl.pushMatrix(gl.MODELVIEW);
 					glEnable(GL_RESCALE_NORMAL);
 					gl.color(HSV((float)i*i/N,1,al::fold(phase + i*0.5/8, 0.5)+0.5));
-					gl.translate(cells[i].pos);
+					gl.translate(Vec3f(x,y,z));
 					//gl.translate(-1,-1,-1);
 					gl.scale(2);
 					gl.draw(iso);
@@ -104,108 +99,42 @@ public:
 		 if(progressing){ //0.0002
 			if((phase += 0.0002) > 2*M_PI) phase -= 2*M_PI;
 			double sphere = (4.0/3.0) * M_PI*phase * pow(RADIUS,3);
-			int index = 0;
-			for(int k=0; k<N; ++k){         double z = double(k)/N * 6*M_PI;
+			// the cell at (k,j,i) counts the 8 around it in its slice,
+			// and running k fastest walks the grid in memory order
+			const std::vector<int>& slice = cells.neighborhood(CELL_GRID_3D_SLICE);
+			for(int i=0; i<N; ++i){         double x = double(i)/N * 6*M_PI;
 				for(int j=0; j<N; ++j){     double y = double(j)/N * 6*M_PI;
-					for(int i=0; i<N; ++i){ double x = double(i)/N * 6*M_PI;
+					int cell = cells.index(0,j,i);
+					for(int k=0; k<N; ++k, ++cell){ double z = double(k)/N * 6*M_PI;
+						int index = k*N*N + j*N + i;
 
-						CELL current  = find_cell(Vec3f(k,j,i));
-						int neighbors = compute_neighbors(current.pos);
+						int current  = cells[cell];
+						int neighbors = cells.sum(cell, slice);
 						
-						if (current.alive == 1){
-							current.alive = neighbors == 2 || neighbors == 3 ? 1 : 0;
+						if (current == 1){
+							next[cell] = neighbors == 2 || neighbors == 3 ? 1 : 0;
 						} else {
-							current.alive = neighbors == 5 ? 1 : 0;
-							//current.alive = symbiosis(current);
+							next[cell] = neighbors == 5 ? 1 : 0;
+							//next[cell] = symbiosis(cell);
 						}
 						
 						if (tangent) 
-							GRID[indices[index]] = tan(x*phase*9) + tan(y*phase*8) + tan(z*phase*7);
+							GRID[index] = tan(x*phase*9) + tan(y*phase*8) + tan(z*phase*7);
 						else
-							//GRID[indices[index]] = cos(x*phase*9) + cos(y*phase*8) + cos(z*phase*7);
-						GRID[indices[index]] = ( cos(x * cos(phase*7)) + cos(y * cos(phase*8)) + cos(z * cos(phase*9)) );// + cos(sphere);
-						index++;
+							//GRID[index] = cos(x*phase*9) + cos(y*phase*8) + cos(z*phase*7);
+						GRID[index] = ( cos(x * cos(phase*7)) + cos(y * cos(phase*8)) + cos(z * cos(phase*9)) );// + cos(sphere);
 					
 					}
 				}		
 			}
+			cells.swap(next);
 		}
 		return true;
 	}
 
-	CELL find_cell(Vec3f address){
-		int index = 0;
-		bool found = false;
-		while (index < cells.size() && (!found)){
-			if (cells[index].pos == address) found = true;
-			else index++;
-		}
-		return cells[index];
-	}
-
-	int compute_neighbors(Vec3f center){
-		CELL current = find_cell(center);
-		float x = current.pos.x;
-		float y = current.pos.y;
-		float z = current.pos.z;
-		std::vector<CELL> neighbors;
-		int n = 0;
-		neighbors.push_back(find_cell(Vec3f(x+1,y+1,z)));
-		neighbors.push_back(find_cell(Vec3f(x+1,y,z)));
-		neighbors.push_back(find_cell(Vec3f(x+1,y-1,z)));
-		neighbors.push_back(find_cell(Vec3f(x,y+1,z)));
-		neighbors.push_back(find_cell(Vec3f(x,y-1,z)));
-		neighbors.push_back(find_cell(Vec3f(x-1,y,z)));
-		neighbors.push_back(find_cell(Vec3f(x-1,y+1,z)));
-		neighbors.push_back(find_cell(Vec3f(x-1,y-1,z)));
-		for (int i = 0; i < neighbors.size(); ++i) n += neighbors[i].alive;
-		return n;
-	}
-
-	int symbiosis(CELL current){
-		int x = current.pos.x;
-		int y = current.pos.y;
-		int z = current.pos.z;
-		std::vector<CELL> current_poses;
-		// neighbors.push_back(find_cell(Vec3f(x,y+1,z)));
-		// neighbors.push_back(find_cell(Vec3f(x-1,y,z)));
-		// neighbors.push_back(find_cell(Vec3f(x,y-1,z)));
-		// neighbors.push_back(find_cell(Vec3f(x+1,y,z)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y-1,z)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y,z)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y+1,z)));
-		current_poses.push_back(find_cell(Vec3f(x,y+1,z)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y+1,z)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y,z)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y-1,z)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y-1,z)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y-1,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y+1,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x,y+1,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y+1,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y-1,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x,y-1,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y-1,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x,y,z+1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y-1,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y+1,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x,y+1,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y+1,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x+1,y-1,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x,y-1,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y-1,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x-1,y,z-1)));
-		current_poses.push_back(find_cell(Vec3f(x,y,z-1)));
-		int total = 0;
-		for (int i = 0; i < current_poses.size(); ++i) 
-			total += current_poses[i].alive;
-		if (total == 4) return 1;
-		else return 0; 
+	// 1 if exactly 4 of the 26 cells around are alive
+	int symbiosis(int cell){
+		return cells.sum(cell, cells.neighborhood(CELL_GRID_3D_MOORE)) == 4 ? 1 : 0;
 	}
 
 
@@ -1,6 +1,7 @@
 #include "allocore/al_Allocore.hpp"
 #include "allocore/graphics/al_Isosurface.hpp"
 #include "allocore/io/al_ControlNav.hpp"
+#include "CELL_GRID_3D.h"
 
 using namespace al;
 
@@ -20,25 +21,18 @@ bool evolve = true;
 bool wireframe = false;
 bool icosahedron = false;
 
-struct CELL{
-	Vec3f pos;
-	int alive;
-};
-
 class MySimulation : public Window, public Drawable{
 public:
 
-	 std::vector<CELL> cells;
-	 std::vector<int> indices;
+	 // which cells are alive, see CELL_GRID_3D.h
+	 CELL_GRID_3D<int> cells;
 	 MySimulation(){
-	 	cells.resize(N*N*N);
+	 	cells.resizeAndWipe(N, N, N);
 	 	int index = 0;
 	 	for (int i = 0; i < N; ++i){
 			for (int j = 0; j < N; ++j){
 				for (int k = 0; k < N; ++k){
-					cells[index].pos = Vec3f(i,j,k);
-					cells[index].alive = index % 2 == 0 ? 1 : 0;
-					indices.push_back(i*N*N + j*N + k);
+					cells(i,j,k) = index % 2 == 0 ? 1 : 0;
 					index++;
 				}
 			}
@@ -62,10 +56,10 @@ public:
 		if(wireframe)	gl.polygonMode(gl.LINE);
 		else if (icosahedron) addIcosahedron(iso);
 		else			gl.polygonMode(gl.FILL);
-		for (int i = 0; i < cells.size(); ++i){
+		for (int i = 0; i < cells.totalCells(); ++i){
 		gl.pushMatrix(gl.MODELVIEW);
 			glEnable(GL_RESCALE_NORMAL);
-			gl.translate(cells[i].pos);
+			gl.translate(Vec3f(i/(N*N), (i/N)%N, i%N));
 			gl.scale(2);
 			gl.draw(iso);
 		gl.popMatrix();
@@ -81,17 +75,14 @@ public:
 		 if(evolve){
 			if((phase += 0.0002) > 2*M_PI) phase -= 2*M_PI;
 			double sphere = (4.0/3.0) * M_PI*phase * pow(RADIUS,3);
-			int index = 0;
-			for(int k=0; k<N; ++k){ double z = double(k)/N * 6*M_PI;
-			for(int j=0; j<N; ++j){ double y = double(j)/N * 6*M_PI;
+			// running k fastest walks the grid in memory order
 			for(int i=0; i<N; ++i){ double x = double(i)/N * 6*M_PI;
+			for(int j=0; j<N; ++j){ double y = double(j)/N * 6*M_PI;
+			for(int k=0; k<N; ++k){ double z = double(k)/N * 6*M_PI;
 				//tangent works nicely!
-				Vec3f c(k,j,i);
-				CELL current = find_cell(c);
-
-				std::cout << current.alive << std::endl;
-				GRID[indices[index]] = ( cos(x * cos(phase*cells[index].alive)) + cos(y * cos(phase*cells[index].alive)) + cos(z * cos(phase*cells[index].alive)) ) * cos(sphere);
-				index++;
+				int index = k*N*N + j*N + i;
+				int alive = cells(k,j,i);
+				GRID[index] = ( cos(x * cos(phase*alive)) + cos(y * cos(phase*alive)) + cos(z * cos(phase*alive)) ) * cos(sphere);
 					//std::cout << "value: " << GRID[k*N*N + j*N + i] << std::endl;
 					
 			}}}
@@ -100,16 +91,6 @@ public:
 		return true;
 	}
 
-	CELL find_cell(Vec3f address){
-		int index = 0;
-		bool found = false;
-		while (index < cells.size() && (!found)){
-			if (cells[index].pos == address) found = true;
-			else index++;
-		}
-		return cells[index];
-	}
-
 	virtual bool onKeyDown(const Keyboard& k){
 		switch(k.key()){
 		case 'f': wireframe^=1; return false;
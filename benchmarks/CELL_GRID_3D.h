@@ -0,0 +1,159 @@
+#ifndef CELL_GRID_3D_H
+#define CELL_GRID_3D_H
+
+///////////////////////////////////////////////////////////////////////
+// A dense 3D grid of cells for the automata. It's stored flat, x
+// fastest, with a one cell border all the way around, so every cell's
+// neighbors sit at the same flat offsets from it. Finding them is an
+// add instead of a search, and nothing has to check for an edge:
+//
+//   CELL_GRID_3D<float> cells(N, N, N), next(N, N, N);
+//   const std::vector<int>& around = cells.neighborhood(CELL_GRID_3D_MOORE);
+//   cells.forEach([&](int x, int y, int z, int index) {
+//     next[index] = rule(cells[index], cells.sum(index, around));
+//   });
+//   cells.swap(next);
+//
+// forEach() visits the cells in memory order, so a generation is one
+// pass front to back with nothing allocated. Grids of the same size
+// share their indices, which is what lets next be written at index.
+//
+// The border is dead, so cells on the faces just have fewer live
+// neighbors, unless wrap() copies the opposite faces into it first,
+// which makes the grid a 3-torus. Call it before every generation
+// that should wrap.
+///////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+// which cells count as neighbors
+enum CELL_GRID_3D_NEIGHBORHOOD {
+  CELL_GRID_3D_MOORE,        // the 26 sharing a face, edge or corner
+  CELL_GRID_3D_VON_NEUMANN,  // the 6 sharing a face
+  CELL_GRID_3D_SLICE,        // the 8 around in the same z slice, like 2D Life
+  CELL_GRID_3D_NEIGHBORHOODS
+};
+
+template <class T>
+class CELL_GRID_3D {
+public:
+  CELL_GRID_3D(int xRes = 0, int yRes = 0, int zRes = 0) { resizeAndWipe(xRes, yRes, zRes); };
+
+  ////////////////////////////////////////////////////////////////////////
+  // resize with every cell, border included, set to T()
+  ////////////////////////////////////////////////////////////////////////
+  void resizeAndWipe(int xRes, int yRes, int zRes)
+  {
+    _xRes = xRes;
+    _yRes = yRes;
+    _zRes = zRes;
+    _xPitch = xRes + 2;
+    _slicePitch = _xPitch * (yRes + 2);
+    _cells.assign((size_t)_slicePitch * (zRes + 2), T());
+
+    for (int x = 0; x < CELL_GRID_3D_NEIGHBORHOODS; x++)
+      _offsets[x].clear();
+    for (int dz = -1; dz <= 1; dz++)
+      for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+        {
+          const int distance = abs(dx) + abs(dy) + abs(dz);
+          if (distance == 0) continue;
+
+          const int offset = dx + _xPitch * dy + _slicePitch * dz;
+          _offsets[CELL_GRID_3D_MOORE].push_back(offset);
+          if (distance == 1)
+            _offsets[CELL_GRID_3D_VON_NEUMANN].push_back(offset);
+          if (dz == 0)
+            _offsets[CELL_GRID_3D_SLICE].push_back(offset);
+        }
+  };
+
+  const int xRes() const { return _xRes; };
+  const int yRes() const { return _yRes; };
+  const int zRes() const { return _zRes; };
+  const int totalCells() const { return _xRes * _yRes * _zRes; };
+
+  // where (x, y, z) is in the flat storage, -1 and xRes etc. are the border
+  inline int index(int x, int y, int z) const { return (x + 1) + _xPitch * (y + 1) + _slicePitch * (z + 1); };
+
+  inline T& operator()(int x, int y, int z) { return _cells[index(x, y, z)]; };
+  inline const T& operator()(int x, int y, int z) const { return _cells[index(x, y, z)]; };
+  inline T& operator[](int index) { return _cells[index]; };
+  inline const T& operator[](int index) const { return _cells[index]; };
+
+  // flat offsets from a cell to each of its neighbors
+  const std::vector<int>& neighborhood(CELL_GRID_3D_NEIGHBORHOOD which) const { return _offsets[which]; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // add up the neighbors of the cell at index
+  ////////////////////////////////////////////////////////////////////////
+  inline T sum(int index, const std::vector<int>& offsets) const
+  {
+    const T* cell = &_cells[index];
+    T total = T();
+    for (unsigned int x = 0; x < offsets.size(); x++)
+      total += cell[offsets[x]];
+    return total;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // call function(x, y, z, index) on every cell, in memory order
+  ////////////////////////////////////////////////////////////////////////
+  template <class FUNCTION>
+  void forEach(FUNCTION function)
+  {
+    for (int z = 0; z < _zRes; z++)
+      for (int y = 0; y < _yRes; y++)
+      {
+        int i = index(0, y, z);
+        for (int x = 0; x < _xRes; x++, i++)
+          function(x, y, z, i);
+      }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // copy each face into the border on the opposite side
+  ////////////////////////////////////////////////////////////////////////
+  void wrap()
+  {
+    for (int z = -1; z <= _zRes; z++)
+      for (int y = -1; y <= _yRes; y++)
+      {
+        // rows inside the grid only have their two ends in the border
+        const bool inside = z >= 0 && z < _zRes && y >= 0 && y < _yRes;
+        for (int x = -1; x <= _xRes; x += (inside && x == -1) ? _xRes + 1 : 1)
+          _cells[index(x, y, z)] = _cells[index(wrapped(x, _xRes), wrapped(y, _yRes), wrapped(z, _zRes))];
+      }
+  };
+
+  void swap(CELL_GRID_3D& other)
+  {
+    std::swap(_xRes, other._xRes);
+    std::swap(_yRes, other._yRes);
+    std::swap(_zRes, other._zRes);
+    std::swap(_xPitch, other._xPitch);
+    std::swap(_slicePitch, other._slicePitch);
+    _cells.swap(other._cells);
+    for (int x = 0; x < CELL_GRID_3D_NEIGHBORHOODS; x++)
+      _offsets[x].swap(other._offsets[x]);
+  };
+
+private:
+  int _xRes;
+  int _yRes;
+  int _zRes;
+
+  // flat distance between rows, and between slices
+  int _xPitch;
+  int _slicePitch;
+
+  std::vector<T> _cells;
+  std::vector<int> _offsets[CELL_GRID_3D_NEIGHBORHOODS];
+
+  static inline int wrapped(int x, int res) { return (x < 0) ? x + res : (x >= res) ? x - res : x; };
+};
+
+#endif
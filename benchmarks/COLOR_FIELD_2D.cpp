@@ -0,0 +1,706 @@
+#include "COLOR_FIELD_2D.h"
+#include <jpeglib.h>
+#include <png.h>
+#include <assert.h>
+#include <algorithm>
+#include "FIELD_2D_REDUCE.h"
+
+// the reductions treat the field as a flat array of floats
+static_assert(sizeof(VEC3F) == 3 * sizeof(float), "VEC3F must be three packed floats");
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D::COLOR_FIELD_2D(const int& rows, const int& cols) :
+  _xRes(rows), _yRes(cols), _pitch(rows), _view(false)
+{
+  _totalCells = _xRes * _yRes;
+  _data = new VEC3F[_totalCells];
+
+  for (int x = 0; x < _totalCells; x++)
+    _data[x] = 0.0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// a copy of a view gets dense storage of its own
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D::COLOR_FIELD_2D(const COLOR_FIELD_2D& m) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL), _view(false)
+{
+  reallocate(m.xRes(), m.yRes());
+  forEachCell(m, [](VEC3F& cell, const VEC3F& inputCell) { cell = inputCell; });
+}
+
+COLOR_FIELD_2D::COLOR_FIELD_2D() :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL), _view(false)
+{
+}
+
+///////////////////////////////////////////////////////////////////////
+// a view doesn't own its storage, so there is nothing to steal from it
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D::COLOR_FIELD_2D(COLOR_FIELD_2D&& m) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL), _view(false)
+{
+  if (m._view)
+    *this = (const COLOR_FIELD_2D&)m;
+  else
+    swap(m);
+}
+
+///////////////////////////////////////////////////////////////////////
+// wrap storage owned by another field, which has to outlive this one
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D::COLOR_FIELD_2D(VEC3F* data, int xRes, int yRes, int pitch) :
+  _xRes(xRes), _yRes(yRes), _pitch(pitch), _totalCells(xRes * yRes), _data(data), _view(true)
+{
+  assert(pitch >= xRes);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D::~COLOR_FIELD_2D()
+{
+  if (!_view)
+    delete[] _data;
+}
+
+///////////////////////////////////////////////////////////////////////
+// throw out the old storage and allocate new, dense storage. A view
+// lets go of its field and becomes a field of its own.
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::reallocate(int xRes, int yRes)
+{
+  if (!_view)
+    delete[] _data;
+  _view = false;
+
+  _xRes = xRes;
+  _yRes = yRes;
+  _pitch = xRes;
+  _totalCells = _xRes * _yRes;
+  _data = new VEC3F[_totalCells];
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void COLOR_FIELD_2D::forEachCell(OP op)
+{
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    for (int x = 0; x < _xRes; x++)
+      op(cells[x]);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void COLOR_FIELD_2D::forEachCell(const COLOR_FIELD_2D& input, OP op)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    const VEC3F* inputCells = input.row(y);
+    for (int x = 0; x < _xRes; x++)
+      op(cells[x], inputCells[x]);
+  }
+}
+  
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::clear()
+{
+  forEachCell([](VEC3F& cell) { cell = 0.0; });
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::writePPM(string filename)
+{
+  FILE *fp;
+  unsigned char* pixels = new unsigned char[3 * _totalCells];
+
+  int index = 0;
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++, index++)
+    {
+      pixels[3 * index] = 255 * (*this)(x, y)[0];
+      pixels[3 * index + 1] = 255 * (*this)(x, y)[1];
+      pixels[3 * index + 2] = 255 * (*this)(x, y)[2];
+    }
+
+  fp = fopen(filename.c_str(), "wb");
+  fprintf(fp, "P6\n%d %d\n255\n", _xRes, _yRes);
+  fwrite(pixels, 1, _totalCells * 3, fp);
+  fclose(fp);
+  delete[] pixels;
+}
+
+///////////////////////////////////////////////////////////////////////
+// code based on example code from
+// http://zarb.org/~gc/html/libpng.html  
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::readPNG(string filename)
+{
+  cout << " Reading in PNG file " << filename.c_str() << endl;
+
+  int width, height;
+  png_structp png_ptr;
+  png_infop info_ptr;
+  png_byte color_type;
+  png_byte bit_depth;
+
+  int number_of_passes;
+  png_bytep* row_pointers;
+  png_byte header[8];    // 8 is the maximum size that can be checked
+
+  // open file and test for it being a png 
+  FILE *fp = fopen(filename.c_str(), "rb");
+  if (fp == NULL)
+  {
+    printf("[read_png_file] File %s could not be opened for reading\n", filename.c_str());
+    exit(0);
+  }
+  fread(header, 1, 8, fp);
+  if (png_sig_cmp(header, 0, 8))
+    printf("[read_png_file] File %s is not recognized as a PNG file\n", filename.c_str());
+
+  // initialize stuff
+  png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+
+  if (!png_ptr)
+    printf("[read_png_file] png_create_read_struct failed\n");
+
+  info_ptr = png_create_info_struct(png_ptr);
+  if (!info_ptr)
+    printf("[read_png_file] png_create_info_struct failed\n");
+
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[read_png_file] Error during init_io\n");
+
+  png_init_io(png_ptr, fp);
+  png_set_sig_bytes(png_ptr, 8);
+  png_read_info(png_ptr, info_ptr);
+
+  width = png_get_image_width(png_ptr, info_ptr);
+  height = png_get_image_height(png_ptr, info_ptr);
+  color_type = png_get_color_type(png_ptr, info_ptr);
+  bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+
+  number_of_passes = png_set_interlace_handling(png_ptr);
+  png_read_update_info(png_ptr, info_ptr);
+
+  // read file
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[read_png_file] Error during read_image\n");
+
+  row_pointers = (png_bytep*) malloc(sizeof(png_bytep) * height);
+  for (int y = 0; y < height; y++)
+    row_pointers[y] = (png_byte*) malloc(png_get_rowbytes(png_ptr,info_ptr));
+
+  png_read_image(png_ptr, row_pointers);
+  fclose(fp);
+
+  // push the data into the member variables
+  reallocate(width, height);
+
+  if (color_type == PNG_COLOR_TYPE_GRAY)
+  {
+    cout << " PNG color type is gray" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        (*this)(x,y) = row_pointers[height - 1 - y][x] / 255.0;
+  }
+  else if (color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+  {
+    cout << " PNG color type is gray with alpha" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        (*this)(x,y) = row_pointers[height - 1 - y][2 * x] / 255.0;
+  }
+  else if (color_type == PNG_COLOR_TYPE_RGB)
+  {
+    cout << " PNG color type is RGB" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+      {
+        float r = (float)row_pointers[height - 1 - y][3 * x] / 255.0;
+        float g = (float)row_pointers[height - 1 - y][3 * x + 1] / 255.0;
+        float b = (float)row_pointers[height - 1 - y][3 * x + 2] / 255.0;
+        (*this)(x,y)[0] = r;
+        (*this)(x,y)[1] = g;
+        (*this)(x,y)[2] = b;
+      }
+  }
+  else if (color_type == PNG_COLOR_TYPE_RGB_ALPHA)
+  {
+    cout << " PNG color type is RGB with alpha" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+      {
+        float r = (float)row_pointers[height - 1 - y][4 * x] / 255.0;
+        float g = (float)row_pointers[height - 1 - y][4 * x + 1] / 255.0;
+        float b = (float)row_pointers[height - 1 - y][4 * x + 2] / 255.0;
+        (*this)(x,y)[0] = r;
+        (*this)(x,y)[1] = g;
+        (*this)(x,y)[2] = b;
+      }
+  }
+  else
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " PNG color type is unsupported! " << endl;
+    exit(0);
+  }
+
+  for (int y = 0; y < height; y++)
+    free(row_pointers[y]);
+  free(row_pointers);
+}
+
+///////////////////////////////////////////////////////////////////////
+// code based on example code from
+// http://zarb.org/~gc/html/libpng.html  
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::writePNG(string filename)
+{
+  cout << " Writing out PNG file " << filename.c_str() << endl;
+
+  int width = _xRes; 
+  int height = _yRes;
+
+  // copy image data into pointers
+  png_bytep* row_pointers;
+  row_pointers = (png_bytep*) malloc(sizeof(png_bytep) * height);
+  for (int y = 0; y < height; y++)
+    row_pointers[y] = (png_byte*) malloc(sizeof(png_byte) * width * 3);
+
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+    {
+      VEC3F value = (*this)(x,y) * 255;
+      for (int i = 0; i < 3; i++)
+      {
+        value[i] = (value[i] > 255)  ? 255 : value[i];
+        value[i] = (value[i] < 0)  ? 0 : value[i];
+        row_pointers[height - 1 - y][3 * x + i] = (unsigned char)value[i];
+      }
+    }
+
+  png_structp png_ptr;
+  png_infop info_ptr;
+  png_byte color_type = PNG_COLOR_TYPE_RGB;
+  png_byte bit_depth = 8;
+
+  // create file
+  FILE *fp = fopen(filename.c_str(), "wb");
+  if (fp == NULL)
+    printf("[write_png_file] File %s could not be opened for writing\n", filename.c_str());
+
+  // initialize stuff
+  png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+
+  if (!png_ptr)
+    printf("[write_png_file] png_create_write_struct failed\n");
+
+  info_ptr = png_create_info_struct(png_ptr);
+  if (!info_ptr)
+    printf("[write_png_file] png_create_info_struct failed\n");
+
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during init_io\n");
+
+  png_init_io(png_ptr, fp);
+
+  // write header
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during writing header\n");
+
+  png_set_IHDR(png_ptr, info_ptr, width, height,
+       bit_depth, color_type, PNG_INTERLACE_NONE,
+       PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+
+  png_write_info(png_ptr, info_ptr);
+
+  // write bytes
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during writing bytes\n");
+
+  png_write_image(png_ptr, row_pointers);
+  
+  // end write
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during end of write\n");
+
+  png_write_end(png_ptr, NULL);
+
+  // cleanup heap allocation
+  for (int y=0; y<height; y++)
+    free(row_pointers[y]);
+  free(row_pointers);
+
+  fclose(fp);
+}
+
+///////////////////////////////////////////////////////////////////////
+// jpeglib code based on:
+// http://andrewewhite.net/wordpress/2008/09/02/very-simple-jpeg-writer-in-c-c
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::writeJPG(string filename)
+{
+  cout << " Writing out JPG file " << filename.c_str() << endl;
+
+  FILE* file = fopen(filename.c_str(), "wb");
+ 
+  if (file == NULL)
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " Could not open file: " << filename.c_str() << endl;
+    exit(0);
+  }
+
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr       jerr;
+   
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+  jpeg_stdio_dest(&cinfo, file);
+   
+  cinfo.image_width      = _xRes;
+  cinfo.image_height     = _yRes;
+  cinfo.input_components = 3;
+  cinfo.in_color_space   = JCS_RGB;
+
+  jpeg_set_defaults(&cinfo);
+  // set the quality [0..100]
+  jpeg_set_quality (&cinfo, 100, true);
+  jpeg_start_compress(&cinfo, true);
+
+  // copy data to a char buffer
+  unsigned char* buffer = new unsigned char[3 * _totalCells];
+  int index = 0;
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++, index++)
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        float entry = (*this)(x, _yRes - 1 - y)[i];
+        entry = (entry < 0.0) ? 0.0 : entry;
+        entry = (entry > 1.0) ? 1.0 : entry;
+
+        buffer[3 * index + i] = (unsigned char) (255 * entry);
+      }
+    }
+
+  JSAMPROW row_pointer;
+ 
+  while (cinfo.next_scanline < cinfo.image_height) {
+    int index = cinfo.next_scanline * 3 * _xRes;
+    row_pointer = (JSAMPROW)&buffer[index];
+    jpeg_write_scanlines(&cinfo, &row_pointer, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+
+  delete[] buffer;
+
+  fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::normalize()
+{
+  if (_totalCells == 0) return;
+
+  // one range for all three channels
+  FIELD_2D_REDUCTION<3> stats = reduce();
+  float minFound = stats.minAll();
+  float maxFound = stats.maxAll();
+
+  // the max has always been clamped to at least zero
+  maxFound = (maxFound > 0.0) ? maxFound : 0.0;
+
+  float range = 1.0 / (maxFound - minFound);
+  const int minRows = 65536 / (3 * _xRes) + 1;
+  THREAD_POOL::shared().parallelFor(_yRes, [&](int begin, int end) {
+    for (int y = begin; y < end; y++)
+    {
+      float* floats = (float*)row(y);
+      for (int x = 0; x < 3 * _xRes; x++)
+        floats[x] = (floats[x] - minFound) * range;
+    }
+  }, minRows);
+}
+
+///////////////////////////////////////////////////////////////////////
+// per-channel min, max and sum in a single parallel sweep
+///////////////////////////////////////////////////////////////////////
+FIELD_2D_REDUCTION<3> COLOR_FIELD_2D::reduce() const
+{
+  return FIELD_2D_REDUCE<3>(_yRes, _xRes,
+    [this](int y, FIELD_2D_REDUCTION<3>& partial) { partial.add((const float*)row(y), _xRes); });
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::minMaxSum(VEC3F& minFound, VEC3F& maxFound, VEC3F& total) const
+{
+  FIELD_2D_REDUCTION<3> stats = reduce();
+  for (int x = 0; x < 3; x++)
+  {
+    minFound[x] = stats.minFound[x];
+    maxFound[x] = stats.maxFound[x];
+    total[x] = stats.total[x];
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::abs()
+{
+  forEachCell([](VEC3F& cell) { cell = VEC3F::fabs(cell); });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+// a view stays a view if the size doesn't change, and gets storage of
+// its own if it does
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::resizeAndWipe(int xRes, int yRes)
+{
+  if (_xRes == xRes && _yRes == yRes)
+  {
+    clear();
+    return;
+  }
+
+  reallocate(xRes, yRes);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const float& alpha)
+{
+  forEachCell([alpha](VEC3F& cell) { cell = alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator*=(const float& alpha)
+{
+  forEachCell([alpha](VEC3F& cell) { cell *= alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator/=(const float& alpha)
+{
+  forEachCell([alpha](VEC3F& cell) { cell /= alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator+=(const float& alpha)
+{
+  forEachCell([alpha](VEC3F& cell) { cell += alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator-=(const COLOR_FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) { cell -= inputCell; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator+=(const COLOR_FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) { cell += inputCell; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator*=(const COLOR_FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) {
+    cell[0] *= inputCell[0];
+    cell[1] *= inputCell[1];
+    cell[2] *= inputCell[2];
+  });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator/=(const COLOR_FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) {
+    for (int y = 0; y < 3; y++)
+      if (fabs(inputCell[y]) > 1e-6)
+        cell[y] /= inputCell[y];
+      else
+        cell[y] = 0;
+  });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const COLOR_FIELD_2D& A)
+{
+  // every cell gets overwritten, so only touch the allocation
+  // if the size actually changed
+  if (A.xRes() != _xRes || A.yRes() != _yRes)
+    resizeAndWipe(A.xRes(), A.yRes());
+
+  forEachCell(A, [](VEC3F& cell, const VEC3F& inputCell) { cell = inputCell; });
+
+  return *this;
+}
+
+// moving into or out of a view copies the cells, since the view's
+// storage stays with its field
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(COLOR_FIELD_2D&& A)
+{
+  if (this == &A)
+    return *this;
+
+  if (_view || A._view)
+    return *this = (const COLOR_FIELD_2D&)A;
+
+  delete[] _data;
+
+  _xRes = A._xRes;
+  _yRes = A._yRes;
+  _pitch = A._pitch;
+  _totalCells = A._totalCells;
+  _data = A._data;
+
+  A._xRes = 0;
+  A._yRes = 0;
+  A._pitch = 0;
+  A._totalCells = 0;
+  A._data = NULL;
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+// exchange contents with another field without copying
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::swap(COLOR_FIELD_2D& input)
+{
+  if (_view || input._view)
+  {
+    assert(input.xRes() == _xRes);
+    assert(input.yRes() == _yRes);
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        std::swap((*this)(x, y), input(x, y));
+    return;
+  }
+
+  std::swap(_xRes, input._xRes);
+  std::swap(_yRes, input._yRes);
+  std::swap(_pitch, input._pitch);
+  std::swap(_totalCells, input._totalCells);
+  std::swap(_data, input._data);
+}
+
+///////////////////////////////////////////////////////////////////////
+// sum of all entries
+///////////////////////////////////////////////////////////////////////
+VEC3F COLOR_FIELD_2D::sum()
+{
+  VEC3F minFound, maxFound, total;
+  minMaxSum(minFound, maxFound, total);
+
+  return total;
+}
+
+///////////////////////////////////////////////////////////////////////
+// take the log
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::log(float base)
+{
+  float scale = 1.0 / std::log(base);
+  forEachCell([scale](VEC3F& cell) {
+    for (int y = 0; y < 3; y++)
+      cell[y] = std::log(cell[y]) * scale;
+  });
+}
+
+///////////////////////////////////////////////////////////////////////
+// get the min of the field
+///////////////////////////////////////////////////////////////////////
+VEC3F COLOR_FIELD_2D::min()
+{
+  assert(_xRes > 0);
+  assert(_yRes > 0);
+  VEC3F final, maxFound, total;
+  minMaxSum(final, maxFound, total);
+
+  return final;
+}
+
+///////////////////////////////////////////////////////////////////////
+// get the max of the field
+///////////////////////////////////////////////////////////////////////
+VEC3F COLOR_FIELD_2D::max()
+{
+  assert(_xRes > 0);
+  assert(_yRes > 0);
+  VEC3F minFound, final, total;
+  minMaxSum(minFound, final, total);
+
+  return final;
+}
+
+///////////////////////////////////////////////////////////////////////
+// set to a checkboard for debugging
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::setToCheckerboard(int xChecks, int yChecks)
+{
+  for (int x = 0; x < _xRes; x++)
+    for (int y = 0; y < _yRes; y++)
+    {
+      int xMod = (x / (_xRes / xChecks)) % 2;
+      int yMod = (y / (_yRes / yChecks)) % 2;
+
+      if ((xMod && yMod) || (!xMod && !yMod))
+        (*this)(x,y) = 1;
+    }
+}
@@ -0,0 +1,996 @@
+#include "FIELD_2D.h"
+#include <jpeglib.h>
+#include <png.h>
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+#include "FIELD_2D_REDUCE.h"
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(const int& rows, const int& cols) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+  reallocate(rows, cols, rows, FIELD_2D_ROW_MAJOR);
+  clear();
+}
+
+///////////////////////////////////////////////////////////////////////
+// each row starts pitch floats after the last one
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(const int& rows, const int& cols, const int& pitch) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+  reallocate(rows, cols, pitch, FIELD_2D_ROW_MAJOR);
+  clear();
+}
+
+///////////////////////////////////////////////////////////////////////
+// the tiled layouts keep each FIELD_2D_TILE square of cells together,
+// so vertical neighbors are usually in the same few cache lines
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(const int& rows, const int& cols, const FIELD_2D_LAYOUT& layout) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+  reallocate(rows, cols, rows, layout);
+  clear();
+}
+
+FIELD_2D::FIELD_2D(const FIELD_2D& m) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+  // a copy of a view gets storage of its own, without the padding
+  if (m.isView())
+  {
+    reallocate(m.xRes(), m.yRes(), m.xRes(), FIELD_2D_ROW_MAJOR);
+    forEachCell(m, [](float& cell, const float& inputCell) { cell = inputCell; });
+    return;
+  }
+
+  reallocate(m.xRes(), m.yRes(), m.pitch(), m.layout());
+
+  const int size = storageSize();
+  for (int x = 0; x < size; x++)
+    _data[x] = m[x];
+}
+
+FIELD_2D::FIELD_2D() :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+}
+
+///////////////////////////////////////////////////////////////////////
+// a view doesn't own its storage, so there is nothing to steal from it
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(FIELD_2D&& m) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+  if (m._view)
+    *this = (const FIELD_2D&)m;
+  else
+    swap(m);
+}
+
+///////////////////////////////////////////////////////////////////////
+// wrap storage owned by another field, which has to outlive this one
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(float* data, int xRes, int yRes, int pitch) :
+  _xRes(xRes), _yRes(yRes), _pitch(pitch), _totalCells(xRes * yRes),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(data), _view(true)
+{
+  assert(pitch >= xRes);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::~FIELD_2D()
+{
+  if (!_view)
+    release(_data);
+}
+
+///////////////////////////////////////////////////////////////////////
+// rows start on a cache line, so SIMD loads at the beginning of a row
+// never straddle two of them
+///////////////////////////////////////////////////////////////////////
+float* FIELD_2D::allocate(int size)
+{
+  if (size <= 0)
+    return NULL;
+
+  void* memory = NULL;
+  if (posix_memalign(&memory, FIELD_2D_ALIGNMENT, size * sizeof(float)) != 0)
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " FIELD_2D could not allocate " << size << " floats! " << endl;
+    exit(0);
+  }
+  return (float*)memory;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::release(float* data)
+{
+  free(data);
+}
+
+///////////////////////////////////////////////////////////////////////
+// throw out the old storage and allocate new storage for the given
+// size and layout, without wiping it. A view lets go of its field
+// and becomes a field of its own.
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::reallocate(int xRes, int yRes, int pitch, FIELD_2D_LAYOUT layout)
+{
+  if (!_view)
+    release(_data);
+  _view = false;
+
+  _xRes = xRes;
+  _yRes = yRes;
+  _totalCells = _xRes * _yRes;
+  _layout = layout;
+
+  if (_layout == FIELD_2D_ROW_MAJOR)
+  {
+    assert(pitch >= xRes);
+    _pitch = pitch;
+    _xTiles = 0;
+    _yTiles = 0;
+  }
+  else
+  {
+    // there are no whole rows to have a pitch
+    _pitch = 0;
+    _xTiles = (_xRes + FIELD_2D_TILE - 1) / FIELD_2D_TILE;
+    _yTiles = (_yRes + FIELD_2D_TILE - 1) / FIELD_2D_TILE;
+  }
+
+  _data = allocate(storageSize());
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+const int FIELD_2D::storageSize() const
+{
+  if (_layout == FIELD_2D_ROW_MAJOR)
+    return _pitch * _yRes;
+  return _xTiles * _yTiles * FIELD_2D_TILE * FIELD_2D_TILE;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Tiles on the right and bottom edges can hang off the field, and the
+// cells hanging off are never read. Elementwise ops on the tiled
+// layouts just sweep the whole storage, so those cells can end up
+// holding anything.
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void FIELD_2D::forEachCell(OP op)
+{
+  if (_layout != FIELD_2D_ROW_MAJOR)
+  {
+    const int size = storageSize();
+    for (int x = 0; x < size; x++)
+      op(_data[x]);
+    return;
+  }
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    float* row = _data + y * _pitch;
+    for (int x = 0; x < _xRes; x++)
+      op(row[x]);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void FIELD_2D::forEachCell(const FIELD_2D& input, OP op)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  if (_layout == FIELD_2D_ROW_MAJOR && input.layout() == FIELD_2D_ROW_MAJOR)
+  {
+    for (int y = 0; y < _yRes; y++)
+    {
+      float* row = _data + y * _pitch;
+      const float* inputRow = input.row(y);
+      for (int x = 0; x < _xRes; x++)
+        op(row[x], inputRow[x]);
+    }
+    return;
+  }
+
+  // same size and the same tiling, so the storage lines up exactly
+  if (_layout == input.layout())
+  {
+    const int size = storageSize();
+    const float* inputData = input.data();
+    for (int x = 0; x < size; x++)
+      op(_data[x], inputData[x]);
+    return;
+  }
+
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++)
+      op((*this)(x, y), input(x, y));
+}
+
+///////////////////////////////////////////////////////////////////////
+// a row pitch that starts every row on a cache line, and that doesn't
+// land vertical neighbors in the same cache set, which happens when
+// rows are a multiple of 4K apart
+///////////////////////////////////////////////////////////////////////
+int FIELD_2D::paddedPitch(int xRes)
+{
+  const int perLine = FIELD_2D_ALIGNMENT / sizeof(float);
+  int pitch = ((xRes + perLine - 1) / perLine) * perLine;
+
+  if ((pitch * sizeof(float)) % 4096 == 0)
+    pitch += perLine;
+
+  return pitch;
+}
+  
+///////////////////////////////////////////////////////////////////////
+// wipes the padding too, so it never holds garbage, except in a view,
+// where the padding is the rest of some other field
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::clear()
+{
+  if (_view)
+  {
+    forEachCell([](float& cell) { cell = 0.0; });
+    return;
+  }
+
+  const int size = storageSize();
+  for (int x = 0; x < size; x++)
+    _data[x] = 0.0;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::write(string filename) const
+{
+  FILE* file;
+  file = fopen(filename.c_str(), "wb");
+  if (file == NULL)
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " FIELD_2D write failed! " << endl;
+    cout << " Could not open file " << filename.c_str() << endl;
+    exit(0);
+  }
+
+  // write dimensions
+  fwrite((void*)&_xRes, sizeof(int), 1, file);
+  fwrite((void*)&_yRes, sizeof(int), 1, file);
+
+  // always write out as a double, without the row padding, a row
+  // at a time
+  vector<double> rowDouble(_xRes);
+  for (int y = 0; y < _yRes; y++)
+  {
+    for (int x = 0; x < _xRes; x++)
+      rowDouble[x] = (*this)(x,y);
+    fwrite((void*)&rowDouble[0], sizeof(double), _xRes, file);
+  }
+  fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::read(string filename)
+{
+  FILE* file;
+  file = fopen(filename.c_str(), "rb");
+  if (file == NULL)
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " FIELD_2D read failed! " << endl;
+    cout << " Could not open file " << filename.c_str() << endl;
+    exit(0);
+  }
+
+  // read dimensions
+  int xRes, yRes;
+  fread((void*)&xRes, sizeof(int), 1, file);
+  fread((void*)&yRes, sizeof(int), 1, file);
+  resizeAndWipe(xRes, yRes);
+
+  // always read in as a double, a row at a time
+  vector<double> rowDouble(_xRes);
+  for (int y = 0; y < _yRes; y++)
+  {
+    if (fread((void*)&rowDouble[0], sizeof(double), _xRes, file) != (size_t)_xRes)
+      break;
+    for (int x = 0; x < _xRes; x++)
+      (*this)(x,y) = rowDouble[x];
+  }
+  fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::writePPM(string filename)
+{
+  FILE *fp;
+  unsigned char* pixels = new unsigned char[3 * _totalCells];
+
+  int index = 0;
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++, index++)
+    {
+      pixels[3 * index] = 255 * (*this)(x,y);
+      pixels[3 * index + 1] = 255 * (*this)(x,y);
+      pixels[3 * index + 2] = 255 * (*this)(x,y);
+    }
+
+  fp = fopen(filename.c_str(), "wb");
+  fprintf(fp, "P6\n%d %d\n255\n", _xRes, _yRes);
+  fwrite(pixels, 1, _totalCells * 3, fp);
+  fclose(fp);
+  delete[] pixels;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::writeMatlab(string filename, string variableName) const
+{
+  FILE* file;
+  file = fopen(filename.c_str(), "w");
+  fprintf(file, "%s = [", variableName.c_str());
+  for (int y = 0; y < _yRes; y++)
+  {
+    for (int x = 0; x < _xRes; x++)
+      fprintf(file, "%f ", (*this)(x,y));
+    fprintf(file, "; ");
+  }
+  fprintf(file, "];\n");
+
+  fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////
+// code based on example code from
+// http://zarb.org/~gc/html/libpng.html  
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::readPNG(string filename)
+{
+  cout << " Reading in PNG file " << filename.c_str() << endl;
+
+  int width, height;
+  png_structp png_ptr;
+  png_infop info_ptr;
+  png_byte color_type;
+  png_byte bit_depth;
+
+  int number_of_passes;
+  png_bytep* row_pointers;
+  png_byte header[8];    // 8 is the maximum size that can be checked
+
+  // open file and test for it being a png 
+  FILE *fp = fopen(filename.c_str(), "rb");
+  if (fp == NULL)
+  {
+    printf("[read_png_file] File %s could not be opened for reading\n", filename.c_str());
+    exit(0);
+  }
+  fread(header, 1, 8, fp);
+  if (png_sig_cmp(header, 0, 8))
+    printf("[read_png_file] File %s is not recognized as a PNG file\n", filename.c_str());
+
+  // initialize stuff
+  png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+
+  if (!png_ptr)
+    printf("[read_png_file] png_create_read_struct failed\n");
+
+  info_ptr = png_create_info_struct(png_ptr);
+  if (!info_ptr)
+    printf("[read_png_file] png_create_info_struct failed\n");
+
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[read_png_file] Error during init_io\n");
+
+  png_init_io(png_ptr, fp);
+  png_set_sig_bytes(png_ptr, 8);
+  png_read_info(png_ptr, info_ptr);
+
+  width = png_get_image_width(png_ptr, info_ptr);
+  height = png_get_image_height(png_ptr, info_ptr);
+  color_type = png_get_color_type(png_ptr, info_ptr);
+  bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+
+  number_of_passes = png_set_interlace_handling(png_ptr);
+  png_read_update_info(png_ptr, info_ptr);
+
+  // read file
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[read_png_file] Error during read_image\n");
+
+  row_pointers = (png_bytep*) malloc(sizeof(png_bytep) * height);
+  for (int y = 0; y < height; y++)
+    row_pointers[y] = (png_byte*) malloc(png_get_rowbytes(png_ptr,info_ptr));
+
+  png_read_image(png_ptr, row_pointers);
+  fclose(fp);
+
+  // push the data into the member variables
+  resizeAndWipe(width, height);
+
+  if (color_type == PNG_COLOR_TYPE_GRAY)
+  {
+    cout << " PNG color type is gray" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        (*this)(x,y) = row_pointers[height - 1 - y][x] / 255.0;
+  }
+  else if (color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+  {
+    cout << " PNG color type is gray with alpha" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        (*this)(x,y) = row_pointers[height - 1 - y][2 * x] / 255.0;
+  }
+  else if (color_type == PNG_COLOR_TYPE_RGB)
+  {
+    cout << " PNG color type is RGB" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+      {
+        float r = (float)row_pointers[height - 1 - y][3 * x] / 255.0;
+        float g = (float)row_pointers[height - 1 - y][3 * x + 1] / 255.0;
+        float b = (float)row_pointers[height - 1 - y][3 * x + 2] / 255.0;
+        (*this)(x,y) = (r + g + b) / 3.0;
+      }
+  }
+  else if (color_type == PNG_COLOR_TYPE_RGB_ALPHA)
+  {
+    cout << " PNG color type is RGB with alpha" << endl;
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+      {
+        float r = (float)row_pointers[height - 1 - y][4 * x] / 255.0;
+        float g = (float)row_pointers[height - 1 - y][4 * x + 1] / 255.0;
+        float b = (float)row_pointers[height - 1 - y][4 * x + 2] / 255.0;
+        (*this)(x,y) = (r + g + b) / 3.0;
+      }
+  }
+  else
+  {
+    cout << " PNG color type " << (int)color_type << " is unsupported! " << endl;
+    exit(0);
+  }
+
+  for (int y = 0; y < height; y++)
+    free(row_pointers[y]);
+  free(row_pointers);
+}
+
+///////////////////////////////////////////////////////////////////////
+// code based on example code from
+// http://zarb.org/~gc/html/libpng.html  
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::writePNG(string filename)
+{
+  cout << " Writing out PNG file " << filename.c_str() << endl;
+
+  int width = _xRes; 
+  int height = _yRes;
+
+  // copy image data into pointers
+  png_bytep* row_pointers;
+  row_pointers = (png_bytep*) malloc(sizeof(png_bytep) * height);
+  for (int y = 0; y < height; y++)
+    row_pointers[y] = (png_byte*) malloc(sizeof(png_byte) * width);
+
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+    {
+      float value = (*this)(x,y) * 255;
+      value = (value > 255)  ? 255 : value;
+      value = (value < 0)  ? 0 : value;
+      row_pointers[height - 1 - y][x] = (unsigned char)value;
+    }
+
+  png_structp png_ptr;
+  png_infop info_ptr;
+  png_byte color_type = PNG_COLOR_TYPE_GRAY;
+  png_byte bit_depth = 8;
+
+  // create file
+  FILE *fp = fopen(filename.c_str(), "wb");
+  if (fp == NULL)
+    printf("[write_png_file] File %s could not be opened for writing\n", filename.c_str());
+
+  // initialize stuff
+  png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+
+  if (!png_ptr)
+    printf("[write_png_file] png_create_write_struct failed\n");
+
+  info_ptr = png_create_info_struct(png_ptr);
+  if (!info_ptr)
+    printf("[write_png_file] png_create_info_struct failed\n");
+
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during init_io\n");
+
+  png_init_io(png_ptr, fp);
+
+  // write header
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during writing header\n");
+
+  png_set_IHDR(png_ptr, info_ptr, width, height,
+       bit_depth, color_type, PNG_INTERLACE_NONE,
+       PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+
+  png_write_info(png_ptr, info_ptr);
+
+  // write bytes
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during writing bytes\n");
+
+  png_write_image(png_ptr, row_pointers);
+  
+  // end write
+  if (setjmp(png_jmpbuf(png_ptr)))
+    printf("[write_png_file] Error during end of write\n");
+
+  png_write_end(png_ptr, NULL);
+
+  // cleanup heap allocation
+  for (int y=0; y<height; y++)
+    free(row_pointers[y]);
+  free(row_pointers);
+
+  fclose(fp);
+}
+
+///////////////////////////////////////////////////////////////////////
+// jpeglib code based on:
+// http://andrewewhite.net/wordpress/2008/09/02/very-simple-jpeg-writer-in-c-c
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::writeJPG(string filename)
+{
+  cout << " Writing out JPG file " << filename.c_str() << endl;
+
+  FILE* file = fopen(filename.c_str(), "wb");
+ 
+  if (file == NULL)
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " Could not open file: " << filename.c_str() << endl;
+    exit(0);
+  }
+
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr       jerr;
+   
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+  jpeg_stdio_dest(&cinfo, file);
+   
+  cinfo.image_width      = _xRes;
+  cinfo.image_height     = _yRes;
+  cinfo.input_components = 3;
+  cinfo.in_color_space   = JCS_RGB;
+
+  jpeg_set_defaults(&cinfo);
+  // set the quality [0..100]
+  jpeg_set_quality (&cinfo, 100, true);
+  jpeg_start_compress(&cinfo, true);
+
+  // copy data to a char buffer
+  unsigned char* buffer = new unsigned char[3 * _totalCells];
+  int index = 0;
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++, index++)
+    {
+      float entry = (*this)(x, _yRes - 1 - y);
+      entry = (entry < 0.0) ? 0.0 : entry;
+      entry = (entry > 1.0) ? 1.0 : entry;
+
+      buffer[3 * index] = (unsigned char) (255 * entry);
+      buffer[3 * index + 1] = (unsigned char) (255 * entry);
+      buffer[3 * index + 2] = (unsigned char) (255 * entry);
+    }
+
+  JSAMPROW row_pointer;
+ 
+  while (cinfo.next_scanline < cinfo.image_height) {
+    int index = cinfo.next_scanline * 3 * _xRes;
+    row_pointer = (JSAMPROW)&buffer[index];
+    jpeg_write_scanlines(&cinfo, &row_pointer, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+
+  delete[] buffer;
+
+  fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::normalize()
+{
+  if (_totalCells == 0) return;
+
+  float minFound, maxFound, total;
+  minMaxSum(minFound, maxFound, total);
+
+  // the max has always been clamped to at least zero
+  maxFound = (maxFound > 0.0) ? maxFound : 0.0;
+
+  float range = 1.0 / (maxFound - minFound);
+
+  // the tiled layouts just sweep the storage one tile at a time
+  if (_layout != FIELD_2D_ROW_MAJOR)
+  {
+    const int tileSize = FIELD_2D_TILE * FIELD_2D_TILE;
+    THREAD_POOL::shared().parallelFor(_xTiles * _yTiles, [&](int begin, int end) {
+      for (int x = begin * tileSize; x < end * tileSize; x++)
+        _data[x] = (_data[x] - minFound) * range;
+    }, 65536 / tileSize + 1);
+    return;
+  }
+
+  const int minRows = 65536 / _xRes + 1;
+  THREAD_POOL::shared().parallelFor(_yRes, [&](int begin, int end) {
+    for (int y = begin; y < end; y++)
+    {
+      float* row = _data + y * _pitch;
+      for (int x = 0; x < _xRes; x++)
+        row[x] = (row[x] - minFound) * range;
+    }
+  }, minRows);
+}
+
+///////////////////////////////////////////////////////////////////////
+// min, max and sum in a single parallel sweep, see FIELD_2D_REDUCE.h
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::minMaxSum(float& minFound, float& maxFound, float& total) const
+{
+  FIELD_2D_REDUCTION<1> stats;
+  if (_layout == FIELD_2D_ROW_MAJOR)
+    stats = FIELD_2D_REDUCE<1>(_yRes, _xRes,
+      [this](int y, FIELD_2D_REDUCTION<1>& partial) { partial.add(row(y), _xRes); });
+  else
+  {
+    // one job per tile, skipping whatever hangs off the field
+    const int tileSize = FIELD_2D_TILE * FIELD_2D_TILE;
+    stats = FIELD_2D_REDUCE<1>(_xTiles * _yTiles, tileSize,
+      [this, tileSize](int tile, FIELD_2D_REDUCTION<1>& partial) {
+        const int xStart = (tile % _xTiles) * FIELD_2D_TILE;
+        const int yStart = (tile / _xTiles) * FIELD_2D_TILE;
+        const int width = (_xRes - xStart < FIELD_2D_TILE) ? _xRes - xStart : FIELD_2D_TILE;
+        const int height = (_yRes - yStart < FIELD_2D_TILE) ? _yRes - yStart : FIELD_2D_TILE;
+        const float* tileData = _data + tile * tileSize;
+
+        if (width == FIELD_2D_TILE && height == FIELD_2D_TILE)
+          partial.add(tileData, tileSize);
+        else if (_layout == FIELD_2D_TILED)
+          for (int y = 0; y < height; y++)
+            partial.add(tileData + y * FIELD_2D_TILE, width);
+        else
+          for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+              partial.add(tileData + morton(x, y), 1);
+      });
+  }
+
+  minFound = stats.minFound[0];
+  maxFound = stats.maxFound[0];
+  total = stats.total[0];
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::abs()
+{
+  forEachCell([](float& cell) { cell = fabs(cell); });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+// the layout stays the same, and a padded field stays padded at the
+// new size. A view stays a view if the size doesn't change, and gets
+// dense storage of its own if it does.
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::resizeAndWipe(int xRes, int yRes)
+{
+  if (_layout != FIELD_2D_ROW_MAJOR)
+  {
+    resizeAndWipe(xRes, yRes, _layout);
+    return;
+  }
+
+  if (_view)
+  {
+    resizeAndWipe(xRes, yRes, (xRes == _xRes && yRes == _yRes) ? _pitch : xRes);
+    return;
+  }
+
+  bool padded = (_pitch != _xRes);
+  resizeAndWipe(xRes, yRes, padded ? paddedPitch(xRes) : xRes);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::resizeAndWipe(int xRes, int yRes, int pitch)
+{
+  assert(pitch >= xRes);
+
+  if (_xRes == xRes && _yRes == yRes && _pitch == pitch && _layout == FIELD_2D_ROW_MAJOR)
+  {
+    clear();
+    return;
+  }
+
+  reallocate(xRes, yRes, pitch, FIELD_2D_ROW_MAJOR);
+  clear();
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::resizeAndWipe(int xRes, int yRes, FIELD_2D_LAYOUT layout)
+{
+  if (layout == FIELD_2D_ROW_MAJOR)
+  {
+    resizeAndWipe(xRes, yRes, xRes);
+    return;
+  }
+
+  if (_xRes == xRes && _yRes == yRes && _layout == layout)
+  {
+    clear();
+    return;
+  }
+
+  reallocate(xRes, yRes, 0, layout);
+  clear();
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator=(const float& alpha)
+{
+  forEachCell([alpha](float& cell) { cell = alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator*=(const float& alpha)
+{
+  forEachCell([alpha](float& cell) { cell *= alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator/=(const float& alpha)
+{
+  forEachCell([alpha](float& cell) { cell /= alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator+=(const float& alpha)
+{
+  forEachCell([alpha](float& cell) { cell += alpha; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator-=(const FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+  forEachCell(input, [](float& cell, const float& inputCell) { cell -= inputCell; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator+=(const FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+  forEachCell(input, [](float& cell, const float& inputCell) { cell += inputCell; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator*=(const FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  forEachCell(input, [](float& cell, const float& inputCell) { cell *= inputCell; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator/=(const FIELD_2D& input)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  forEachCell(input, [](float& cell, const float& inputCell) {
+    if (fabs(inputCell) > 1e-6)
+      cell /= inputCell;
+    else
+      cell = 0;
+  });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator=(const FIELD_2D& A)
+{
+  // every cell gets overwritten, so only touch the allocation
+  // if the size actually changed, in which case take on A's layout
+  // and pitch, unless A is a view, whose pitch is its field's
+  if (A.xRes() != _xRes || A.yRes() != _yRes)
+  {
+    if (A.isView())
+      resizeAndWipe(A.xRes(), A.yRes(), A.xRes());
+    else if (A.layout() == FIELD_2D_ROW_MAJOR)
+      resizeAndWipe(A.xRes(), A.yRes(), A.pitch());
+    else
+      resizeAndWipe(A.xRes(), A.yRes(), A.layout());
+  }
+
+  forEachCell(A, [](float& cell, const float& inputCell) { cell = inputCell; });
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+// moving into or out of a view copies the cells, since the view's
+// storage stays with its field
+///////////////////////////////////////////////////////////////////////
+FIELD_2D& FIELD_2D::operator=(FIELD_2D&& A)
+{
+  if (this == &A)
+    return *this;
+
+  if (_view || A._view)
+    return *this = (const FIELD_2D&)A;
+
+  release(_data);
+
+  _xRes = A._xRes;
+  _yRes = A._yRes;
+  _pitch = A._pitch;
+  _totalCells = A._totalCells;
+  _layout = A._layout;
+  _xTiles = A._xTiles;
+  _yTiles = A._yTiles;
+  _data = A._data;
+
+  A._xRes = 0;
+  A._yRes = 0;
+  A._pitch = 0;
+  A._totalCells = 0;
+  A._layout = FIELD_2D_ROW_MAJOR;
+  A._xTiles = 0;
+  A._yTiles = 0;
+  A._data = NULL;
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+// exchange contents with another field without copying
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::swap(FIELD_2D& input)
+{
+  if (_view || input._view)
+  {
+    assert(input.xRes() == _xRes);
+    assert(input.yRes() == _yRes);
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        std::swap((*this)(x, y), input(x, y));
+    return;
+  }
+
+  std::swap(_xRes, input._xRes);
+  std::swap(_yRes, input._yRes);
+  std::swap(_pitch, input._pitch);
+  std::swap(_totalCells, input._totalCells);
+  std::swap(_layout, input._layout);
+  std::swap(_xTiles, input._xTiles);
+  std::swap(_yTiles, input._yTiles);
+  std::swap(_data, input._data);
+}
+
+///////////////////////////////////////////////////////////////////////
+// sum of all entries
+///////////////////////////////////////////////////////////////////////
+float FIELD_2D::sum()
+{
+  float minFound, maxFound, total;
+  minMaxSum(minFound, maxFound, total);
+
+  return total;
+}
+
+///////////////////////////////////////////////////////////////////////
+// take the log
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::log(float base)
+{
+  float scale = 1.0 / std::log(base);
+  forEachCell([scale](float& cell) { cell = std::log(cell) * scale; });
+}
+
+///////////////////////////////////////////////////////////////////////
+// get the min of the field
+///////////////////////////////////////////////////////////////////////
+float FIELD_2D::min()
+{
+  assert(_xRes > 0);
+  assert(_yRes > 0);
+  float final, maxFound, total;
+  minMaxSum(final, maxFound, total);
+
+  return final;
+}
+
+///////////////////////////////////////////////////////////////////////
+// get the max of the field
+///////////////////////////////////////////////////////////////////////
+float FIELD_2D::max()
+{
+  assert(_xRes > 0);
+  assert(_yRes > 0);
+  float minFound, final, total;
+  minMaxSum(minFound, final, total);
+
+  return final;
+}
+
+///////////////////////////////////////////////////////////////////////
+// set to a checkboard for debugging
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::setToCheckerboard(int xChecks, int yChecks)
+{
+  for (int x = 0; x < _xRes; x++)
+    for (int y = 0; y < _yRes; y++)
+    {
+      int xMod = (x / (_xRes / xChecks)) % 2;
+      int yMod = (y / (_yRes / yChecks)) % 2;
+
+      if ((xMod && yMod) || (!xMod && !yMod))
+        (*this)(x,y) = 1;
+    }
+}
@@ -0,0 +1,401 @@
+#ifndef FIELD_2D_H
+#define FIELD_2D_H
+
+#include <cmath>
+#include <string>
+#include <iostream>
+#include "VEC3F.h"
+#include "FIELD_2D_EXPR.h"
+
+using namespace std;
+
+// byte alignment of the field storage, one cache line
+#define FIELD_2D_ALIGNMENT 64
+
+// width of the square tiles in the tiled layouts, 64 x 64 floats is 16K
+#define FIELD_2D_TILE_BITS 6
+#define FIELD_2D_TILE (1 << FIELD_2D_TILE_BITS)
+
+// how the cells are laid out in memory
+enum FIELD_2D_LAYOUT {
+  FIELD_2D_ROW_MAJOR,  // y * pitch + x, the default
+  FIELD_2D_TILED,      // square tiles, row-major inside each tile
+  FIELD_2D_MORTON      // square tiles, Z-ordered inside each tile
+};
+
+class FIELD_2D : public FIELD_2D_EXPR<float, FIELD_2D> {
+public:
+  FIELD_2D();
+  FIELD_2D(const int& rows, const int& cols);
+  FIELD_2D(const int& rows, const int& cols, const int& pitch);
+  FIELD_2D(const int& rows, const int& cols, const FIELD_2D_LAYOUT& layout);
+  FIELD_2D(const FIELD_2D& m);
+  FIELD_2D(FIELD_2D&& m);
+  template <class E> FIELD_2D(const FIELD_2D_EXPR<float, E>& expression);
+  ~FIELD_2D();
+
+  // accessors
+  inline float& operator()(int x, int y) { return _data[index(x, y)]; };
+  const float operator()(int x, int y) const { return _data[index(x, y)]; };
+
+  // raw index into the storage, row or tile padding included, so this
+  // only walks the cells in order when the layout is row-major and
+  // pitch() == xRes()
+  inline float& operator[](int x) { return _data[x]; };
+  const float operator[](int x) const { return _data[x]; };
+  float* data() { return _data; };
+  const float* data() const { return _data; };
+  const int xRes() const { return _xRes; };
+  const int yRes() const { return _yRes; };
+  const int totalCells() const { return _totalCells; };
+  const FIELD_2D_LAYOUT layout() const { return _layout; };
+
+  // true if this is a FIELD_2D_VIEW into another field's storage
+  const bool isView() const { return _view; };
+
+  // for FIELD_2D_EXPR, (x,y) when the layout is known to be row-major
+  inline const float rowMajorCell(int x, int y) const { return _data[y * _pitch + x]; };
+  const bool rowMajor() const { return _layout == FIELD_2D_ROW_MAJOR; };
+
+  // the whole row y, only for the row-major layout
+  inline float* row(int y) { assert(_layout == FIELD_2D_ROW_MAJOR); return _data + y * _pitch; };
+  inline const float* row(int y) const { assert(_layout == FIELD_2D_ROW_MAJOR); return _data + y * _pitch; };
+
+  // floats from the start of one row to the start of the next, only
+  // meaningful for the row-major layout
+  const int pitch() const { return _pitch; };
+
+  // number of floats allocated, padding included
+  const int storageSize() const;
+
+  // where cell (x,y) lives in the storage
+  inline int index(int x, int y) const
+  {
+    if (_layout == FIELD_2D_ROW_MAJOR)
+      return y * _pitch + x;
+
+    const int tile = ((y >> FIELD_2D_TILE_BITS) * _xTiles + (x >> FIELD_2D_TILE_BITS)) << (2 * FIELD_2D_TILE_BITS);
+    const int xTile = x & (FIELD_2D_TILE - 1);
+    const int yTile = y & (FIELD_2D_TILE - 1);
+    if (_layout == FIELD_2D_TILED)
+      return tile + (yTile << FIELD_2D_TILE_BITS) + xTile;
+    return tile + morton(xTile, yTile);
+  };
+
+  // copy count cells starting at (x,y) and running along the row to
+  // and from a plain array, whatever the layout
+  void getRun(int x, int y, int count, float* values) const;
+  void setRun(int x, int y, int count, const float* values);
+
+  // a good pitch for rows xRes wide, see FIELD_2D.cpp
+  static int paddedPitch(int xRes);
+
+  // common field operations
+  void clear();
+  void normalize();
+  FIELD_2D& abs();
+
+  float min();
+  float max();
+
+  // min, max and sum all at once, cheaper than calling each one
+  void minMaxSum(float& minFound, float& maxFound, float& total) const;
+
+  // take the log
+  void log(float base = 2.0);
+ 
+  // generic IO functions. write() and read() are the old format of
+  // doubles, FIELD_2D_SNAPSHOT.h has the native, mappable one
+  void writeMatlab(string filename, string variableName) const;
+  void write(string filename) const;
+  void read(string filename);
+
+  // some image file support
+  void writePPM(string filename);
+  void writeJPG(string filename);
+  void writePNG(string filename);
+  void readPNG(string filename);
+
+  void resizeAndWipe(int xRes, int yRes);
+  void resizeAndWipe(int xRes, int yRes, int pitch);
+  void resizeAndWipe(int xRes, int yRes, FIELD_2D_LAYOUT layout);
+
+  // exchange contents with another field without copying, unless
+  // one of them is a view, which has to swap cell by cell
+  void swap(FIELD_2D& input);
+
+  // overloaded operators
+  FIELD_2D& operator=(const float& alpha);
+  FIELD_2D& operator=(const FIELD_2D& A);
+  FIELD_2D& operator=(FIELD_2D&& A);
+  FIELD_2D& operator*=(const float& alpha);
+  FIELD_2D& operator/=(const float& alpha);
+  FIELD_2D& operator+=(const float& alpha);
+  FIELD_2D& operator-=(const FIELD_2D& input);
+  FIELD_2D& operator+=(const FIELD_2D& input);
+  FIELD_2D& operator*=(const FIELD_2D& input);
+  FIELD_2D& operator/=(const FIELD_2D& input);
+
+  // evaluate a lazy expression in a single pass, see FIELD_2D_EXPR.h
+  template <class E> FIELD_2D& operator=(const FIELD_2D_EXPR<float, E>& expression);
+  template <class E> FIELD_2D& operator+=(const FIELD_2D_EXPR<float, E>& expression);
+  template <class E> FIELD_2D& operator-=(const FIELD_2D_EXPR<float, E>& expression);
+
+  // sum of all entries
+  float sum();
+  
+  // set to a checkboard for debugging
+  void setToCheckerboard(int xChecks = 10, int yChecks = 10);
+
+protected:
+  // wrap storage that belongs to some other field, see FIELD_2D_VIEW
+  FIELD_2D(float* data, int xRes, int yRes, int pitch);
+
+private:
+  friend class FIELD_2D_VIEW;
+
+  int _xRes;
+  int _yRes;
+  int _pitch;
+  int _totalCells;
+  FIELD_2D_LAYOUT _layout;
+  int _xTiles;
+  int _yTiles;
+  float* _data;
+
+  // _data belongs to some other field, so never release it
+  bool _view;
+
+  // aligned storage
+  static float* allocate(int size);
+  static void release(float* data);
+  void reallocate(int xRes, int yRes, int pitch, FIELD_2D_LAYOUT layout);
+
+  // interleave the bits of x and y, x in the even bits
+  static inline int morton(int x, int y)
+  {
+    return spread(x) | (spread(y) << 1);
+  };
+  static inline int spread(int x)
+  {
+    x = (x | (x << 4)) & 0x0F0F;
+    x = (x | (x << 2)) & 0x3333;
+    x = (x | (x << 1)) & 0x5555;
+    return x;
+  };
+
+  // spread(x + 1) from spread(x), by carrying through the odd bits
+  static inline int nextMortonX(int bits)
+  {
+    const int even = spread(FIELD_2D_TILE - 1);
+    return ((bits | ~even) + 1) & even;
+  };
+
+  // run op on every cell, or on every pair of matching cells
+  template <class OP> void forEachCell(OP op);
+  template <class OP> void forEachCell(const FIELD_2D& input, OP op);
+};
+
+// fields are leaves of an expression, so hold them by reference
+template <>
+struct FIELD_2D_OPERAND<FIELD_2D> {
+  typedef const FIELD_2D& type;
+};
+
+///////////////////////////////////////////////////////////////////////
+// A rectangle of some other row-major field, without copying it
+//
+// The view walks its field's rows with the field's pitch, so it goes
+// anywhere a FIELD_2D does, i.e. arithmetic, expressions, reductions
+// and stencils, and writing to it writes straight into the field:
+//
+//   FIELD_2D_VIEW seed(B, 91, 91, 19, 19);
+//   seed = 1;
+//
+// Copying a view gives another view of the same cells, while
+// assigning to one copies cells into it. Anything that changes its
+// size turns it into a field of its own. The field has to outlive
+// the view, and can't be resized while the view is around.
+///////////////////////////////////////////////////////////////////////
+class FIELD_2D_VIEW : public FIELD_2D {
+public:
+  FIELD_2D_VIEW(FIELD_2D& field, int x, int y, int xRes, int yRes) :
+    FIELD_2D(field.data() + y * field.pitch() + x, xRes, yRes, field.pitch())
+  {
+    assert(field.layout() == FIELD_2D_ROW_MAJOR);
+    assert(x >= 0 && xRes >= 0 && x + xRes <= field.xRes());
+    assert(y >= 0 && yRes >= 0 && y + yRes <= field.yRes());
+  };
+  FIELD_2D_VIEW(const FIELD_2D_VIEW& view) :
+    FIELD_2D(view._data, view.xRes(), view.yRes(), view.pitch()) {};
+
+  using FIELD_2D::operator=;
+  FIELD_2D_VIEW& operator=(const FIELD_2D_VIEW& view)
+  {
+    FIELD_2D::operator=(view);
+    return *this;
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// rows are contiguous in the row-major layout, and contiguous inside
+// each tile in the tiled one, so those copy in a few big pieces. In a
+// Morton tile, the y bits stay put along a row and only the x bits
+// need stepping.
+///////////////////////////////////////////////////////////////////////
+inline void FIELD_2D::getRun(int x, int y, int count, float* values) const
+{
+  assert(x >= 0 && x + count <= _xRes);
+  assert(y >= 0 && y < _yRes);
+
+  while (count > 0)
+  {
+    int length = (_layout == FIELD_2D_ROW_MAJOR) ? count : FIELD_2D_TILE - (x & (FIELD_2D_TILE - 1));
+    length = (length < count) ? length : count;
+    if (_layout == FIELD_2D_MORTON)
+    {
+      const float* run = _data + index(x, y) - spread(x & (FIELD_2D_TILE - 1));
+      for (int i = 0, bits = spread(x & (FIELD_2D_TILE - 1)); i < length; i++, bits = nextMortonX(bits))
+        values[i] = run[bits];
+    }
+    else
+    {
+      const float* run = _data + index(x, y);
+      for (int i = 0; i < length; i++)
+        values[i] = run[i];
+    }
+    x += length;
+    values += length;
+    count -= length;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+inline void FIELD_2D::setRun(int x, int y, int count, const float* values)
+{
+  assert(x >= 0 && x + count <= _xRes);
+  assert(y >= 0 && y < _yRes);
+
+  while (count > 0)
+  {
+    int length = (_layout == FIELD_2D_ROW_MAJOR) ? count : FIELD_2D_TILE - (x & (FIELD_2D_TILE - 1));
+    length = (length < count) ? length : count;
+    if (_layout == FIELD_2D_MORTON)
+    {
+      float* run = _data + index(x, y) - spread(x & (FIELD_2D_TILE - 1));
+      for (int i = 0, bits = spread(x & (FIELD_2D_TILE - 1)); i < length; i++, bits = nextMortonX(bits))
+        run[bits] = values[i];
+    }
+    else
+    {
+      float* run = _data + index(x, y);
+      for (int i = 0; i < length; i++)
+        run[i] = values[i];
+    }
+    x += length;
+    values += length;
+    count -= length;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class E>
+FIELD_2D::FIELD_2D(const FIELD_2D_EXPR<float, E>& expression) :
+  _xRes(expression.self().xRes()), _yRes(expression.self().yRes()), _pitch(_xRes),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _view(false)
+{
+  const E& A = expression.self();
+  _totalCells = _xRes * _yRes;
+  _data = allocate(_pitch * _yRes);
+
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++)
+      _data[y * _pitch + x] = A(x, y);
+}
+
+///////////////////////////////////////////////////////////////////////
+// each cell only depends on the same cell of its operands, so this
+// is safe even if this field appears in the expression
+///////////////////////////////////////////////////////////////////////
+template <class E>
+FIELD_2D& FIELD_2D::operator=(const FIELD_2D_EXPR<float, E>& expression)
+{
+  const E& A = expression.self();
+  if (A.xRes() != _xRes || A.yRes() != _yRes)
+    resizeAndWipe(A.xRes(), A.yRes());
+
+  if (_layout != FIELD_2D_ROW_MAJOR || !A.rowMajor())
+  {
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        (*this)(x, y) = A(x, y);
+    return *this;
+  }
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    float* row = _data + y * _pitch;
+    for (int x = 0; x < _xRes; x++)
+      row[x] = A.rowMajorCell(x, y);
+  }
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class E>
+FIELD_2D& FIELD_2D::operator+=(const FIELD_2D_EXPR<float, E>& expression)
+{
+  const E& A = expression.self();
+  assert(A.xRes() == _xRes);
+  assert(A.yRes() == _yRes);
+
+  if (_layout != FIELD_2D_ROW_MAJOR || !A.rowMajor())
+  {
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        (*this)(x, y) += A(x, y);
+    return *this;
+  }
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    float* row = _data + y * _pitch;
+    for (int x = 0; x < _xRes; x++)
+      row[x] += A.rowMajorCell(x, y);
+  }
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class E>
+FIELD_2D& FIELD_2D::operator-=(const FIELD_2D_EXPR<float, E>& expression)
+{
+  const E& A = expression.self();
+  assert(A.xRes() == _xRes);
+  assert(A.yRes() == _yRes);
+
+  if (_layout != FIELD_2D_ROW_MAJOR || !A.rowMajor())
+  {
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        (*this)(x, y) -= A(x, y);
+    return *this;
+  }
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    float* row = _data + y * _pitch;
+    for (int x = 0; x < _xRes; x++)
+      row[x] -= A.rowMajorCell(x, y);
+  }
+
+  return *this;
+}
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef FIELD_2D_REDUCE_H
+#define FIELD_2D_REDUCE_H
+
+///////////////////////////////////////////////////////////////////////
+// Min, max and sum of a field in a single sweep
+//
+// Works on raw rows of floats, so FIELD_2D (CHANNELS = 1) and
+// COLOR_FIELD_2D (CHANNELS = 3, one per color) share the same kernel.
+// The work is split into jobs, e.g. rows or tiles, that get spread
+// across THREAD_POOL::shared(). Each thread keeps its own running
+// min/max/sum in SIMD registers, so the field only streams through
+// the cache once. A job folds its cells into a partial result:
+//
+//   FIELD_2D_REDUCTION<1> stats = FIELD_2D_REDUCE<1>(yRes, xRes,
+//     [&](int y, FIELD_2D_REDUCTION<1>& partial) { partial.add(field.row(y), xRes); });
+//
+// Sums go into a float per SIMD lane along a row, and rows get added
+// up in double, so they won't match a serial float loop to the last
+// bit, but they drift less on big fields.
+///////////////////////////////////////////////////////////////////////
+
+#include "THREAD_POOL.h"
+#include <cfloat>
+#include <mutex>
+
+#if defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// GCC 12 warns about the placeholder operands in its own AVX-512
+// min/max intrinsics when they get inlined (GCC PR 105593), so under
+// it the reductions start at the AVX path instead
+#if defined(__AVX512F__) && !(defined(__GNUC__) && !defined(__clang__) && __GNUC__ == 12)
+#define FIELD_2D_REDUCE_AVX512 1
+#endif
+
+template <int CHANNELS>
+struct FIELD_2D_REDUCTION {
+  float minFound[CHANNELS];
+  float maxFound[CHANNELS];
+  double total[CHANNELS];
+
+  FIELD_2D_REDUCTION()
+  {
+    for (int c = 0; c < CHANNELS; c++)
+    {
+      minFound[c] = FLT_MAX;
+      maxFound[c] = -FLT_MAX;
+      total[c] = 0.0;
+    }
+  };
+
+  // min and max over every channel
+  float minAll() const
+  {
+    float final = minFound[0];
+    for (int c = 1; c < CHANNELS; c++)
+      final = (minFound[c] < final) ? minFound[c] : final;
+    return final;
+  };
+  float maxAll() const
+  {
+    float final = maxFound[0];
+    for (int c = 1; c < CHANNELS; c++)
+      final = (maxFound[c] > final) ? maxFound[c] : final;
+    return final;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // fold in another partial result
+  ////////////////////////////////////////////////////////////////////////
+  void merge(const FIELD_2D_REDUCTION& other)
+  {
+    for (int c = 0; c < CHANNELS; c++)
+    {
+      minFound[c] = (other.minFound[c] < minFound[c]) ? other.minFound[c] : minFound[c];
+      maxFound[c] = (other.maxFound[c] > maxFound[c]) ? other.maxFound[c] : maxFound[c];
+      total[c] += other.total[c];
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // fold in a run of cells, each CHANNELS floats wide
+  //
+  // The SIMD loops read CHANNELS vectors per iteration, which always
+  // covers a whole number of cells, so lane i of vector k always holds
+  // channel (k * width + i) % CHANNELS.
+  ////////////////////////////////////////////////////////////////////////
+  void add(const float* data, int cells)
+  {
+    const int size = cells * CHANNELS;
+    float sums[CHANNELS];
+    for (int c = 0; c < CHANNELS; c++)
+      sums[c] = 0.0f;
+    int x = 0;
+
+#if FIELD_2D_REDUCE_AVX512
+    if (size >= 16 * CHANNELS)
+    {
+      __m512 mins[CHANNELS], maxs[CHANNELS], adds[CHANNELS];
+      for (int k = 0; k < CHANNELS; k++)
+      {
+        mins[k] = _mm512_set1_ps(FLT_MAX);
+        maxs[k] = _mm512_set1_ps(-FLT_MAX);
+        adds[k] = _mm512_setzero_ps();
+      }
+      for (; x + 16 * CHANNELS <= size; x += 16 * CHANNELS)
+        for (int k = 0; k < CHANNELS; k++)
+        {
+          __m512 value = _mm512_loadu_ps(data + x + 16 * k);
+          mins[k] = _mm512_min_ps(mins[k], value);
+          maxs[k] = _mm512_max_ps(maxs[k], value);
+          adds[k] = _mm512_add_ps(adds[k], value);
+        }
+      fold(mins, maxs, adds, sums);
+    }
+#endif
+#if defined(__AVX__)
+    if (size - x >= 8 * CHANNELS)
+    {
+      __m256 mins[CHANNELS], maxs[CHANNELS], adds[CHANNELS];
+      for (int k = 0; k < CHANNELS; k++)
+      {
+        mins[k] = _mm256_set1_ps(FLT_MAX);
+        maxs[k] = _mm256_set1_ps(-FLT_MAX);
+        adds[k] = _mm256_setzero_ps();
+      }
+      for (; x + 8 * CHANNELS <= size; x += 8 * CHANNELS)
+        for (int k = 0; k < CHANNELS; k++)
+        {
+          __m256 value = _mm256_loadu_ps(data + x + 8 * k);
+          mins[k] = _mm256_min_ps(mins[k], value);
+          maxs[k] = _mm256_max_ps(maxs[k], value);
+          adds[k] = _mm256_add_ps(adds[k], value);
+        }
+      fold(mins, maxs, adds, sums);
+    }
+#endif
+    for (; x < size; x += CHANNELS)
+      for (int c = 0; c < CHANNELS; c++)
+      {
+        const float value = data[x + c];
+        minFound[c] = (value < minFound[c]) ? value : minFound[c];
+        maxFound[c] = (value > maxFound[c]) ? value : maxFound[c];
+        sums[c] += value;
+      }
+
+    for (int c = 0; c < CHANNELS; c++)
+      total[c] += sums[c];
+  };
+
+private:
+  ////////////////////////////////////////////////////////////////////////
+  // spill the SIMD accumulators back into the per-channel results
+  ////////////////////////////////////////////////////////////////////////
+  template <class VECTOR>
+  void fold(const VECTOR* mins, const VECTOR* maxs, const VECTOR* adds, float* sums)
+  {
+    const int width = sizeof(VECTOR) / sizeof(float);
+    for (int k = 0; k < CHANNELS; k++)
+    {
+      const float* minLanes = (const float*)&mins[k];
+      const float* maxLanes = (const float*)&maxs[k];
+      const float* addLanes = (const float*)&adds[k];
+      for (int i = 0; i < width; i++)
+      {
+        const int c = (k * width + i) % CHANNELS;
+        minFound[c] = (minLanes[i] < minFound[c]) ? minLanes[i] : minFound[c];
+        maxFound[c] = (maxLanes[i] > maxFound[c]) ? maxLanes[i] : maxFound[c];
+        sums[c] += addLanes[i];
+      }
+    }
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// run job(i, partial) for every i in [0, jobs), where each job covers
+// about cellsPerJob cells
+///////////////////////////////////////////////////////////////////////
+template <int CHANNELS, class JOB>
+FIELD_2D_REDUCTION<CHANNELS> FIELD_2D_REDUCE(const int jobs, const int cellsPerJob, const JOB& job)
+{
+  FIELD_2D_REDUCTION<CHANNELS> final;
+  std::mutex lock;
+
+  // same chunking as the stencils, so small fields stay serial
+  const int size = cellsPerJob * CHANNELS;
+  const int minJobs = 65536 / (size > 0 ? size : 1) + 1;
+  THREAD_POOL::shared().parallelFor(jobs, [&](int begin, int end) {
+    FIELD_2D_REDUCTION<CHANNELS> partial;
+    for (int x = begin; x < end; x++)
+      job(x, partial);
+
+    std::lock_guard<std::mutex> guard(lock);
+    final.merge(partial);
+  }, minJobs);
+
+  return final;
+}
+
+#endif
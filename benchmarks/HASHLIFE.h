@@ -0,0 +1,517 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+///////////////////////////////////////////////////////////////////////
+// Gosper's HashLife, for jumping a Game of Life pattern a power of two
+// generations ahead at once.
+//
+//   HASHLIFE hashlife;
+//   hashlife.setCells(field);
+//   hashlife.step(20);          // a million generations
+//   hashlife.getCells(field);
+//
+// The universe is a quadtree where every distinct square of cells is
+// stored exactly once, found through a hash of its four quadrants.
+// Each square also remembers its center half as it will be some
+// generations later, so a pattern that repeats itself, like a gun or
+// the debris an acorn leaves behind, only gets computed once no
+// matter how often it shows up in space or time.
+//
+// Unlike LIFE_2D, the board doesn't wrap around. The universe grows
+// as far as the pattern does, and getCells() copies out whatever
+// window of it the field covers.
+//
+// Nodes come out of a pool that's bounded by the number passed to the
+// constructor. Once a step leaves more than that, the nodes that the
+// current pattern doesn't use get thrown out, along with whatever
+// they remembered. It's checked between steps, so one very long step
+// can still go over for a while.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+class HASHLIFE {
+public:
+  HASHLIFE(int maxNodes = 1 << 22) : _maxNodes(maxNodes) { clear(); };
+
+  ////////////////////////////////////////////////////////////////////////
+  // an empty universe at generation 0
+  ////////////////////////////////////////////////////////////////////////
+  void clear()
+  {
+    _nodes.clear();
+    _empties.clear();
+
+    // the two single cells, dead and alive
+    _nodes.push_back(NODE(0, 0, 0, 0, 0, 0));
+    _nodes.push_back(NODE(0, 0, 0, 0, 0, 1));
+
+    _table.assign(1 << 16, (uint32_t)NONE);
+    _exponent = -1;
+    _generation = 0;
+    _root = empty(3);
+  };
+
+  // generations taken so far
+  const uint64_t generation() const { return _generation; };
+
+  // live cells
+  const double population() const { return _nodes[_root].population; };
+
+  // nodes currently in the pool
+  const int totalNodes() const { return (int)_nodes.size(); };
+
+  ////////////////////////////////////////////////////////////////////////
+  // cell access, anywhere in the plane
+  ////////////////////////////////////////////////////////////////////////
+  void set(int64_t x, int64_t y, bool alive)
+  {
+    while (!inside(x, y))
+      expand();
+    const int64_t half = halfWidth();
+    _root = set(_root, x + half, y + half, alive);
+  };
+
+  bool get(int64_t x, int64_t y) const
+  {
+    if (!inside(x, y)) return false;
+
+    const int64_t half = halfWidth();
+    uint32_t node = _root;
+    int64_t localX = x + half, localY = y + half;
+    for (int level = _nodes[_root].level; level > 0; level--)
+    {
+      const int64_t size = (int64_t)1 << (level - 1);
+      const NODE& parent = _nodes[node];
+      node = (localY < size) ? ((localX < size) ? parent.nw : parent.ne)
+                             : ((localX < size) ? parent.sw : parent.se);
+      localX &= size - 1;
+      localY &= size - 1;
+    }
+    return node == ALIVE;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // take 2^exponent generations
+  ////////////////////////////////////////////////////////////////////////
+  void step(int exponent)
+  {
+    // past that, the universe's corners don't fit in an int64_t
+    assert(exponent >= 0 && exponent <= 56);
+
+    if (totalNodes() > _maxNodes)
+      collect();
+
+    // the memoized results are only good for the step size they were
+    // computed with
+    if (exponent != _exponent)
+    {
+      for (unsigned int x = 0; x < _nodes.size(); x++)
+        _nodes[x].result = NONE;
+      _exponent = exponent;
+    }
+
+    // the root's result is only its center half, so give the pattern
+    // room to grow that far, and make the root big enough to step
+    // that far in one go
+    while (_nodes[_root].level < exponent + 2 || !centered(_root))
+      expand();
+    expand();
+
+    _root = successor(_root, exponent);
+    _generation += (uint64_t)1 << exponent;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // replace the universe with the field, where anything brighter than
+  // half is alive, and field(0, 0) is cell (0, 0)
+  ////////////////////////////////////////////////////////////////////////
+  void setCells(const FIELD_2D& field)
+  {
+    clear();
+    const int64_t biggest = (field.xRes() > field.yRes()) ? field.xRes() : field.yRes();
+    while (halfWidth() < biggest)
+      expand();
+
+    const int64_t half = halfWidth();
+    _root = build(field, _nodes[_root].level, -half, -half);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // copy the window of the universe starting at (xOrigin, yOrigin)
+  // into the field, at whatever size the field already is
+  ////////////////////////////////////////////////////////////////////////
+  void getCells(FIELD_2D& field, int64_t xOrigin = 0, int64_t yOrigin = 0) const
+  {
+    field = 0;
+    const int64_t half = halfWidth();
+    draw(field, _root, -half - xOrigin, -half - yOrigin);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // throw out every node the current pattern doesn't need
+  ////////////////////////////////////////////////////////////////////////
+  void collect()
+  {
+    std::vector<uint8_t> marked(_nodes.size(), 0);
+    marked[DEAD] = marked[ALIVE] = 1;
+
+    std::vector<uint32_t> stack(1, _root);
+    while (!stack.empty())
+    {
+      const uint32_t node = stack.back();
+      stack.pop_back();
+      if (marked[node]) continue;
+      marked[node] = 1;
+
+      const NODE& current = _nodes[node];
+      stack.push_back(current.nw);
+      stack.push_back(current.ne);
+      stack.push_back(current.sw);
+      stack.push_back(current.se);
+    }
+
+    // children always come before their parents, so they've been
+    // renumbered by the time the parent needs them
+    std::vector<uint32_t> renumbered(_nodes.size(), (uint32_t)NONE);
+    uint32_t total = 0;
+    for (uint32_t x = 0; x < _nodes.size(); x++)
+    {
+      if (!marked[x]) continue;
+      renumbered[x] = total;
+      NODE node = _nodes[x];
+      if (x > ALIVE)
+      {
+        node.nw = renumbered[node.nw];
+        node.ne = renumbered[node.ne];
+        node.sw = renumbered[node.sw];
+        node.se = renumbered[node.se];
+      }
+      _nodes[total++] = node;
+    }
+    _nodes.erase(_nodes.begin() + total, _nodes.end());
+
+    // results can point forward, so fix them up once everything has
+    // a new number, and forget the ones whose node is gone
+    for (uint32_t x = 0; x < total; x++)
+      if (_nodes[x].result != NONE)
+        _nodes[x].result = renumbered[_nodes[x].result];
+
+    _root = renumbered[_root];
+    _empties.clear();
+    rehash(_table.size());
+  };
+
+private:
+  enum { DEAD = 0, ALIVE = 1 };
+  static const uint32_t NONE = 0xffffffff;
+
+  struct NODE {
+    NODE(uint32_t nw_, uint32_t ne_, uint32_t sw_, uint32_t se_, int level_, double population_) :
+      nw(nw_), ne(ne_), sw(sw_), se(se_), result(NONE), level(level_), population(population_) {};
+
+    uint32_t nw, ne, sw, se;
+
+    // the center half, _exponent generations on, if it's known yet
+    uint32_t result;
+
+    int level;
+    double population;
+  };
+
+  int _maxNodes;
+  std::vector<NODE> _nodes;
+
+  // open addressed, holding node indices
+  std::vector<uint32_t> _table;
+
+  // the empty square at each level
+  std::vector<uint32_t> _empties;
+
+  // the step size the results were computed for
+  int _exponent;
+  uint64_t _generation;
+
+  // the universe, centered on (0, 0)
+  uint32_t _root;
+
+  const int64_t halfWidth() const { return (int64_t)1 << (_nodes[_root].level - 1); };
+
+  bool inside(int64_t x, int64_t y) const
+  {
+    const int64_t half = halfWidth();
+    return x >= -half && x < half && y >= -half && y < half;
+  };
+
+  static uint32_t hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+  {
+    uint32_t final = nw * 0x9e3779b1u + ne * 0x85ebca77u + sw * 0xc2b2ae3du + se * 0x27d4eb2fu;
+    final ^= final >> 15;
+    final *= 0x2c1b3c6du;
+    final ^= final >> 13;
+    return final;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the one node with these quadrants, made if it doesn't exist yet
+  ////////////////////////////////////////////////////////////////////////
+  uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+  {
+    const uint32_t mask = (uint32_t)_table.size() - 1;
+    uint32_t slot = hash(nw, ne, sw, se) & mask;
+    while (_table[slot] != NONE)
+    {
+      const NODE& node = _nodes[_table[slot]];
+      if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se)
+        return _table[slot];
+      slot = (slot + 1) & mask;
+    }
+
+    const uint32_t index = (uint32_t)_nodes.size();
+    _nodes.push_back(NODE(nw, ne, sw, se, _nodes[nw].level + 1,
+                          _nodes[nw].population + _nodes[ne].population +
+                          _nodes[sw].population + _nodes[se].population));
+    _table[slot] = index;
+
+    // keep the table at most half full
+    if (2 * _nodes.size() > _table.size())
+      rehash(2 * _table.size());
+    return index;
+  };
+
+  void rehash(size_t size)
+  {
+    while (size < 2 * _nodes.size())
+      size *= 2;
+    _table.assign(size, (uint32_t)NONE);
+
+    const uint32_t mask = (uint32_t)size - 1;
+    for (uint32_t x = ALIVE + 1; x < _nodes.size(); x++)
+    {
+      const NODE& node = _nodes[x];
+      uint32_t slot = hash(node.nw, node.ne, node.sw, node.se) & mask;
+      while (_table[slot] != NONE)
+        slot = (slot + 1) & mask;
+      _table[slot] = x;
+    }
+  };
+
+  uint32_t empty(int level)
+  {
+    if (_empties.empty())
+      _empties.push_back(DEAD);
+    while ((int)_empties.size() <= level)
+    {
+      const uint32_t below = _empties.back();
+      _empties.push_back(join(below, below, below, below));
+    }
+    return _empties[level];
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // double the universe, keeping the pattern in the middle
+  ////////////////////////////////////////////////////////////////////////
+  void expand()
+  {
+    const NODE root = _nodes[_root];
+    const uint32_t blank = empty(root.level - 1);
+    const uint32_t nw = join(blank, blank, blank, root.nw);
+    const uint32_t ne = join(blank, blank, root.ne, blank);
+    const uint32_t sw = join(blank, root.sw, blank, blank);
+    const uint32_t se = join(root.se, blank, blank, blank);
+    _root = join(nw, ne, sw, se);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // is everything alive inside the center half?
+  ////////////////////////////////////////////////////////////////////////
+  bool centered(uint32_t node) const
+  {
+    const NODE& root = _nodes[node];
+    const NODE& nw = _nodes[root.nw];
+    const NODE& ne = _nodes[root.ne];
+    const NODE& sw = _nodes[root.sw];
+    const NODE& se = _nodes[root.se];
+    const double center = _nodes[nw.se].population + _nodes[ne.sw].population +
+                          _nodes[sw.ne].population + _nodes[se.nw].population;
+    return center == root.population;
+  };
+
+  uint32_t set(uint32_t node, int64_t x, int64_t y, bool alive)
+  {
+    const int level = _nodes[node].level;
+    if (level == 0)
+      return alive ? ALIVE : DEAD;
+
+    const int64_t size = (int64_t)1 << (level - 1);
+    const NODE current = _nodes[node];
+    uint32_t nw = current.nw, ne = current.ne, sw = current.sw, se = current.se;
+    if (y < size)
+    {
+      if (x < size) nw = set(nw, x, y, alive);
+      else          ne = set(ne, x - size, y, alive);
+    }
+    else
+    {
+      if (x < size) sw = set(sw, x, y - size, alive);
+      else          se = set(se, x - size, y - size, alive);
+    }
+    return join(nw, ne, sw, se);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the square at (left, top) filled in from the field
+  ////////////////////////////////////////////////////////////////////////
+  uint32_t build(const FIELD_2D& field, int level, int64_t left, int64_t top)
+  {
+    const int64_t size = (int64_t)1 << level;
+    if (left >= field.xRes() || top >= field.yRes() || left + size <= 0 || top + size <= 0)
+      return empty(level);
+    if (level == 0)
+      return (field(left, top) >= 0.5f) ? ALIVE : DEAD;
+
+    const int64_t half = size / 2;
+    const uint32_t nw = build(field, level - 1, left, top);
+    const uint32_t ne = build(field, level - 1, left + half, top);
+    const uint32_t sw = build(field, level - 1, left, top + half);
+    const uint32_t se = build(field, level - 1, left + half, top + half);
+    return join(nw, ne, sw, se);
+  };
+
+  void draw(FIELD_2D& field, uint32_t node, int64_t left, int64_t top) const
+  {
+    const NODE& current = _nodes[node];
+    const int64_t size = (int64_t)1 << current.level;
+    if (current.population == 0 || left >= field.xRes() || top >= field.yRes() ||
+        left + size <= 0 || top + size <= 0)
+      return;
+    if (current.level == 0)
+    {
+      field(left, top) = 1;
+      return;
+    }
+
+    const int64_t half = size / 2;
+    draw(field, current.nw, left, top);
+    draw(field, current.ne, left + half, top);
+    draw(field, current.sw, left, top + half);
+    draw(field, current.se, left + half, top + half);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the center quarter of a node, or of the squares between nodes,
+  // without stepping
+  ////////////////////////////////////////////////////////////////////////
+  uint32_t center(uint32_t node)
+  {
+    const NODE n = _nodes[node];
+    return join(_nodes[n.nw].se, _nodes[n.ne].sw, _nodes[n.sw].ne, _nodes[n.se].nw);
+  };
+
+  uint32_t horizontal(uint32_t west, uint32_t east)
+  {
+    const NODE w = _nodes[west], e = _nodes[east];
+    return join(w.ne, e.nw, w.se, e.sw);
+  };
+
+  uint32_t vertical(uint32_t north, uint32_t south)
+  {
+    const NODE n = _nodes[north], s = _nodes[south];
+    return join(n.sw, n.se, s.nw, s.ne);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // one generation of the center 2x2 of a 4x4, brute force
+  ////////////////////////////////////////////////////////////////////////
+  uint32_t successor4x4(uint32_t node)
+  {
+    // bit y * 4 + x holds cell (x, y)
+    const NODE n = _nodes[node];
+    const uint32_t quadrants[4] = { n.nw, n.ne, n.sw, n.se };
+    int cells = 0;
+    for (int q = 0; q < 4; q++)
+    {
+      const NODE& quadrant = _nodes[quadrants[q]];
+      const int shift = (q & 1) * 2 + (q >> 1) * 8;
+      cells |= (quadrant.nw << shift) | (quadrant.ne << (shift + 1)) |
+               (quadrant.sw << (shift + 4)) | (quadrant.se << (shift + 5));
+    }
+
+    static const std::vector<uint8_t> table = buildTable();
+    const int next = table[cells];
+    return join(next & 1, (next >> 1) & 1, (next >> 2) & 1, (next >> 3) & 1);
+  };
+
+  static std::vector<uint8_t> buildTable()
+  {
+    std::vector<uint8_t> table(1 << 16);
+    for (int cells = 0; cells < (1 << 16); cells++)
+    {
+      int next = 0;
+      for (int y = 1; y <= 2; y++)
+        for (int x = 1; x <= 2; x++)
+        {
+          int neighbors = 0;
+          for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+              if (dx != 0 || dy != 0)
+                neighbors += (cells >> ((y + dy) * 4 + x + dx)) & 1;
+
+          const bool alive = (cells >> (y * 4 + x)) & 1;
+          if (neighbors == 3 || (neighbors == 2 && alive))
+            next |= 1 << ((y - 1) * 2 + (x - 1));
+        }
+      table[cells] = next;
+    }
+    return table;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // The center half of a node 2^exponent generations on, or 2^(level - 2)
+  // if that's as far as the node can see. The node gets cut into nine
+  // overlapping squares of half its size, and each gets stepped halfway
+  // (or just cropped, if the step is short). Those get regrouped into
+  // four, which step the rest of the way.
+  ////////////////////////////////////////////////////////////////////////
+  uint32_t successor(uint32_t node, int exponent)
+  {
+    const NODE n = _nodes[node];
+    if (n.result != NONE)
+      return n.result;
+
+    uint32_t final;
+    if (n.population == 0)
+      final = empty(n.level - 1);
+    else if (n.level == 2)
+      final = successor4x4(node);
+    else
+    {
+      const uint32_t middle[9] = {
+        n.nw, horizontal(n.nw, n.ne), n.ne,
+        vertical(n.nw, n.sw), center(node), vertical(n.ne, n.se),
+        n.sw, horizontal(n.sw, n.se), n.se
+      };
+
+      // stepping both halves at full speed covers 2^(level - 2)
+      const bool full = exponent >= n.level - 2;
+      uint32_t stepped[9];
+      for (int x = 0; x < 9; x++)
+        stepped[x] = full ? successor(middle[x], exponent) : center(middle[x]);
+
+      const uint32_t nw = join(stepped[0], stepped[1], stepped[3], stepped[4]);
+      const uint32_t ne = join(stepped[1], stepped[2], stepped[4], stepped[5]);
+      const uint32_t sw = join(stepped[3], stepped[4], stepped[6], stepped[7]);
+      const uint32_t se = join(stepped[4], stepped[5], stepped[7], stepped[8]);
+      final = join(successor(nw, exponent), successor(ne, exponent),
+                   successor(sw, exponent), successor(se, exponent));
+    }
+
+    _nodes[node].result = final;
+    return final;
+  };
+};
+
+#endif
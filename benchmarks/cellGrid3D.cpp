@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////
+// Times a generation of the FinalProject automata with find_cell()
+// against the same generation on a CELL_GRID_3D
+//
+// To run:
+//
+//   ./cellGrid3D [largest N]
+//
+// The find_cell() version is the one the sketches had: a linear scan
+// over every cell comparing positions, nine times a cell for its 8
+// neighbors in the slice, with a vector of them built on the heap. It
+// only runs up to N = 32, since it's O(N^6). The grid version sums the
+// same neighbors at fixed flat offsets in one pass, up to the largest
+// N (128 by default). Both run 5.cpp's rule, B5/S23 in the slice, on the
+// same start and should count the same live cells after.
+///////////////////////////////////////////////////////////////////////
+
+#include "CELL_GRID_3D.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+double seconds(const chrono::steady_clock::time_point& start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+struct CELL {
+  int x, y, z;
+  int alive;
+};
+
+// the linear search, which has to give up somewhere off the edge
+const CELL& find_cell(const vector<CELL>& cells, int x, int y, int z)
+{
+  static const CELL outside = { -1, -1, -1, 0 };
+  for (unsigned int index = 0; index < cells.size(); index++)
+    if (cells[index].x == x && cells[index].y == y && cells[index].z == z)
+      return cells[index];
+  return outside;
+}
+
+int compute_neighbors(const vector<CELL>& cells, const CELL& center)
+{
+  vector<CELL> neighbors;
+  for (int dy = -1; dy <= 1; dy++)
+    for (int dx = -1; dx <= 1; dx++)
+      if (dx != 0 || dy != 0)
+        neighbors.push_back(find_cell(cells, center.x + dx, center.y + dy, center.z));
+  int n = 0;
+  for (unsigned int i = 0; i < neighbors.size(); i++)
+    n += neighbors[i].alive;
+  return n;
+}
+
+inline int rule(int alive, int neighbors)
+{
+  return alive ? (neighbors == 2 || neighbors == 3) : (neighbors == 5);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  const int largest = (argc > 1) ? atoi(argv[1]) : 128;
+
+  printf("%6s %14s %14s %10s %16s\n", "N", "find_cell ms", "grid ms", "speedup", "alive");
+  for (int N = 8; N <= largest; N *= 2)
+  {
+    srand(123);
+    vector<int> start(N * N * N);
+    for (unsigned int x = 0; x < start.size(); x++)
+      start[x] = (rand() % 7 == 0);
+
+    // the old way, only while it finishes
+    double findSeconds = 0.0;
+    long findAlive = -1;
+    if (N <= 32)
+    {
+      vector<CELL> cells(N * N * N), next;
+      for (int x = 0; x < N * N * N; x++)
+      {
+        CELL cell = { x / (N * N), (x / N) % N, x % N, start[x] };
+        cells[x] = cell;
+      }
+      next = cells;
+
+      chrono::steady_clock::time_point clock = chrono::steady_clock::now();
+      for (unsigned int x = 0; x < cells.size(); x++)
+        next[x].alive = rule(cells[x].alive, compute_neighbors(cells, cells[x]));
+      findSeconds = seconds(clock);
+
+      findAlive = 0;
+      for (unsigned int x = 0; x < next.size(); x++)
+        findAlive += next[x].alive;
+    }
+
+    CELL_GRID_3D<int> cells(N, N, N), next(N, N, N);
+    for (int x = 0; x < N * N * N; x++)
+      cells(x / (N * N), (x / N) % N, x % N) = start[x];
+    const vector<int>& slice = cells.neighborhood(CELL_GRID_3D_SLICE);
+
+    chrono::steady_clock::time_point clock = chrono::steady_clock::now();
+    cells.forEach([&](int x, int y, int z, int index) {
+      next[index] = rule(cells[index], cells.sum(index, slice));
+    });
+    const double gridSeconds = seconds(clock);
+
+    long gridAlive = 0;
+    next.forEach([&](int x, int y, int z, int index) { gridAlive += next[index]; });
+
+    if (findAlive >= 0)
+      printf("%6i %14.3f %14.3f %10.0f %7li / %-7li\n", N, 1000.0 * findSeconds, 1000.0 * gridSeconds,
+             findSeconds / gridSeconds, findAlive, gridAlive);
+    else
+      printf("%6i %14s %14.3f %10s %7s / %-7li\n", N, "-", 1000.0 * gridSeconds, "-", "-", gridAlive);
+  }
+
+  return 0;
+}
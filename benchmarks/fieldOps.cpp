@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////
+// Times every FIELD_2D and COLOR_FIELD_2D operation, headless
+//
+// To run:
+//
+//   ./fieldOps [largest resolution] [results.json]
+//
+// For every square resolution from 128 up to 8192 (or whatever was
+// passed in), each operation gets a warm up call and is then timed
+// for about a quarter of a second. Anything an operation needs set up
+// first, like a fresh field for log(), happens outside the timer.
+//
+// Bandwidth counts the bytes the operation has to read and write per
+// cell, e.g. two reads and a write for A += B, and normalize() reads
+// twice since it finds the range before rescaling. The PNG and
+// snapshot numbers just count one field's worth of bytes, so they are
+// only good for comparing against themselves.
+//
+// The JSON has one line per result in a fixed order, so two runs can
+// be diffed directly.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "COLOR_FIELD_2D.h"
+#include "THREAD_POOL.h"
+#include "FIELD_2D_SNAPSHOT.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+// scratch files for the PNG and snapshot round trips
+#define FIELD_OPS_PNG "fieldOps.png"
+#define FIELD_OPS_SNAPSHOT "fieldOps.snap"
+
+struct RESULT {
+  string field;
+  string op;
+  int res;
+  double nsPerCell;
+  double gbPerSecond;
+};
+
+// every result so far, for the JSON at the end
+static vector<RESULT> results;
+
+// somewhere for reductions to go so they don't get optimized out
+static volatile float sink;
+
+///////////////////////////////////////////////////////////////////////
+// the IO calls chat on cout, which would bury the table
+///////////////////////////////////////////////////////////////////////
+class QUIET {
+public:
+  QUIET() : _buffer(cout.rdbuf(NULL)) {};
+  ~QUIET() { cout.rdbuf(_buffer); cout.clear(); };
+private:
+  streambuf* _buffer;
+};
+
+///////////////////////////////////////////////////////////////////////
+// seconds per call of op, with reset called untimed before each one
+///////////////////////////////////////////////////////////////////////
+double timeOp(const function<void()>& op, const function<void()>& reset)
+{
+  if (reset) reset();
+  op();
+
+  int calls = 0;
+  double elapsed = 0.0;
+  while (elapsed < 0.25)
+  {
+    if (reset) reset();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    op();
+    elapsed += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    calls++;
+  }
+  return elapsed / calls;
+}
+
+///////////////////////////////////////////////////////////////////////
+// time one op and file away the result, where fieldsMoved is how many
+// fields worth of bytes the op reads and writes
+///////////////////////////////////////////////////////////////////////
+void record(const char* field, const char* op, int res, int cellBytes, int fieldsMoved,
+            const function<void()>& call, const function<void()>& reset = function<void()>())
+{
+  double seconds;
+  {
+    QUIET quiet;
+    seconds = timeOp(call, reset);
+  }
+  const double cells = (double)res * res;
+
+  RESULT result;
+  result.field = field;
+  result.op = op;
+  result.res = res;
+  result.nsPerCell = seconds * 1e9 / cells;
+  result.gbPerSecond = (double)fieldsMoved * cellBytes * cells / (seconds * 1e9);
+  results.push_back(result);
+
+  printf("%16s %14s %8i %10.3f %8.2f\n", field, op, res, result.nsPerCell, result.gbPerSecond);
+  fflush(stdout);
+}
+
+///////////////////////////////////////////////////////////////////////
+// the bits that differ between the two field types
+///////////////////////////////////////////////////////////////////////
+inline int cellBytes(const FIELD_2D& field) { return sizeof(float); }
+inline int cellBytes(const COLOR_FIELD_2D& field) { return sizeof(VEC3F); }
+inline float firstChannel(float value) { return value; }
+inline float firstChannel(const VEC3F& value) { return value[0]; }
+
+///////////////////////////////////////////////////////////////////////
+// something smooth, positive and away from zero, so log() and
+// division behave
+///////////////////////////////////////////////////////////////////////
+void fill(FIELD_2D& field)
+{
+  for (int y = 0; y < field.yRes(); y++)
+    for (int x = 0; x < field.xRes(); x++)
+      field(x, y) = 1.5f + 0.5f * sin(x * 0.01) * cos(y * 0.02);
+}
+
+void fill(COLOR_FIELD_2D& field)
+{
+  for (int y = 0; y < field.yRes(); y++)
+    for (int x = 0; x < field.xRes(); x++)
+    {
+      const float value = 1.5f + 0.5f * sin(x * 0.01) * cos(y * 0.02);
+      field(x, y) = VEC3F(value, 2.0f - value, value * 0.5f + 0.5f);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////
+// every op, on one field type
+///////////////////////////////////////////////////////////////////////
+template <class FIELD>
+void benchmark(const char* name, int res)
+{
+  FIELD A(res, res), B(res, res), C(res, res);
+  const int bytes = cellBytes(A);
+  fill(A);
+  fill(B);
+  FIELD original = A;
+
+  const function<void()> restore = [&]() { A = original; };
+
+  record(name, "clear", res, bytes, 1, [&]() { C.clear(); });
+  record(name, "= scalar", res, bytes, 1, [&]() { C = 0.5f; });
+  record(name, "= field", res, bytes, 2, [&]() { C = A; });
+  record(name, "*= scalar", res, bytes, 2, [&]() { A *= 1.0f; });
+  record(name, "/= scalar", res, bytes, 2, [&]() { A /= 1.0f; });
+  record(name, "+= scalar", res, bytes, 2, [&]() { A += 0.0f; });
+  record(name, "+= field", res, bytes, 3, [&]() { C += B; }, [&]() { C = A; });
+  record(name, "-= field", res, bytes, 3, [&]() { C -= B; }, [&]() { C = A; });
+  record(name, "*= field", res, bytes, 3, [&]() { C *= B; }, [&]() { C = A; });
+  record(name, "/= field", res, bytes, 3, [&]() { C /= B; }, [&]() { C = A; });
+  record(name, "= A * s + B", res, bytes, 3, [&]() { C = A * 0.5f + B; });
+  record(name, "abs", res, bytes, 2, [&]() { A.abs(); });
+  record(name, "log", res, bytes, 2, [&]() { A.log(); }, restore);
+  record(name, "normalize", res, bytes, 3, [&]() { A.normalize(); }, restore);
+  record(name, "min", res, bytes, 1, [&]() { sink = firstChannel(A.min()); });
+  record(name, "max", res, bytes, 1, [&]() { sink = firstChannel(A.max()); });
+  record(name, "sum", res, bytes, 1, [&]() { sink = firstChannel(A.sum()); });
+
+  decltype(A.sum()) minFound, maxFound, total;
+  record(name, "minMaxSum", res, bytes, 1, [&]() {
+    A.minMaxSum(minFound, maxFound, total);
+    sink = firstChannel(total);
+  });
+
+  restore();
+  record(name, "writePNG", res, bytes, 1, [&]() { A.writePNG(FIELD_OPS_PNG); });
+  record(name, "readPNG", res, bytes, 1, [&]() { C.readPNG(FIELD_OPS_PNG); });
+  remove(FIELD_OPS_PNG);
+
+  record(name, "writeSnapshot", res, bytes, 1, [&]() { FIELD_2D_SNAPSHOT::writeField(FIELD_OPS_SNAPSHOT, A); });
+  record(name, "readSnapshot", res, bytes, 1, [&]() { FIELD_2D_SNAPSHOT::readField(FIELD_OPS_SNAPSHOT, C); });
+  remove(FIELD_OPS_SNAPSHOT);
+}
+
+///////////////////////////////////////////////////////////////////////
+// one result per line, in the order they ran
+///////////////////////////////////////////////////////////////////////
+void writeJSON(const char* filename)
+{
+  FILE* file = fopen(filename, "w");
+  if (file == NULL)
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " Could not open file " << filename << endl;
+    exit(0);
+  }
+
+  fprintf(file, "{\n");
+  fprintf(file, "  \"benchmark\": \"fieldOps\",\n");
+  fprintf(file, "  \"threads\": %i,\n", THREAD_POOL::shared().threads());
+  fprintf(file, "  \"results\": [\n");
+  for (unsigned int x = 0; x < results.size(); x++)
+  {
+    const RESULT& result = results[x];
+    fprintf(file, "    {\"field\": \"%s\", \"op\": \"%s\", \"res\": %i, \"ns_per_cell\": %.4f, \"gb_per_s\": %.3f}%s\n",
+            result.field.c_str(), result.op.c_str(), result.res, result.nsPerCell, result.gbPerSecond,
+            (x + 1 < results.size()) ? "," : "");
+  }
+  fprintf(file, "  ]\n");
+  fprintf(file, "}\n");
+  fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int largest = (argc > 1) ? atoi(argv[1]) : 8192;
+
+  printf("%i threads\n", THREAD_POOL::shared().threads());
+  printf("%16s %14s %8s %10s %8s\n", "field", "op", "res", "ns/cell", "GB/s");
+  for (int res = 128; res <= largest; res *= 2)
+  {
+    benchmark<FIELD_2D>("FIELD_2D", res);
+    benchmark<COLOR_FIELD_2D>("COLOR_FIELD_2D", res);
+  }
+
+  if (argc > 2)
+    writeJSON(argv[2]);
+
+  return 0;
+}
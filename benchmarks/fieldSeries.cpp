@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////
+// Compares archiving a run as PNGs against FIELD_2D_SERIES files
+//
+// To run:
+//
+//   ./fieldSeries [resolution] [frames]
+//
+// Steps a Gray-Scott reaction-diffusion at the given resolution (256
+// by default), keeping every 10th step until it has 100 frames (or
+// however many were asked for), and then writes them all out as PNGs,
+// and as series files at full precision and with the mantissa cut
+// down. Simulating happens up front, so only the writing is timed.
+// The series files also get read back, in order and at random. PNGs
+// only keep 8 bits a cell, so their size isn't like for like, but the
+// write speed is.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "FIELD_2D_SERIES.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace std;
+
+// scratch files
+#define FIELD_SERIES_PNG "fieldSeries.png"
+#define FIELD_SERIES_FILE "fieldSeries.series"
+
+// the steps between frames
+#define FIELD_SERIES_EVERY 10
+
+///////////////////////////////////////////////////////////////////////
+// the IO calls chat on cout
+///////////////////////////////////////////////////////////////////////
+class QUIET {
+public:
+  QUIET() : _buffer(cout.rdbuf(NULL)) {};
+  ~QUIET() { cout.rdbuf(_buffer); cout.clear(); };
+private:
+  streambuf* _buffer;
+};
+
+double seconds(const chrono::steady_clock::time_point& start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+double fileBytes(const char* filename)
+{
+  struct stat status;
+  return (stat(filename, &status) == 0) ? (double)status.st_size : 0.0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// one Gray-Scott step, wrapping around the edges
+///////////////////////////////////////////////////////////////////////
+void grayScott(FIELD_2D& A, FIELD_2D& B, FIELD_2D& nextA, FIELD_2D& nextB)
+{
+  const int xRes = A.xRes();
+  const int yRes = A.yRes();
+  const float F = 0.037f, K = 0.06f, dA = 0.2f, dB = 0.1f;
+  for (int y = 0; y < yRes; y++)
+    for (int x = 0; x < xRes; x++)
+    {
+      const int xp = (x + 1) % xRes, xm = (x + xRes - 1) % xRes;
+      const int yp = (y + 1) % yRes, ym = (y + yRes - 1) % yRes;
+      const float a = A(x, y), b = B(x, y);
+      const float lapA = A(xp, y) + A(xm, y) + A(x, yp) + A(x, ym) - 4 * a;
+      const float lapB = B(xp, y) + B(xm, y) + B(x, yp) + B(x, ym) - 4 * b;
+      nextA(x, y) = a + dA * lapA - a * b * b + F * (1 - a);
+      nextB(x, y) = b + dB * lapB + a * b * b - (K + F) * b;
+    }
+  A.swap(nextA);
+  B.swap(nextB);
+}
+
+///////////////////////////////////////////////////////////////////////
+// write every frame to a series, read it back, print a line of stats
+///////////////////////////////////////////////////////////////////////
+void timeSeries(const vector<FIELD_2D>& frames, int mantissaBits, double rawBytes)
+{
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  {
+    FIELD_2D_SERIES_WRITER series(FIELD_SERIES_FILE, 32, mantissaBits);
+    for (unsigned int x = 0; x < frames.size(); x++)
+      series.append(frames[x], x * FIELD_SERIES_EVERY);
+  }
+  const double writeSeconds = seconds(start);
+  const double bytes = fileBytes(FIELD_SERIES_FILE);
+
+  FIELD_2D_SERIES_READER series(FIELD_SERIES_FILE);
+  FIELD_2D frame;
+  start = chrono::steady_clock::now();
+  for (int x = 0; x < series.totalFrames(); x++)
+    series.read(x, frame);
+  const double readSeconds = seconds(start);
+
+  srand(123);
+  start = chrono::steady_clock::now();
+  for (int x = 0; x < series.totalFrames(); x++)
+    series.read(rand() % series.totalFrames(), frame);
+  const double randomSeconds = seconds(start);
+
+  char name[64];
+  snprintf(name, sizeof(name), "series, %i bit", mantissaBits);
+  printf("%18s %10.2f %8.2f %10.1f %10.1f %10.2f\n", name, bytes / 1e6, rawBytes / bytes,
+         rawBytes / writeSeconds / 1e6, rawBytes / readSeconds / 1e6,
+         1000.0 * randomSeconds / series.totalFrames());
+  remove(FIELD_SERIES_FILE);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  const int res = (argc > 1) ? atoi(argv[1]) : 256;
+  const int totalFrames = (argc > 2) ? atoi(argv[2]) : 100;
+
+  // a square of B in the middle of all A
+  FIELD_2D A(res, res), B(res, res), nextA(res, res), nextB(res, res);
+  A = 1.0f;
+  for (int y = res / 2 - res / 16; y < res / 2 + res / 16; y++)
+    for (int x = res / 2 - res / 16; x < res / 2 + res / 16; x++)
+      B(x, y) = 1.0f;
+
+  vector<FIELD_2D> frames;
+  for (int step = 0; (int)frames.size() < totalFrames; step++)
+  {
+    if (step % FIELD_SERIES_EVERY == 0)
+      frames.push_back(B);
+    grayScott(A, B, nextA, nextB);
+  }
+  const double rawBytes = (double)res * res * sizeof(float) * totalFrames;
+
+  printf("%i frames at %i x %i, %.2f MB of floats\n", totalFrames, res, res, rawBytes / 1e6);
+  printf("%18s %10s %8s %10s %10s %10s\n", "format", "MB", "ratio", "write MB/s", "read MB/s", "ms/seek");
+
+  // one PNG per frame, where each frame is a fresh file
+  double pngBytes = 0.0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (unsigned int x = 0; x < frames.size(); x++)
+  {
+    {
+      QUIET quiet;
+      frames[x].writePNG(FIELD_SERIES_PNG);
+    }
+    pngBytes += fileBytes(FIELD_SERIES_PNG);
+  }
+  const double pngSeconds = seconds(start);
+  remove(FIELD_SERIES_PNG);
+  printf("%18s %10.2f %8.2f %10.1f %10s %10s\n", "png, 8 bit", pngBytes / 1e6, rawBytes / pngBytes,
+         rawBytes / pngSeconds / 1e6, "-", "-");
+
+  timeSeries(frames, 23, rawBytes);
+  timeSeries(frames, 16, rawBytes);
+  timeSeries(frames, 10, rawBytes);
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////
+// Times HashLife against the packed LIFE_2D engine on the patterns
+// gameOfLife seeds
+//
+// To run:
+//
+//   ./hashLife [exponent]
+//
+// Runs a Gosper glider gun and an acorn for 2048 generations on a
+// 2048 x 2048 LIFE_2D, which is big enough that neither wraps around,
+// and then the same with one HASHLIFE step, and checks that the
+// populations agree. Then HashLife keeps going, a frame at a time, at
+// 2^20 generations per frame until it reaches 2^exponent generations
+// (2^30 by default).
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "HASHLIFE.h"
+#include "LIFE_2D.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+static const char* gosperGun[] = {
+  "........................O...........",
+  "......................O.O...........",
+  "............OO......OO............OO",
+  "...........O...O....OO............OO",
+  "OO........O.....O...OO..............",
+  "OO........O...O.OO....O.O...........",
+  "..........O.....O.......O...........",
+  "...........O...O....................",
+  "............OO......................",
+  NULL
+};
+
+static const char* acorn[] = {
+  ".O.....",
+  "...O...",
+  "OO..OOO",
+  NULL
+};
+
+double seconds(const chrono::steady_clock::time_point& start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+///////////////////////////////////////////////////////////////////////
+// stamp a pattern into the field at (x, y)
+///////////////////////////////////////////////////////////////////////
+void stamp(const char** pattern, FIELD_2D& field, int x, int y)
+{
+  for (int row = 0; pattern[row] != NULL; row++)
+    for (int column = 0; pattern[row][column] != '\0'; column++)
+      field(x + column, y + row) = (pattern[row][column] == 'O') ? 1.0f : 0.0f;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void timePattern(const char* name, const char** pattern, int exponent)
+{
+  const int res = 2048;
+  const int generations = 2048;
+  FIELD_2D start(res, res);
+  stamp(pattern, start, res / 2, res / 2);
+
+  LIFE_2D life;
+  FIELD_2D_CONVERT(start, life);
+  chrono::steady_clock::time_point clock = chrono::steady_clock::now();
+  for (int x = 0; x < generations; x++)
+    life.step();
+  const double packedSeconds = seconds(clock);
+
+  HASHLIFE hashlife;
+  hashlife.setCells(start);
+  clock = chrono::steady_clock::now();
+  hashlife.step(11);
+  const double hashSeconds = seconds(clock);
+
+  printf("%s\n", name);
+  printf("  %8i generations   packed %9.3f s   hashlife %9.4f s   %8.1fx   population %ld / %.0f\n",
+         generations, packedSeconds, hashSeconds, packedSeconds / hashSeconds,
+         life.population(), hashlife.population());
+
+  // then as far as it'll go, a million generations a frame
+  clock = chrono::steady_clock::now();
+  double slowest = 0.0;
+  while (hashlife.generation() < ((uint64_t)1 << exponent))
+  {
+    chrono::steady_clock::time_point frame = chrono::steady_clock::now();
+    hashlife.step(20);
+    const double frameSeconds = seconds(frame);
+    slowest = (frameSeconds > slowest) ? frameSeconds : slowest;
+  }
+  printf("  2^%-2i generations   hashlife %9.3f s, slowest frame %.2f ms, %i nodes, population %.0f\n",
+         exponent, seconds(clock), 1000.0 * slowest, hashlife.totalNodes(), hashlife.population());
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  const int exponent = (argc > 1) ? atoi(argv[1]) : 30;
+
+  timePattern("Gosper glider gun", gosperGun, exponent);
+  timePattern("acorn", acorn, exponent);
+
+  return 0;
+}
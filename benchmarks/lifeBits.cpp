@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////
+// Times a Game of Life soup on floats, on bytes, and packed 64 cells
+// to a word in LIFE_2D
+//
+// To run:
+//
+//   ./lifeBits [resolution] [generations]
+//
+// Fills a square board (2048 by default) a third full at random, and
+// times the given number of generations (100 by default) of each
+// engine from the same start. The float and byte engines count
+// neighbors a cell at a time and wrap with modulos, the way
+// gameOfLife used to. All three should finish with the same
+// population, and it gets printed to check.
+//
+// Then the same sixteen pulsars gameOfLife starts with get put on
+// boards from 256 up to 8192 on a side. LIFE_2D only steps the tiles
+// around them, so the time per generation should hardly move as the
+// board grows, next to stepping every tile, which grows with the area.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "FIELD_2D_TYPED.h"
+#include "LIFE_2D.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+double seconds(const chrono::steady_clock::time_point& start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+///////////////////////////////////////////////////////////////////////
+// one generation a cell at a time, on whatever the cells are stored as
+///////////////////////////////////////////////////////////////////////
+template <class FIELD>
+void stepCells(const FIELD& cells, FIELD& next)
+{
+  const int xRes = cells.xRes();
+  const int yRes = cells.yRes();
+  for (int y = 0; y < yRes; y++)
+  {
+    const int yUp = (y + 1) % yRes;
+    const int yDown = (y + yRes - 1) % yRes;
+    for (int x = 0; x < xRes; x++)
+    {
+      const int xRight = (x + 1) % xRes;
+      const int xLeft = (x + xRes - 1) % xRes;
+
+      const int neighbors = cells(xLeft, yUp) + cells(x, yUp) + cells(xRight, yUp) +
+                            cells(xLeft, y) + cells(xRight, y) +
+                            cells(xLeft, yDown) + cells(x, yDown) + cells(xRight, yDown);
+      next(x, y) = (neighbors == 3 || (neighbors == 2 && cells(x, y) == 1)) ? 1 : 0;
+    }
+  }
+}
+
+// a FIELD_2D to a FIELD_2D, so the float engine looks like the others
+void FIELD_2D_CONVERT(const FIELD_2D& input, FIELD_2D& output) { output = input; }
+
+///////////////////////////////////////////////////////////////////////
+// the period 3 oscillator, centered on (x, y)
+///////////////////////////////////////////////////////////////////////
+void pulsar(LIFE_2D& life, int x, int y)
+{
+  static const int offsets[] = { 2, 3, 4 };
+  for (int a = 0; a < 3; a++)
+    for (int xSign = -1; xSign <= 1; xSign += 2)
+      for (int ySign = -1; ySign <= 1; ySign += 2)
+      {
+        life.set(x + xSign * offsets[a], y + ySign * 6, true);
+        life.set(x + xSign * offsets[a], y + ySign * 1, true);
+        life.set(x + xSign * 6, y + ySign * offsets[a], true);
+        life.set(x + xSign * 1, y + ySign * offsets[a], true);
+      }
+}
+
+///////////////////////////////////////////////////////////////////////
+// seconds to take all the generations, starting from soup
+///////////////////////////////////////////////////////////////////////
+template <class FIELD>
+double timeCells(const FIELD_2D& soup, int generations, long& population)
+{
+  FIELD cells, next(soup.xRes(), soup.yRes());
+  FIELD_2D_CONVERT(soup, cells);
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (int x = 0; x < generations; x++)
+  {
+    stepCells(cells, next);
+    cells.swap(next);
+  }
+  const double elapsed = seconds(start);
+
+  FIELD_2D final;
+  FIELD_2D_CONVERT(cells, final);
+  population = (long)final.sum();
+  return elapsed;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  const int res = (argc > 1) ? atoi(argv[1]) : 2048;
+  const int generations = (argc > 2) ? atoi(argv[2]) : 100;
+
+  FIELD_2D soup(res, res);
+  srand(123);
+  for (int y = 0; y < res; y++)
+    for (int x = 0; x < res; x++)
+      soup(x, y) = (rand() % 3 == 0) ? 1.0f : 0.0f;
+
+  const double cells = (double)res * res * generations;
+  printf("%i generations at %i x %i, %i threads\n", generations, res, res, THREAD_POOL::shared().threads());
+  printf("%12s %10s %12s %10s %12s\n", "engine", "seconds", "Mcells/sec", "speedup", "population");
+
+  long population;
+  const double floatSeconds = timeCells<FIELD_2D>(soup, generations, population);
+  printf("%12s %10.3f %12.1f %10.1f %12li\n", "float", floatSeconds, cells / floatSeconds / 1e6, 1.0, population);
+
+  const double byteSeconds = timeCells<BYTE_FIELD_2D>(soup, generations, population);
+  printf("%12s %10.3f %12.1f %10.1f %12li\n", "byte", byteSeconds, cells / byteSeconds / 1e6,
+         floatSeconds / byteSeconds, population);
+
+  LIFE_2D life;
+  FIELD_2D_CONVERT(soup, life);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (int x = 0; x < generations; x++)
+    life.step();
+  const double bitSeconds = seconds(start);
+  printf("%12s %10.3f %12.1f %10.1f %12li\n", "packed", bitSeconds, cells / bitSeconds / 1e6,
+         floatSeconds / bitSeconds, life.population());
+
+  // the pulsar field from gameOfLife, on bigger and bigger boards
+  printf("\npulsar field, %i generations\n", generations);
+  printf("%12s %12s %14s %14s %12s\n", "resolution", "tiles", "active tiles", "us/gen", "every tile");
+  for (int side = 256; side <= 8192; side *= 2)
+  {
+    LIFE_2D sparse(side, side);
+    for (int x = 0; x < 8; x++)
+    {
+      pulsar(sparse, 15 + 10 * x, 15 + 10 * x);
+      pulsar(sparse, 15 + 10 * x, 85 - 10 * x);
+    }
+    sparse.step();
+
+    start = chrono::steady_clock::now();
+    for (int x = 0; x < generations; x++)
+      sparse.step();
+    const double sparseSeconds = seconds(start);
+    const int active = sparse.activeTiles();
+
+    // waking every tile steps the whole board, like before tiles
+    start = chrono::steady_clock::now();
+    for (int x = 0; x < generations; x++)
+    {
+      sparse.wake();
+      sparse.step();
+    }
+    const double denseSeconds = seconds(start);
+
+    printf("%12i %12i %14i %14.1f %12.1f\n", side, sparse.xTiles() * sparse.yTiles(), active,
+           1e6 * sparseSeconds / generations, 1e6 * denseSeconds / generations);
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////
+// Times LIFE_RULE's summed-area tables against counting every cell in
+// the box, for Larger-than-Life rules of growing radius
+//
+// To run:
+//
+//   ./lifeRule [resolution] [generations]
+//
+// Fills a square board (512 by default) half full at random and steps
+// it the given number of generations (10 by default) for radii from 1
+// to 32. The rule at each radius keeps the same proportions as Bosco's
+// rule, R5,C0,M1,S34..58,B34..45. Counting the box by hand costs
+// (2R+1)^2 a cell, the summed-area table a flat four lookups (radius
+// 1 just adds up the 3x3 block), and both should finish with the same
+// population.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D_TYPED.h"
+#include "LIFE_RULE.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+double seconds(const chrono::steady_clock::time_point& start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+long population(const BYTE_FIELD_2D& cells)
+{
+  long total = 0;
+  for (int y = 0; y < cells.yRes(); y++)
+    for (int x = 0; x < cells.xRes(); x++)
+      total += cells(x, y) != 0;
+  return total;
+}
+
+///////////////////////////////////////////////////////////////////////
+// one generation, adding up the whole box around every cell
+///////////////////////////////////////////////////////////////////////
+void stepCounting(const LIFE_RULE& rule, const BYTE_FIELD_2D& cells, BYTE_FIELD_2D& next)
+{
+  const int xRes = cells.xRes();
+  const int yRes = cells.yRes();
+  const int r = rule.radius();
+  for (int y = 0; y < yRes; y++)
+    for (int x = 0; x < xRes; x++)
+    {
+      int count = 0;
+      for (int dy = -r; dy <= r; dy++)
+      {
+        const unsigned char* row = cells.row(((y + dy) % yRes + yRes) % yRes);
+        for (int dx = -r; dx <= r; dx++)
+          count += row[((x + dx) % xRes + xRes) % xRes] != 0;
+      }
+      next(x, y) = rule.next(cells(x, y) != 0, count);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  const int res = (argc > 1) ? atoi(argv[1]) : 512;
+  const int generations = (argc > 2) ? atoi(argv[2]) : 10;
+
+  BYTE_FIELD_2D soup(res, res);
+  srand(123);
+  for (int y = 0; y < res; y++)
+    for (int x = 0; x < res; x++)
+      soup(x, y) = rand() % 2;
+
+  printf("%i generations at %i x %i, %i threads\n", generations, res, res, THREAD_POOL::shared().threads());
+  printf("%8s %12s %14s %14s %10s %12s\n", "radius", "box", "counting ns", "summed ns", "speedup", "population");
+
+  const double cells = (double)res * res * generations;
+  for (int radius = 1; radius <= 32; radius *= 2)
+  {
+    // Bosco's rule, scaled from a box of 121 to this one
+    const double box = (2 * radius + 1) * (2 * radius + 1);
+    char rulestring[128];
+    snprintf(rulestring, sizeof(rulestring), "R%i,C0,M1,S%i..%i,B%i..%i,NM", radius,
+             (int)(34 * box / 121), (int)(58 * box / 121), (int)(34 * box / 121), (int)(45 * box / 121));
+    LIFE_RULE rule(rulestring);
+
+    BYTE_FIELD_2D counted(soup), next;
+    next.resizeAndWipe(res, res);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int x = 0; x < generations; x++)
+    {
+      stepCounting(rule, counted, next);
+      counted.swap(next);
+    }
+    const double countingSeconds = seconds(start);
+
+    BYTE_FIELD_2D summed(soup);
+    start = chrono::steady_clock::now();
+    for (int x = 0; x < generations; x++)
+    {
+      rule.step(summed, next);
+      summed.swap(next);
+    }
+    const double summedSeconds = seconds(start);
+
+    const long countedPopulation = population(counted);
+    const long summedPopulation = population(summed);
+    printf("%8i %12i %14.2f %14.2f %10.1f %5li / %-5li\n", radius, (int)box,
+           1e9 * countingSeconds / cells, 1e9 * summedSeconds / cells,
+           countingSeconds / summedSeconds, countedPopulation, summedPopulation);
+  }
+
+  return 0;
+}
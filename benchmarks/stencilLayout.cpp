@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////
+// Times the Laplacian stencils over each FIELD_2D storage layout, and
+// explicit steps with and without temporal blocking
+//
+// To run:
+//
+//   ./stencilLayout [largest resolution]
+//
+// For every square resolution from 1024 up to 8192 (or whatever was
+// passed in), each layout gets a few warm up steps and is then timed
+// for about half a second. Bandwidth counts one read of the input and
+// one write of the output per cell, which is what a stencil that runs
+// out of cache has to move at a minimum, so blocked steps can show
+// more than the memory system actually delivers.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "FIELD_2D_STENCIL.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+enum { DENSE, PADDED, TILED, MORTON, TOTAL_LAYOUTS };
+static const char* layoutNames[TOTAL_LAYOUTS] = {"row-major", "padded", "tiled", "morton"};
+
+///////////////////////////////////////////////////////////////////////
+// build a field of the given layout, filled with something smooth
+///////////////////////////////////////////////////////////////////////
+FIELD_2D makeField(int res, int layout)
+{
+  FIELD_2D field;
+  if (layout == DENSE)
+    field = FIELD_2D(res, res);
+  else if (layout == PADDED)
+    field = FIELD_2D(res, res, FIELD_2D::paddedPitch(res));
+  else if (layout == TILED)
+    field = FIELD_2D(res, res, FIELD_2D_TILED);
+  else
+    field = FIELD_2D(res, res, FIELD_2D_MORTON);
+
+  for (int y = 0; y < res; y++)
+    for (int x = 0; x < res; x++)
+      field(x, y) = sin(x * 0.01) * cos(y * 0.02);
+  return field;
+}
+
+///////////////////////////////////////////////////////////////////////
+// milliseconds per step for STENCIL over one layout
+///////////////////////////////////////////////////////////////////////
+template <class STENCIL>
+double timeStencil(int res, int layout)
+{
+  FIELD_2D input = makeField(res, layout);
+  FIELD_2D output = makeField(res, layout);
+
+  for (int x = 0; x < 3; x++)
+    FIELD_2D_STENCIL<STENCIL>::apply(input, output);
+
+  int steps = 0;
+  double elapsed = 0.0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  while (elapsed < 500.0)
+  {
+    FIELD_2D_STENCIL<STENCIL>::apply(input, output);
+    steps++;
+    elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+  return elapsed / steps;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class STENCIL>
+void benchmark(const char* name, int largest)
+{
+  printf("%s\n", name);
+  printf("%8s %10s %10s %8s\n", "res", "layout", "ms/step", "GB/s");
+  for (int res = 1024; res <= largest; res *= 2)
+    for (int layout = 0; layout < TOTAL_LAYOUTS; layout++)
+    {
+      double ms = timeStencil<STENCIL>(res, layout);
+      double bytes = 2.0 * res * res * sizeof(float);
+      printf("%8i %10s %10.3f %8.2f\n", res, layoutNames[layout], ms, bytes / (ms * 1e6));
+    }
+  printf("\n");
+}
+
+///////////////////////////////////////////////////////////////////////
+// milliseconds per explicit step, depth steps per pass over memory
+///////////////////////////////////////////////////////////////////////
+double timeSteps(int res, int depth)
+{
+  FIELD_2D field = makeField(res, DENSE);
+  FIELD_2D scratch(res, res);
+  const int steps = 32;
+
+  FIELD_2D_STENCIL<FIELD_2D_LAPLACIAN_5>::steps(field, scratch, 0.1, depth, depth);
+
+  int passes = 0;
+  double elapsed = 0.0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  while (elapsed < 500.0)
+  {
+    FIELD_2D_STENCIL<FIELD_2D_LAPLACIAN_5>::steps(field, scratch, 0.1, steps, depth);
+    passes++;
+    elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+  return elapsed / (passes * steps);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void benchmarkSteps(int largest)
+{
+  printf("LAPLACIAN_5 steps(), row-major\n");
+  printf("%8s %10s %10s %8s\n", "res", "depth", "ms/step", "GB/s");
+  for (int res = 1024; res <= largest; res *= 2)
+    for (int depth = 1; depth <= 16; depth *= 2)
+    {
+      double ms = timeSteps(res, depth);
+      double bytes = 2.0 * res * res * sizeof(float);
+      printf("%8i %10i %10.3f %8.2f\n", res, depth, ms, bytes / (ms * 1e6));
+    }
+  printf("\n");
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int largest = (argc > 1) ? atoi(argv[1]) : 8192;
+
+  benchmark<FIELD_2D_LAPLACIAN_5>("LAPLACIAN_5", largest);
+  benchmark<FIELD_2D_LAPLACIAN_4TH>("LAPLACIAN_4TH", largest);
+  benchmarkSteps(largest);
+
+  return 0;
+}
@@ -0,0 +1,444 @@
+#ifndef FIELD_2D_SNAPSHOT_H
+#define FIELD_2D_SNAPSHOT_H
+
+///////////////////////////////////////////////////////////////////////
+// A native binary format for FIELD_2D and COLOR_FIELD_2D, where the
+// cells on disk are exactly the floats in memory, so a file can be
+// mapped in and used as a field without reading or converting it.
+//
+// A snapshot holds any number of named fields, plus the step and time
+// they were taken at:
+//
+//   FIELD_2D_SNAPSHOT snapshot;
+//   snapshot.add("A", A);
+//   snapshot.add("B", B);
+//   snapshot.setStep(step, time);
+//   snapshot.write("state.snap");
+//
+// Reading it back either copies into an existing field, whatever its
+// layout, or maps it and hands back a view straight into the file:
+//
+//   FIELD_2D_SNAPSHOT snapshot("state.snap");
+//   snapshot.read("A", A);
+//   FIELD_2D_MAPPED<FIELD_2D> B = snapshot.field<FIELD_2D>("B");
+//
+// The mapping is private, so writing to B is fine but never touches
+// the file, and B has to go before the snapshot does. For just the one
+// field, FIELD_2D_SNAPSHOT::writeField() and readField() do the lot.
+//
+// Every field is a page sized header followed by its cells, dense and
+// row by row from y = 0, padded out to the next page so the next
+// header and its cells start on a page too. Everything is
+// little-endian, the header fields are below. FIELD_2D::write() and
+// read() still do the old format of two ints and a double per cell.
+///////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// every header and every field's cells start on one of these
+#define FIELD_2D_SNAPSHOT_PAGE 4096
+
+// bump when the header changes
+#define FIELD_2D_SNAPSHOT_VERSION 1
+
+struct FIELD_2D_SNAPSHOT_HEADER {
+  char magic[8];      // "FIELD2D" and a NUL
+  uint32_t version;   // FIELD_2D_SNAPSHOT_VERSION
+  uint32_t channels;  // floats per cell, 1 for FIELD_2D, 3 for COLOR_FIELD_2D
+  uint32_t xRes;
+  uint32_t yRes;
+  uint64_t cellBytes; // xRes * yRes * channels * 4, before the padding
+  uint64_t step;      // whatever the simulation counts in
+  double time;
+  char name[64];      // NUL terminated
+};
+
+///////////////////////////////////////////////////////////////////////
+// a field wrapped around mapped storage, the same way FIELD_2D_VIEW
+// wraps another field's
+///////////////////////////////////////////////////////////////////////
+template <class FIELD>
+class FIELD_2D_MAPPED : public FIELD {
+public:
+  // float for FIELD_2D, VEC3F for COLOR_FIELD_2D
+  typedef typename std::remove_reference<decltype(std::declval<FIELD&>()(0, 0))>::type CELL;
+
+  FIELD_2D_MAPPED(CELL* cells, int xRes, int yRes) :
+    FIELD(cells, xRes, yRes, xRes) {};
+  FIELD_2D_MAPPED(const FIELD_2D_MAPPED& mapped) :
+    FIELD(const_cast<CELL*>(mapped.data()), mapped.xRes(), mapped.yRes(), mapped.pitch()) {};
+
+  using FIELD::operator=;
+  FIELD_2D_MAPPED& operator=(const FIELD_2D_MAPPED& mapped)
+  {
+    FIELD::operator=(mapped);
+    return *this;
+  };
+};
+
+class FIELD_2D_SNAPSHOT {
+public:
+  FIELD_2D_SNAPSHOT() :
+    _step(0), _time(0.0), _map(NULL), _mapBytes(0) {};
+
+  // map an existing snapshot
+  FIELD_2D_SNAPSHOT(const std::string& filename) :
+    _step(0), _time(0.0), _map(NULL), _mapBytes(0)
+  {
+    map(filename);
+  };
+
+  ~FIELD_2D_SNAPSHOT() { unmap(); };
+
+  // the fields handed out point into the mapping, so no copies
+  FIELD_2D_SNAPSHOT(const FIELD_2D_SNAPSHOT&) = delete;
+  FIELD_2D_SNAPSHOT& operator=(const FIELD_2D_SNAPSHOT&) = delete;
+
+  // when the snapshot was taken
+  const uint64_t step() const { return _step; };
+  const double time() const { return _time; };
+  void setStep(uint64_t step, double time = 0.0) { _step = step; _time = time; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // queue field up for write(), which it has to outlive
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void add(const std::string& name, const FIELD& field)
+  {
+    FIELD_2D_SNAPSHOT_HEADER header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "FIELD2D", 8);
+    header.version = FIELD_2D_SNAPSHOT_VERSION;
+    header.channels = channels<FIELD>();
+    header.xRes = field.xRes();
+    header.yRes = field.yRes();
+    header.cellBytes = (uint64_t)header.xRes * header.yRes * header.channels * sizeof(float);
+
+    assert(name.size() < sizeof(header.name));
+    strncpy(header.name, name.c_str(), sizeof(header.name) - 1);
+
+    _writes.push_back(std::make_pair(header, [&field](FILE* file) { writeCells(file, field); }));
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // write out everything add()ed. It goes to a temporary file first
+  // and gets renamed over filename at the end, so a crash part way
+  // through never leaves a broken snapshot behind.
+  ////////////////////////////////////////////////////////////////////////
+  void write(const std::string& filename)
+  {
+    checkByteOrder();
+    const std::string temporary = filename + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == NULL)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Could not open file " << temporary.c_str() << std::endl;
+      exit(0);
+    }
+
+    std::vector<char> page(FIELD_2D_SNAPSHOT_PAGE);
+    for (unsigned int x = 0; x < _writes.size(); x++)
+    {
+      FIELD_2D_SNAPSHOT_HEADER header = _writes[x].first;
+      header.step = _step;
+      header.time = _time;
+
+      memset(&page[0], 0, page.size());
+      memcpy(&page[0], &header, sizeof(header));
+      fwrite(&page[0], 1, page.size(), file);
+
+      _writes[x].second(file);
+      fwrite(&page[0], 1, padding(header.cellBytes), file);
+    }
+
+    const bool failed = ferror(file) || fflush(file) != 0;
+    fclose(file);
+    if (failed || rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Could not write snapshot " << filename.c_str() << std::endl;
+      exit(0);
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // map filename in and check it over. Nothing gets read until the
+  // cells are actually touched.
+  ////////////////////////////////////////////////////////////////////////
+  void map(const std::string& filename)
+  {
+    checkByteOrder();
+    unmap();
+
+    const int file = open(filename.c_str(), O_RDONLY);
+    struct stat status;
+    if (file < 0 || fstat(file, &status) != 0)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Could not open file " << filename.c_str() << std::endl;
+      exit(0);
+    }
+
+    // private, so writes to the fields stay in memory
+    _mapBytes = status.st_size;
+    _map = (_mapBytes > 0) ? mmap(NULL, _mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0) : NULL;
+    close(file);
+    if (_map == MAP_FAILED)
+    {
+      _map = NULL;
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Could not map file " << filename.c_str() << std::endl;
+      exit(0);
+    }
+
+    // walk the headers
+    size_t offset = 0;
+    while (offset < _mapBytes)
+    {
+      const FIELD_2D_SNAPSHOT_HEADER* header = (const FIELD_2D_SNAPSHOT_HEADER*)((char*)_map + offset);
+      const bool valid = offset + FIELD_2D_SNAPSHOT_PAGE <= _mapBytes &&
+                         memcmp(header->magic, "FIELD2D", 8) == 0 &&
+                         header->version == FIELD_2D_SNAPSHOT_VERSION &&
+                         header->cellBytes == (uint64_t)header->xRes * header->yRes * header->channels * sizeof(float) &&
+                         offset + FIELD_2D_SNAPSHOT_PAGE + header->cellBytes <= _mapBytes;
+      if (!valid)
+      {
+        std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+        std::cout << " " << filename.c_str() << " is not a version " << FIELD_2D_SNAPSHOT_VERSION
+                  << " snapshot, or it got cut short" << std::endl;
+        exit(0);
+      }
+
+      _headers.push_back(header);
+      _step = header->step;
+      _time = header->time;
+      offset += FIELD_2D_SNAPSHOT_PAGE + header->cellBytes + padding(header->cellBytes);
+    }
+  };
+
+  // the fields in a mapped snapshot
+  const int totalFields() const { return _headers.size(); };
+  const std::string name(int x) const { return _headers[x]->name; };
+  const bool has(const std::string& name) const { return find(name) != NULL; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // a field of the mapped snapshot, without copying it
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  FIELD_2D_MAPPED<FIELD> field(const std::string& name)
+  {
+    const FIELD_2D_SNAPSHOT_HEADER* header = find(name);
+    if (header == NULL || header->channels != channels<FIELD>())
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Snapshot has no " << channels<FIELD>() << " channel field called " << name.c_str() << std::endl;
+      exit(0);
+    }
+
+    typedef typename FIELD_2D_MAPPED<FIELD>::CELL CELL;
+    CELL* cells = (CELL*)((char*)header + FIELD_2D_SNAPSHOT_PAGE);
+    return FIELD_2D_MAPPED<FIELD>(cells, header->xRes, header->yRes);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // copy a field of the mapped snapshot into field, which keeps its
+  // layout if it's already the right size
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void read(const std::string& name, FIELD& field)
+  {
+    field = this->field<FIELD>(name);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // just the one field
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  static void writeField(const std::string& filename, const FIELD& field, uint64_t step = 0, double time = 0.0)
+  {
+    FIELD_2D_SNAPSHOT snapshot;
+    snapshot.add("field", field);
+    snapshot.setStep(step, time);
+    snapshot.write(filename);
+  };
+
+  template <class FIELD>
+  static void readField(const std::string& filename, FIELD& field)
+  {
+    FIELD_2D_SNAPSHOT snapshot(filename);
+    if (snapshot.totalFields() == 0)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Snapshot " << filename.c_str() << " is empty" << std::endl;
+      exit(0);
+    }
+    snapshot.read(snapshot.name(0), field);
+  };
+
+private:
+  uint64_t _step;
+  double _time;
+
+  // what add() queued up for write(), and how to write its cells
+  std::vector<std::pair<FIELD_2D_SNAPSHOT_HEADER, std::function<void(FILE*)> > > _writes;
+
+  // what map() found
+  void* _map;
+  size_t _mapBytes;
+  std::vector<const FIELD_2D_SNAPSHOT_HEADER*> _headers;
+
+  void unmap()
+  {
+    if (_map != NULL)
+      munmap(_map, _mapBytes);
+    _map = NULL;
+    _mapBytes = 0;
+    _headers.clear();
+  };
+
+  const FIELD_2D_SNAPSHOT_HEADER* find(const std::string& name) const
+  {
+    for (unsigned int x = 0; x < _headers.size(); x++)
+      if (name == _headers[x]->name)
+        return _headers[x];
+    return NULL;
+  };
+
+  template <class FIELD>
+  static uint32_t channels()
+  {
+    return sizeof(typename FIELD_2D_MAPPED<FIELD>::CELL) / sizeof(float);
+  };
+
+  // bytes to the next page
+  static size_t padding(uint64_t bytes)
+  {
+    return (FIELD_2D_SNAPSHOT_PAGE - bytes % FIELD_2D_SNAPSHOT_PAGE) % FIELD_2D_SNAPSHOT_PAGE;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the cells, dense, straight out of the rows where the layout has
+  // them, a row at a time through a buffer where it doesn't
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  static void writeCells(FILE* file, const FIELD& field)
+  {
+    typedef typename FIELD_2D_MAPPED<FIELD>::CELL CELL;
+    std::vector<CELL> buffer(field.rowMajor() ? 0 : field.xRes());
+    for (int y = 0; y < field.yRes(); y++)
+    {
+      if (field.rowMajor())
+      {
+        fwrite(field.row(y), sizeof(CELL), field.xRes(), file);
+        continue;
+      }
+      for (int x = 0; x < field.xRes(); x++)
+        buffer[x] = field(x, y);
+      fwrite(&buffer[0], sizeof(CELL), field.xRes(), file);
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the cells go to and from disk as they are, so this only works on
+  // little-endian machines, which is everything the viewers build on
+  ////////////////////////////////////////////////////////////////////////
+  static void checkByteOrder()
+  {
+    const uint32_t one = 1;
+    if (*(const char*)&one == 1)
+      return;
+    std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+    std::cout << " FIELD_2D_SNAPSHOT only supports little-endian machines" << std::endl;
+    exit(0);
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// Checkpoint and restart for long simulations: register everything
+// the simulation needs to pick up where it left off, then save every
+// so often, and restore on the next run:
+//
+//   FIELD_2D_CHECKPOINT checkpoint;
+//   checkpoint.add("A", A);
+//   checkpoint.add("B", B);
+//   int step = checkpoint.restore("run.snap");
+//   ...
+//   checkpoint.save("run.snap", step);
+//
+// Each save replaces the last one in a single rename, so there is
+// always one whole checkpoint on disk. HEADLESS.h does this for the
+// viewers with -checkpoint and -restart.
+///////////////////////////////////////////////////////////////////////
+class FIELD_2D_CHECKPOINT {
+public:
+  // field has to outlive the checkpoint
+  template <class FIELD>
+  void add(const std::string& name, FIELD& field)
+  {
+    _saves.push_back([name, &field](FIELD_2D_SNAPSHOT& snapshot) { snapshot.add(name, field); });
+    _restores.push_back([name, &field](FIELD_2D_SNAPSHOT& snapshot) { snapshot.read(name, field); });
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // state that isn't a field, like a packed board, goes through one:
+  // save() has toField fill it in first, and restore() hands what it
+  // read back to fromField
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void add(const std::string& name, void (*toField)(FIELD&), void (*fromField)(const FIELD&))
+  {
+    std::shared_ptr<FIELD> scratch(new FIELD());
+    _saves.push_back([name, toField, scratch](FIELD_2D_SNAPSHOT& snapshot) {
+      toField(*scratch);
+      snapshot.add(name, *scratch);
+    });
+    _restores.push_back([name, fromField, scratch](FIELD_2D_SNAPSHOT& snapshot) {
+      snapshot.read(name, *scratch);
+      fromField(*scratch);
+    });
+  };
+
+  const bool empty() const { return _saves.empty(); };
+
+  void save(const std::string& filename, uint64_t step, double time = 0.0)
+  {
+    FIELD_2D_SNAPSHOT snapshot;
+    for (unsigned int x = 0; x < _saves.size(); x++)
+      _saves[x](snapshot);
+    snapshot.setStep(step, time);
+    snapshot.write(filename);
+  };
+
+  // load every field back in, and return the step it was saved at
+  uint64_t restore(const std::string& filename, double* time = NULL)
+  {
+    FIELD_2D_SNAPSHOT snapshot(filename);
+    for (unsigned int x = 0; x < _restores.size(); x++)
+      _restores[x](snapshot);
+    if (time != NULL)
+      *time = snapshot.time();
+    return snapshot.step();
+  };
+
+private:
+  std::vector<std::function<void(FIELD_2D_SNAPSHOT&)> > _saves;
+  std::vector<std::function<void(FIELD_2D_SNAPSHOT&)> > _restores;
+};
+
+#endif
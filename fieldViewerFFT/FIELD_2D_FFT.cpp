@@ -53,7 +53,7 @@ void FIELD_2D_FFT::FFT(const FIELD_2D& m)
     for (int x = 0; x < _xRes; x++)
     {
       int index = x + _xRes * y;
-      _spatial[index][0] = m[index];
+      _spatial[index][0] = m(x, y);
       _spatial[index][1] = 0.0f;
     }
 
@@ -86,7 +86,7 @@ void FIELD_2D_FFT::inverseFFT(FIELD_2D& m)
     for (int x = 0; x < _xRes; x++)
     {
       int index = x + _xRes * y;
-      m[index] = _spatial[index][0];
+      m(x, y) = _spatial[index][0];
     }
 
   // scale by array size
@@ -102,8 +102,11 @@ FIELD_2D FIELD_2D_FFT::inverseFFT(const FIELD_2D& real, const FIELD_2D& imaginar
   assert(imaginary.xRes() == _xRes); 
   assert(imaginary.yRes() == _yRes); 
 
-  FIELD_2D realShifted = real;
-  FIELD_2D imaginaryShifted = imaginary;
+  // dense copies, so they can be walked like the FFTW arrays
+  FIELD_2D realShifted(_xRes, _yRes);
+  FIELD_2D imaginaryShifted(_xRes, _yRes);
+  realShifted = real;
+  imaginaryShifted = imaginary;
 
   shift(realShifted);
   shift(imaginaryShifted);
@@ -148,6 +151,9 @@ void FIELD_2D_FFT::shift(FIELD_2D& field)
   int xRes = field.xRes();
   int yRes = field.yRes();
 
+  // indexes straight into the storage
+  assert(field.pitch() == xRes);
+
   FIELD_2D scratch(field);
   scratch = 0;
 
@@ -2,46 +2,259 @@
 #include <jpeglib.h>
 #include <png.h>
 #include <cassert>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+#include "FIELD_2D_REDUCE.h"
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 FIELD_2D::FIELD_2D(const int& rows, const int& cols) :
-  _xRes(rows), _yRes(cols)
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
 {
-  _totalCells = _xRes * _yRes;
-  _data = new float[_totalCells];
+  reallocate(rows, cols, rows, FIELD_2D_ROW_MAJOR);
+  clear();
+}
 
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = 0.0;
+///////////////////////////////////////////////////////////////////////
+// each row starts pitch floats after the last one
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(const int& rows, const int& cols, const int& pitch) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+  reallocate(rows, cols, pitch, FIELD_2D_ROW_MAJOR);
+  clear();
+}
+
+///////////////////////////////////////////////////////////////////////
+// the tiled layouts keep each FIELD_2D_TILE square of cells together,
+// so vertical neighbors are usually in the same few cache lines
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(const int& rows, const int& cols, const FIELD_2D_LAYOUT& layout) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+  reallocate(rows, cols, rows, layout);
+  clear();
 }
 
 FIELD_2D::FIELD_2D(const FIELD_2D& m) :
-  _xRes(m.xRes()), _yRes(m.yRes())
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
 {
-  _totalCells = _xRes * _yRes;
-  _data = new float[_totalCells];
+  // a copy of a view gets storage of its own, without the padding
+  if (m.isView())
+  {
+    reallocate(m.xRes(), m.yRes(), m.xRes(), FIELD_2D_ROW_MAJOR);
+    forEachCell(m, [](float& cell, const float& inputCell) { cell = inputCell; });
+    return;
+  }
+
+  reallocate(m.xRes(), m.yRes(), m.pitch(), m.layout());
 
-  for (int x = 0; x < _totalCells; x++)
+  const int size = storageSize();
+  for (int x = 0; x < size; x++)
     _data[x] = m[x];
 }
 
 FIELD_2D::FIELD_2D() :
-  _xRes(0), _yRes(0), _totalCells(0), _data(NULL)
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
+{
+}
+
+///////////////////////////////////////////////////////////////////////
+// a view doesn't own its storage, so there is nothing to steal from it
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(FIELD_2D&& m) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(NULL), _view(false)
 {
+  if (m._view)
+    *this = (const FIELD_2D&)m;
+  else
+    swap(m);
+}
+
+///////////////////////////////////////////////////////////////////////
+// wrap storage owned by another field, which has to outlive this one
+///////////////////////////////////////////////////////////////////////
+FIELD_2D::FIELD_2D(float* data, int xRes, int yRes, int pitch) :
+  _xRes(xRes), _yRes(yRes), _pitch(pitch), _totalCells(xRes * yRes),
+  _layout(FIELD_2D_ROW_MAJOR), _xTiles(0), _yTiles(0), _data(data), _view(true)
+{
+  assert(pitch >= xRes);
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 FIELD_2D::~FIELD_2D()
 {
-  delete[] _data;
+  if (!_view)
+    release(_data);
+}
+
+///////////////////////////////////////////////////////////////////////
+// rows start on a cache line, so SIMD loads at the beginning of a row
+// never straddle two of them
+///////////////////////////////////////////////////////////////////////
+float* FIELD_2D::allocate(int size)
+{
+  if (size <= 0)
+    return NULL;
+
+  void* memory = NULL;
+  if (posix_memalign(&memory, FIELD_2D_ALIGNMENT, size * sizeof(float)) != 0)
+  {
+    cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+    cout << " FIELD_2D could not allocate " << size << " floats! " << endl;
+    exit(0);
+  }
+  return (float*)memory;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::release(float* data)
+{
+  free(data);
+}
+
+///////////////////////////////////////////////////////////////////////
+// throw out the old storage and allocate new storage for the given
+// size and layout, without wiping it. A view lets go of its field
+// and becomes a field of its own.
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::reallocate(int xRes, int yRes, int pitch, FIELD_2D_LAYOUT layout)
+{
+  if (!_view)
+    release(_data);
+  _view = false;
+
+  _xRes = xRes;
+  _yRes = yRes;
+  _totalCells = _xRes * _yRes;
+  _layout = layout;
+
+  if (_layout == FIELD_2D_ROW_MAJOR)
+  {
+    assert(pitch >= xRes);
+    _pitch = pitch;
+    _xTiles = 0;
+    _yTiles = 0;
+  }
+  else
+  {
+    // there are no whole rows to have a pitch
+    _pitch = 0;
+    _xTiles = (_xRes + FIELD_2D_TILE - 1) / FIELD_2D_TILE;
+    _yTiles = (_yRes + FIELD_2D_TILE - 1) / FIELD_2D_TILE;
+  }
+
+  _data = allocate(storageSize());
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+const int FIELD_2D::storageSize() const
+{
+  if (_layout == FIELD_2D_ROW_MAJOR)
+    return _pitch * _yRes;
+  return _xTiles * _yTiles * FIELD_2D_TILE * FIELD_2D_TILE;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Tiles on the right and bottom edges can hang off the field, and the
+// cells hanging off are never read. Elementwise ops on the tiled
+// layouts just sweep the whole storage, so those cells can end up
+// holding anything.
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void FIELD_2D::forEachCell(OP op)
+{
+  if (_layout != FIELD_2D_ROW_MAJOR)
+  {
+    const int size = storageSize();
+    for (int x = 0; x < size; x++)
+      op(_data[x]);
+    return;
+  }
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    float* row = _data + y * _pitch;
+    for (int x = 0; x < _xRes; x++)
+      op(row[x]);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void FIELD_2D::forEachCell(const FIELD_2D& input, OP op)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  if (_layout == FIELD_2D_ROW_MAJOR && input.layout() == FIELD_2D_ROW_MAJOR)
+  {
+    for (int y = 0; y < _yRes; y++)
+    {
+      float* row = _data + y * _pitch;
+      const float* inputRow = input.row(y);
+      for (int x = 0; x < _xRes; x++)
+        op(row[x], inputRow[x]);
+    }
+    return;
+  }
+
+  // same size and the same tiling, so the storage lines up exactly
+  if (_layout == input.layout())
+  {
+    const int size = storageSize();
+    const float* inputData = input.data();
+    for (int x = 0; x < size; x++)
+      op(_data[x], inputData[x]);
+    return;
+  }
+
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++)
+      op((*this)(x, y), input(x, y));
+}
+
+///////////////////////////////////////////////////////////////////////
+// a row pitch that starts every row on a cache line, and that doesn't
+// land vertical neighbors in the same cache set, which happens when
+// rows are a multiple of 4K apart
+///////////////////////////////////////////////////////////////////////
+int FIELD_2D::paddedPitch(int xRes)
+{
+  const int perLine = FIELD_2D_ALIGNMENT / sizeof(float);
+  int pitch = ((xRes + perLine - 1) / perLine) * perLine;
+
+  if ((pitch * sizeof(float)) % 4096 == 0)
+    pitch += perLine;
+
+  return pitch;
 }
   
 ///////////////////////////////////////////////////////////////////////
+// wipes the padding too, so it never holds garbage, except in a view,
+// where the padding is the rest of some other field
 ///////////////////////////////////////////////////////////////////////
 void FIELD_2D::clear()
 {
-  for (int x = 0; x < _totalCells; x++)
+  if (_view)
+  {
+    forEachCell([](float& cell) { cell = 0.0; });
+    return;
+  }
+
+  const int size = storageSize();
+  for (int x = 0; x < size; x++)
     _data[x] = 0.0;
 }
 
@@ -63,19 +276,15 @@ void FIELD_2D::write(string filename) const
   fwrite((void*)&_xRes, sizeof(int), 1, file);
   fwrite((void*)&_yRes, sizeof(int), 1, file);
 
-  // always write out as a double
-  if (sizeof(float) != sizeof(double))
+  // always write out as a double, without the row padding, a row
+  // at a time
+  vector<double> rowDouble(_xRes);
+  for (int y = 0; y < _yRes; y++)
   {
-    double* dataDouble = new double[_totalCells];
-    for (int x = 0; x < _totalCells; x++)
-      dataDouble[x] = _data[x];
-
-    fwrite((void*)dataDouble, sizeof(double), _totalCells, file);
-    delete[] dataDouble;
-    fclose(file);
+    for (int x = 0; x < _xRes; x++)
+      rowDouble[x] = (*this)(x,y);
+    fwrite((void*)&rowDouble[0], sizeof(double), _xRes, file);
   }
-  else
-    fwrite((void*)_data, sizeof(float), _totalCells, file);
   fclose(file);
 }
 
@@ -94,25 +303,20 @@ void FIELD_2D::read(string filename)
   }
 
   // read dimensions
-  fread((void*)&_xRes, sizeof(int), 1, file);
-  fread((void*)&_yRes, sizeof(int), 1, file);
-  _totalCells = _xRes * _yRes;
-  if (_data) delete[] _data;
-  _data = new float[_totalCells];
+  int xRes, yRes;
+  fread((void*)&xRes, sizeof(int), 1, file);
+  fread((void*)&yRes, sizeof(int), 1, file);
+  resizeAndWipe(xRes, yRes);
 
-  // always read in as a double
-  if (sizeof(float) != sizeof(double))
+  // always read in as a double, a row at a time
+  vector<double> rowDouble(_xRes);
+  for (int y = 0; y < _yRes; y++)
   {
-    double* dataDouble = new double[_totalCells];
-    fread((void*)dataDouble, sizeof(double), _totalCells, file);
-
-    for (int x = 0; x < _totalCells; x++)
-      _data[x] = dataDouble[x];
-
-    delete[] dataDouble;
+    if (fread((void*)&rowDouble[0], sizeof(double), _xRes, file) != (size_t)_xRes)
+      break;
+    for (int x = 0; x < _xRes; x++)
+      (*this)(x,y) = rowDouble[x];
   }
-  else
-    fread((void*)_data, sizeof(float), _totalCells, file);
   fclose(file);
 }
 
@@ -123,12 +327,14 @@ void FIELD_2D::writePPM(string filename)
   FILE *fp;
   unsigned char* pixels = new unsigned char[3 * _totalCells];
 
-  for (int x = 0; x < _totalCells; x++)
-  {
-    pixels[3 * x] = 255 * _data[x];
-    pixels[3 * x + 1] = 255 * _data[x];
-    pixels[3 * x + 2] = 255 * _data[x];
-  }
+  int index = 0;
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++, index++)
+    {
+      pixels[3 * index] = 255 * (*this)(x,y);
+      pixels[3 * index + 1] = 255 * (*this)(x,y);
+      pixels[3 * index + 2] = 255 * (*this)(x,y);
+    }
 
   fp = fopen(filename.c_str(), "wb");
   fprintf(fp, "P6\n%d %d\n255\n", _xRes, _yRes);
@@ -221,12 +427,7 @@ void FIELD_2D::readPNG(string filename)
   fclose(fp);
 
   // push the data into the member variables
-  _xRes = width;
-  _yRes = height;
-  _totalCells = _xRes * _yRes;
-
-  if (_data) delete[] _data;
-  _data = new float[_totalCells];
+  resizeAndWipe(width, height);
 
   if (color_type == PNG_COLOR_TYPE_GRAY)
   {
@@ -425,55 +626,149 @@ void FIELD_2D::writeJPG(string filename)
 ///////////////////////////////////////////////////////////////////////
 void FIELD_2D::normalize()
 {
-  float maxFound = 0.0;
-  float minFound = _data[0];
-  for (int x = 0; x < _totalCells; x++)
+  if (_totalCells == 0) return;
+
+  float minFound, maxFound, total;
+  minMaxSum(minFound, maxFound, total);
+
+  // the max has always been clamped to at least zero
+  maxFound = (maxFound > 0.0) ? maxFound : 0.0;
+
+  float range = 1.0 / (maxFound - minFound);
+
+  // the tiled layouts just sweep the storage one tile at a time
+  if (_layout != FIELD_2D_ROW_MAJOR)
   {
-    maxFound = (_data[x] > maxFound) ? _data[x] : maxFound;
-    minFound = (_data[x] < minFound) ? _data[x] : minFound;
+    const int tileSize = FIELD_2D_TILE * FIELD_2D_TILE;
+    THREAD_POOL::shared().parallelFor(_xTiles * _yTiles, [&](int begin, int end) {
+      for (int x = begin * tileSize; x < end * tileSize; x++)
+        _data[x] = (_data[x] - minFound) * range;
+    }, 65536 / tileSize + 1);
+    return;
   }
 
-  float range = 1.0 / (maxFound - minFound);
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = (_data[x] - minFound) * range;
+  const int minRows = 65536 / _xRes + 1;
+  THREAD_POOL::shared().parallelFor(_yRes, [&](int begin, int end) {
+    for (int y = begin; y < end; y++)
+    {
+      float* row = _data + y * _pitch;
+      for (int x = 0; x < _xRes; x++)
+        row[x] = (row[x] - minFound) * range;
+    }
+  }, minRows);
+}
+
+///////////////////////////////////////////////////////////////////////
+// min, max and sum in a single parallel sweep, see FIELD_2D_REDUCE.h
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::minMaxSum(float& minFound, float& maxFound, float& total) const
+{
+  FIELD_2D_REDUCTION<1> stats;
+  if (_layout == FIELD_2D_ROW_MAJOR)
+    stats = FIELD_2D_REDUCE<1>(_yRes, _xRes,
+      [this](int y, FIELD_2D_REDUCTION<1>& partial) { partial.add(row(y), _xRes); });
+  else
+  {
+    // one job per tile, skipping whatever hangs off the field
+    const int tileSize = FIELD_2D_TILE * FIELD_2D_TILE;
+    stats = FIELD_2D_REDUCE<1>(_xTiles * _yTiles, tileSize,
+      [this, tileSize](int tile, FIELD_2D_REDUCTION<1>& partial) {
+        const int xStart = (tile % _xTiles) * FIELD_2D_TILE;
+        const int yStart = (tile / _xTiles) * FIELD_2D_TILE;
+        const int width = (_xRes - xStart < FIELD_2D_TILE) ? _xRes - xStart : FIELD_2D_TILE;
+        const int height = (_yRes - yStart < FIELD_2D_TILE) ? _yRes - yStart : FIELD_2D_TILE;
+        const float* tileData = _data + tile * tileSize;
+
+        if (width == FIELD_2D_TILE && height == FIELD_2D_TILE)
+          partial.add(tileData, tileSize);
+        else if (_layout == FIELD_2D_TILED)
+          for (int y = 0; y < height; y++)
+            partial.add(tileData + y * FIELD_2D_TILE, width);
+        else
+          for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+              partial.add(tileData + morton(x, y), 1);
+      });
+  }
+
+  minFound = stats.minFound[0];
+  maxFound = stats.maxFound[0];
+  total = stats.total[0];
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 FIELD_2D& FIELD_2D::abs()
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = fabs(_data[x]);
+  forEachCell([](float& cell) { cell = fabs(cell); });
 
   return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////
+// the layout stays the same, and a padded field stays padded at the
+// new size. A view stays a view if the size doesn't change, and gets
+// dense storage of its own if it does.
 ///////////////////////////////////////////////////////////////////////
 void FIELD_2D::resizeAndWipe(int xRes, int yRes)
 {
-  if (_xRes == xRes && _yRes == yRes)
+  if (_layout != FIELD_2D_ROW_MAJOR)
+  {
+    resizeAndWipe(xRes, yRes, _layout);
+    return;
+  }
+
+  if (_view)
+  {
+    resizeAndWipe(xRes, yRes, (xRes == _xRes && yRes == _yRes) ? _pitch : xRes);
+    return;
+  }
+
+  bool padded = (_pitch != _xRes);
+  resizeAndWipe(xRes, yRes, padded ? paddedPitch(xRes) : xRes);
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::resizeAndWipe(int xRes, int yRes, int pitch)
+{
+  assert(pitch >= xRes);
+
+  if (_xRes == xRes && _yRes == yRes && _pitch == pitch && _layout == FIELD_2D_ROW_MAJOR)
   {
     clear();
     return;
   }
 
-  if (_data)
-    delete[] _data;
+  reallocate(xRes, yRes, pitch, FIELD_2D_ROW_MAJOR);
+  clear();
+}
 
-  _xRes = xRes;
-  _yRes = yRes;
-  _totalCells = _xRes * _yRes;
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void FIELD_2D::resizeAndWipe(int xRes, int yRes, FIELD_2D_LAYOUT layout)
+{
+  if (layout == FIELD_2D_ROW_MAJOR)
+  {
+    resizeAndWipe(xRes, yRes, xRes);
+    return;
+  }
+
+  if (_xRes == xRes && _yRes == yRes && _layout == layout)
+  {
+    clear();
+    return;
+  }
 
-  _data = new float[_xRes * _yRes];
+  reallocate(xRes, yRes, 0, layout);
+  clear();
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 FIELD_2D& FIELD_2D::operator=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = alpha;
+  forEachCell([alpha](float& cell) { cell = alpha; });
 
   return *this;
 }
@@ -482,8 +777,7 @@ FIELD_2D& FIELD_2D::operator=(const float& alpha)
 ///////////////////////////////////////////////////////////////////////
 FIELD_2D& FIELD_2D::operator*=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] *= alpha;
+  forEachCell([alpha](float& cell) { cell *= alpha; });
 
   return *this;
 }
@@ -492,8 +786,7 @@ FIELD_2D& FIELD_2D::operator*=(const float& alpha)
 ///////////////////////////////////////////////////////////////////////
 FIELD_2D& FIELD_2D::operator/=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] /= alpha;
+  forEachCell([alpha](float& cell) { cell /= alpha; });
 
   return *this;
 }
@@ -502,8 +795,7 @@ FIELD_2D& FIELD_2D::operator/=(const float& alpha)
 ///////////////////////////////////////////////////////////////////////
 FIELD_2D& FIELD_2D::operator+=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] += alpha;
+  forEachCell([alpha](float& cell) { cell += alpha; });
 
   return *this;
 }
@@ -514,8 +806,7 @@ FIELD_2D& FIELD_2D::operator-=(const FIELD_2D& input)
 {
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] -= input[x];
+  forEachCell(input, [](float& cell, const float& inputCell) { cell -= inputCell; });
 
   return *this;
 }
@@ -526,8 +817,7 @@ FIELD_2D& FIELD_2D::operator+=(const FIELD_2D& input)
 {
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] += input[x];
+  forEachCell(input, [](float& cell, const float& inputCell) { cell += inputCell; });
 
   return *this;
 }
@@ -539,8 +829,7 @@ FIELD_2D& FIELD_2D::operator*=(const FIELD_2D& input)
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
 
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] *= input[x];
+  forEachCell(input, [](float& cell, const float& inputCell) { cell *= inputCell; });
 
   return *this;
 }
@@ -552,84 +841,96 @@ FIELD_2D& FIELD_2D::operator/=(const FIELD_2D& input)
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
 
-  for (int x = 0; x < _totalCells; x++)
-    if (fabs(input[x]) > 1e-6)
-      _data[x] /= input[x];
+  forEachCell(input, [](float& cell, const float& inputCell) {
+    if (fabs(inputCell) > 1e-6)
+      cell /= inputCell;
     else
-      _data[x] = 0;
+      cell = 0;
+  });
 
   return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
-FIELD_2D operator*(const FIELD_2D& A, const float alpha)
+FIELD_2D& FIELD_2D::operator=(const FIELD_2D& A)
 {
-  FIELD_2D final(A);
-  final *= alpha;
-  return final;
-}
+  // every cell gets overwritten, so only touch the allocation
+  // if the size actually changed, in which case take on A's layout
+  // and pitch, unless A is a view, whose pitch is its field's
+  if (A.xRes() != _xRes || A.yRes() != _yRes)
+  {
+    if (A.isView())
+      resizeAndWipe(A.xRes(), A.yRes(), A.xRes());
+    else if (A.layout() == FIELD_2D_ROW_MAJOR)
+      resizeAndWipe(A.xRes(), A.yRes(), A.pitch());
+    else
+      resizeAndWipe(A.xRes(), A.yRes(), A.layout());
+  }
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-FIELD_2D operator/(const FIELD_2D& A, const float alpha)
-{
-  FIELD_2D final(A);
-  final /= alpha;
-  return final;
-}
+  forEachCell(A, [](float& cell, const float& inputCell) { cell = inputCell; });
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-FIELD_2D operator+(const FIELD_2D& A, const FIELD_2D& B)
-{
-  FIELD_2D final(A);
-  final += B;
-  return final;
+  return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////
+// moving into or out of a view copies the cells, since the view's
+// storage stays with its field
 ///////////////////////////////////////////////////////////////////////
-FIELD_2D operator-(const FIELD_2D& A, const FIELD_2D& B)
+FIELD_2D& FIELD_2D::operator=(FIELD_2D&& A)
 {
-  FIELD_2D final(A);
-  final -= B;
-  return final;
-}
+  if (this == &A)
+    return *this;
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-FIELD_2D operator+(const FIELD_2D& A, const float alpha)
-{
-  FIELD_2D final(A);
-  final += alpha;
-  return final;
-}
+  if (_view || A._view)
+    return *this = (const FIELD_2D&)A;
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-FIELD_2D operator*(const float alpha, const FIELD_2D& A)
-{
-  return A * alpha;
-}
+  release(_data);
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-FIELD_2D operator+(const float alpha, const FIELD_2D& A)
-{
-  return A + alpha;
+  _xRes = A._xRes;
+  _yRes = A._yRes;
+  _pitch = A._pitch;
+  _totalCells = A._totalCells;
+  _layout = A._layout;
+  _xTiles = A._xTiles;
+  _yTiles = A._yTiles;
+  _data = A._data;
+
+  A._xRes = 0;
+  A._yRes = 0;
+  A._pitch = 0;
+  A._totalCells = 0;
+  A._layout = FIELD_2D_ROW_MAJOR;
+  A._xTiles = 0;
+  A._yTiles = 0;
+  A._data = NULL;
+
+  return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////
+// exchange contents with another field without copying
 ///////////////////////////////////////////////////////////////////////
-FIELD_2D& FIELD_2D::operator=(const FIELD_2D& A)
+void FIELD_2D::swap(FIELD_2D& input)
 {
-  resizeAndWipe(A.xRes(), A.yRes());
-
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = A[x];
+  if (_view || input._view)
+  {
+    assert(input.xRes() == _xRes);
+    assert(input.yRes() == _yRes);
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        std::swap((*this)(x, y), input(x, y));
+    return;
+  }
 
-  return *this;
+  std::swap(_xRes, input._xRes);
+  std::swap(_yRes, input._yRes);
+  std::swap(_pitch, input._pitch);
+  std::swap(_totalCells, input._totalCells);
+  std::swap(_layout, input._layout);
+  std::swap(_xTiles, input._xTiles);
+  std::swap(_yTiles, input._yTiles);
+  std::swap(_data, input._data);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -637,9 +938,8 @@ FIELD_2D& FIELD_2D::operator=(const FIELD_2D& A)
 ///////////////////////////////////////////////////////////////////////
 float FIELD_2D::sum()
 {
-  float total = 0;
-  for (int x = 0; x < _totalCells; x++)
-    total += _data[x];
+  float minFound, maxFound, total;
+  minMaxSum(minFound, maxFound, total);
 
   return total;
 }
@@ -650,8 +950,7 @@ float FIELD_2D::sum()
 void FIELD_2D::log(float base)
 {
   float scale = 1.0 / std::log(base);
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = std::log(_data[x]) * scale;
+  forEachCell([scale](float& cell) { cell = std::log(cell) * scale; });
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -661,10 +960,8 @@ float FIELD_2D::min()
 {
   assert(_xRes > 0);
   assert(_yRes > 0);
-  float final = _data[0];
-
-  for (int i = 0; i < _xRes * _yRes; i++)
-    final = (_data[i] < final) ? _data[i] : final;
+  float final, maxFound, total;
+  minMaxSum(final, maxFound, total);
 
   return final;
 }
@@ -676,10 +973,8 @@ float FIELD_2D::max()
 {
   assert(_xRes > 0);
   assert(_yRes > 0);
-  float final = _data[0];
-
-  for (int i = 0; i < _xRes * _yRes; i++)
-    final = (_data[i] > final) ? _data[i] : final;
+  float minFound, final, total;
+  minMaxSum(minFound, final, total);
 
   return final;
 }
@@ -0,0 +1,800 @@
+#ifndef FIELD_2D_SERIES_H
+#define FIELD_2D_SERIES_H
+
+///////////////////////////////////////////////////////////////////////
+// A compressed, append-only file of field frames, for archiving a
+// whole run instead of thousands of PNGs:
+//
+//   FIELD_2D_SERIES_WRITER series("run.series");
+//   for (int step = 1; ... )
+//   {
+//     runEverytime();
+//     series.append(field, step);
+//   }
+//   series.close();
+//
+//   FIELD_2D_SERIES_READER frames("run.series");
+//   for (int x = 0; x < frames.totalFrames(); x++)
+//     frames.read(x, field);
+//
+// Works for both FIELD_2D and COLOR_FIELD_2D. It's lossless unless
+// asked otherwise, the floats come back bit for bit. For frames that
+// are only ever going to be looked at, rounding away most of the
+// mantissa shrinks the file a lot more:
+//
+//   FIELD_2D_SERIES_WRITER series("run.series", 32, 10);
+//
+// keeps 10 bits of mantissa, about what a half float has.
+//
+// Each frame is XORed against the one before it, so cells that barely
+// changed turn into mostly zero bits, then the bytes get shuffled so
+// all the high bytes sit together, then FIELD_2D_LZ squeezes out the
+// runs. Every keyframeEvery frames is stored whole instead, so reading
+// any frame decodes at most that many, and reading them in order
+// decodes each one once.
+//
+// Frames go to disk as they're appended, and close() finishes off the
+// file with an index of where each one starts. A file that never got
+// closed, say because the run crashed, still reads: without the index
+// the reader walks the frames from the top and keeps whatever made it
+// to disk whole.
+//
+// A run that restarts from a checkpoint can carry on the same file:
+//
+//   FIELD_2D_SERIES_WRITER series("run.series");
+//   series.resume(step);
+//
+// keeps the frames from before step, closed off or not, and the next
+// append() goes in right after them. Frames from step on get written
+// over, since the restarted run is going to redo them.
+///////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+// bump when the file layout changes
+#define FIELD_2D_SERIES_VERSION 1
+
+///////////////////////////////////////////////////////////////////////
+// A small LZ77 byte compressor in the spirit of LZ4: greedy matches
+// found through a hash of the next four bytes, coded as
+//
+//   token, [more literal length], literals, offset, [more match length]
+//
+// where the token's high nibble is the literal count and the low one
+// the match length minus 4, 15 in either meaning more length bytes
+// follow, each adding up to 255. Offsets are two bytes, little-endian,
+// and the last sequence is just literals.
+///////////////////////////////////////////////////////////////////////
+class FIELD_2D_LZ {
+public:
+  // worst case output size for size bytes of input
+  static size_t bound(size_t size) { return size + size / 255 + 16; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // compress input onto the end of output, returning the bytes added
+  ////////////////////////////////////////////////////////////////////////
+  static size_t compress(const uint8_t* input, size_t size, std::vector<uint8_t>& output)
+  {
+    const size_t start = output.size();
+    output.resize(start + bound(size));
+    uint8_t* out = &output[start];
+
+    std::vector<uint32_t> table(1 << HASH_BITS, (uint32_t)EMPTY);
+    size_t anchor = 0;
+    size_t x = 0;
+    while (x + MIN_MATCH <= size)
+    {
+      const uint32_t next = read32(input + x);
+      const uint32_t hash = (next * 2654435761u) >> (32 - HASH_BITS);
+      const uint32_t candidate = table[hash];
+      table[hash] = (uint32_t)x;
+
+      if (candidate == EMPTY || x - candidate > MAX_OFFSET || read32(input + candidate) != next)
+      {
+        // skip ahead faster the longer it's been since the last match
+        x += 1 + ((x - anchor) >> 6);
+        continue;
+      }
+
+      size_t length = MIN_MATCH;
+      while (x + length < size && input[candidate + length] == input[x + length])
+        length++;
+
+      out = sequence(out, input + anchor, x - anchor, x - candidate, length);
+      x += length;
+      anchor = x;
+    }
+    out = sequence(out, input + anchor, size - anchor, 0, 0);
+
+    const size_t written = out - &output[start];
+    output.resize(start + written);
+    return written;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // decompress exactly size bytes into output, false if input is
+  // corrupt or comes out the wrong size
+  ////////////////////////////////////////////////////////////////////////
+  static bool decompress(const uint8_t* input, size_t inputSize, uint8_t* output, size_t size)
+  {
+    const uint8_t* in = input;
+    const uint8_t* inEnd = input + inputSize;
+    uint8_t* out = output;
+    uint8_t* outEnd = output + size;
+
+    while (in < inEnd)
+    {
+      const uint8_t token = *in++;
+
+      size_t literals = token >> 4;
+      if (literals == 15 && !readLength(in, inEnd, literals))
+        return false;
+      if ((size_t)(inEnd - in) < literals || (size_t)(outEnd - out) < literals)
+        return false;
+      memcpy(out, in, literals);
+      in += literals;
+      out += literals;
+
+      // the last sequence has no match
+      if (in == inEnd)
+        break;
+
+      if (inEnd - in < 2)
+        return false;
+      const size_t offset = in[0] | (in[1] << 8);
+      in += 2;
+      size_t length = token & 15;
+      if (length == 15 && !readLength(in, inEnd, length))
+        return false;
+      length += MIN_MATCH;
+
+      if (offset == 0 || offset > (size_t)(out - output) || (size_t)(outEnd - out) < length)
+        return false;
+
+      // byte at a time, since the match can overlap what it's writing
+      const uint8_t* match = out - offset;
+      for (size_t x = 0; x < length; x++)
+        out[x] = match[x];
+      out += length;
+    }
+    return out == outEnd;
+  };
+
+private:
+  enum { HASH_BITS = 14, MIN_MATCH = 4, MAX_OFFSET = 65535 };
+  static const uint32_t EMPTY = 0xffffffff;
+
+  static inline uint32_t read32(const uint8_t* bytes)
+  {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+  };
+
+  // 15 or more goes on in extra bytes
+  static inline uint8_t* writeLength(uint8_t* out, size_t length)
+  {
+    for (length -= 15; length >= 255; length -= 255)
+      *out++ = 255;
+    *out++ = (uint8_t)length;
+    return out;
+  };
+
+  static inline bool readLength(const uint8_t*& in, const uint8_t* inEnd, size_t& length)
+  {
+    uint8_t more;
+    do
+    {
+      if (in == inEnd)
+        return false;
+      more = *in++;
+      length += more;
+    } while (more == 255);
+    return true;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // one token's worth, where a length of 0 means literals only
+  ////////////////////////////////////////////////////////////////////////
+  static uint8_t* sequence(uint8_t* out, const uint8_t* literals, size_t count, size_t offset, size_t length)
+  {
+    const size_t matchCode = (length > 0) ? length - MIN_MATCH : 0;
+    uint8_t* token = out++;
+    *token = (uint8_t)(((count < 15) ? count : 15) << 4 | ((matchCode < 15) ? matchCode : 15));
+
+    if (count >= 15)
+      out = writeLength(out, count);
+    if (count > 0)
+      memcpy(out, literals, count);
+    out += count;
+
+    if (length == 0)
+      return out;
+
+    *out++ = offset & 0xff;
+    *out++ = offset >> 8;
+    if (matchCode >= 15)
+      out = writeLength(out, matchCode);
+    return out;
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// what's on disk, all little-endian
+///////////////////////////////////////////////////////////////////////
+struct FIELD_2D_SERIES_HEADER {
+  char magic[8];          // "FIELD2DS" (no NUL)
+  uint32_t version;       // FIELD_2D_SERIES_VERSION
+  uint32_t channels;      // floats per cell
+  uint32_t xRes;
+  uint32_t yRes;
+  uint32_t keyframeEvery;
+  uint32_t mantissaBits;  // 23 if lossless
+};
+
+// in front of every frame
+struct FIELD_2D_SERIES_FRAME {
+  char magic[4];          // "FRAM"
+  uint32_t flags;         // FIELD_2D_SERIES_KEYFRAME, FIELD_2D_SERIES_STORED
+  uint64_t step;
+  double time;
+  uint64_t bytes;         // what follows
+};
+
+// one per frame in the index, which close() puts at the end, followed
+// by the trailer
+struct FIELD_2D_SERIES_ENTRY {
+  uint64_t offset;        // of the frame header, from the top of the file
+  uint64_t step;
+  double time;
+};
+
+struct FIELD_2D_SERIES_TRAILER {
+  uint64_t indexOffset;
+  uint64_t frames;
+  char magic[8];          // "F2DINDEX"
+};
+
+enum {
+  FIELD_2D_SERIES_KEYFRAME = 1,  // not a delta from the frame before
+  FIELD_2D_SERIES_STORED = 2     // shuffled but not compressed, it didn't help
+};
+
+///////////////////////////////////////////////////////////////////////
+// the bits both ends share
+///////////////////////////////////////////////////////////////////////
+class FIELD_2D_SERIES {
+public:
+  // float for FIELD_2D, VEC3F for COLOR_FIELD_2D
+  template <class FIELD>
+  struct CELL {
+    typedef typename std::remove_const<typename std::remove_reference<decltype(std::declval<FIELD&>()(0, 0))>::type>::type type;
+  };
+
+  template <class FIELD>
+  static uint32_t channels() { return sizeof(typename CELL<FIELD>::type) / sizeof(float); };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the field's floats, dense and row by row, as raw bits
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  static void gather(const FIELD& field, uint32_t* words)
+  {
+    typedef typename CELL<FIELD>::type CELL_TYPE;
+    const size_t rowBytes = field.xRes() * sizeof(CELL_TYPE);
+    for (int y = 0; y < field.yRes(); y++, words += rowBytes / sizeof(uint32_t))
+    {
+      if (field.rowMajor())
+      {
+        memcpy(words, field.row(y), rowBytes);
+        continue;
+      }
+      for (int x = 0; x < field.xRes(); x++)
+      {
+        const CELL_TYPE cell = field(x, y);
+        memcpy(words + x * channels<FIELD>(), &cell, sizeof(CELL_TYPE));
+      }
+    }
+  };
+
+  template <class FIELD>
+  static void scatter(const uint32_t* words, FIELD& field)
+  {
+    typedef typename CELL<FIELD>::type CELL_TYPE;
+    const size_t rowBytes = field.xRes() * sizeof(CELL_TYPE);
+    for (int y = 0; y < field.yRes(); y++, words += rowBytes / sizeof(uint32_t))
+    {
+      if (field.rowMajor())
+      {
+        memcpy(field.row(y), words, rowBytes);
+        continue;
+      }
+      for (int x = 0; x < field.xRes(); x++)
+        memcpy(&field(x, y), words + x * channels<FIELD>(), sizeof(CELL_TYPE));
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // byte b of every word goes in the b'th quarter, so the exponent
+  // bytes, which hardly change, end up in long runs
+  ////////////////////////////////////////////////////////////////////////
+  static void shuffle(const uint32_t* words, size_t count, uint8_t* bytes)
+  {
+    for (size_t x = 0; x < count; x++)
+    {
+      const uint32_t word = words[x];
+      bytes[x] = word & 0xff;
+      bytes[count + x] = (word >> 8) & 0xff;
+      bytes[2 * count + x] = (word >> 16) & 0xff;
+      bytes[3 * count + x] = word >> 24;
+    }
+  };
+
+  static void unshuffle(const uint8_t* bytes, size_t count, uint32_t* words)
+  {
+    for (size_t x = 0; x < count; x++)
+      words[x] = (uint32_t)bytes[x] | (uint32_t)bytes[count + x] << 8 |
+                 (uint32_t)bytes[2 * count + x] << 16 | (uint32_t)bytes[3 * count + x] << 24;
+  };
+
+  // the cells go to and from disk as they are, so little-endian only
+  static void checkByteOrder()
+  {
+    const uint32_t one = 1;
+    if (*(const char*)&one == 1)
+      return;
+    std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+    std::cout << " FIELD_2D_SERIES only supports little-endian machines" << std::endl;
+    exit(0);
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+class FIELD_2D_SERIES_WRITER {
+public:
+  FIELD_2D_SERIES_WRITER(const std::string& filename, int keyframeEvery = 32, int mantissaBits = 23) :
+    _filename(filename), _file(NULL), _keyframeEvery(keyframeEvery), _mantissaBits(mantissaBits),
+    _channels(0), _xRes(0), _yRes(0), _rawBytes(0), _bytesWritten(0)
+  {
+    assert(keyframeEvery >= 1);
+    assert(mantissaBits >= 0 && mantissaBits <= 23);
+    FIELD_2D_SERIES::checkByteOrder();
+  };
+
+  ~FIELD_2D_SERIES_WRITER() { close(); };
+
+  FIELD_2D_SERIES_WRITER(const FIELD_2D_SERIES_WRITER&) = delete;
+  FIELD_2D_SERIES_WRITER& operator=(const FIELD_2D_SERIES_WRITER&) = delete;
+
+  const int totalFrames() const { return _index.size(); };
+
+  // for the compression ratio, how much the frames would have taken
+  // as plain floats, and how much they did take
+  const uint64_t rawBytes() const { return _rawBytes; };
+  const uint64_t bytesWritten() const { return _bytesWritten; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // compress field and write it out. The first frame opens the file
+  // and fixes the size, every frame after has to match it.
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void append(const FIELD& field, uint64_t step, double time = 0.0)
+  {
+    if (_file == NULL)
+      open(FIELD_2D_SERIES::channels<FIELD>(), field.xRes(), field.yRes());
+
+    if (FIELD_2D_SERIES::channels<FIELD>() != _channels || field.xRes() != _xRes || field.yRes() != _yRes)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Frame is " << field.xRes() << " x " << field.yRes()
+                << " but " << _filename.c_str() << " is " << _xRes << " x " << _yRes << std::endl;
+      exit(0);
+    }
+
+    FIELD_2D_SERIES::gather(field, &_current[0]);
+    const size_t count = _current.size();
+    if (_mantissaBits < 23)
+      roundMantissa(&_current[0], count);
+    const bool keyframe = (_index.size() % _keyframeEvery) == 0;
+    if (!keyframe)
+      for (size_t x = 0; x < count; x++)
+        _delta[x] = _current[x] ^ _previous[x];
+
+    FIELD_2D_SERIES::shuffle(keyframe ? &_current[0] : &_delta[0], count, &_shuffled[0]);
+    _compressed.clear();
+    FIELD_2D_LZ::compress(&_shuffled[0], _shuffled.size(), _compressed);
+
+    FIELD_2D_SERIES_FRAME frame;
+    memcpy(frame.magic, "FRAM", 4);
+    frame.flags = keyframe ? FIELD_2D_SERIES_KEYFRAME : 0;
+    frame.step = step;
+    frame.time = time;
+
+    const uint8_t* payload = &_compressed[0];
+    frame.bytes = _compressed.size();
+    if (_compressed.size() >= _shuffled.size())
+    {
+      frame.flags |= FIELD_2D_SERIES_STORED;
+      payload = &_shuffled[0];
+      frame.bytes = _shuffled.size();
+    }
+
+    FIELD_2D_SERIES_ENTRY entry;
+    entry.offset = _bytesWritten;
+    entry.step = step;
+    entry.time = time;
+    _index.push_back(entry);
+
+    write(&frame, sizeof(frame));
+    write(payload, frame.bytes);
+    _rawBytes += count * sizeof(float);
+    _previous.swap(_current);
+  };
+
+  // carry on a series already on disk, see the top of the file
+  void resume(uint64_t step);
+
+  // push everything appended so far out to the OS
+  void flush() { if (_file != NULL) fflush(_file); };
+
+  ////////////////////////////////////////////////////////////////////////
+  // write the index and close the file, which then can't be appended
+  // to any more
+  ////////////////////////////////////////////////////////////////////////
+  void close()
+  {
+    if (_file == NULL)
+      return;
+
+    FIELD_2D_SERIES_TRAILER trailer;
+    trailer.indexOffset = _bytesWritten;
+    trailer.frames = _index.size();
+    memcpy(trailer.magic, "F2DINDEX", 8);
+    if (!_index.empty())
+      write(&_index[0], _index.size() * sizeof(FIELD_2D_SERIES_ENTRY));
+    write(&trailer, sizeof(trailer));
+
+    const bool failed = ferror(_file) != 0;
+    fclose(_file);
+    _file = NULL;
+    if (failed)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Could not write " << _filename.c_str() << std::endl;
+      exit(0);
+    }
+  };
+
+private:
+  std::string _filename;
+  FILE* _file;
+  int _keyframeEvery;
+  int _mantissaBits;
+
+  uint32_t _channels;
+  int _xRes;
+  int _yRes;
+
+  // this frame and the last one as raw bits, their XOR, and the
+  // bytes on their way out
+  std::vector<uint32_t> _current;
+  std::vector<uint32_t> _previous;
+  std::vector<uint32_t> _delta;
+  std::vector<uint8_t> _shuffled;
+  std::vector<uint8_t> _compressed;
+
+  std::vector<FIELD_2D_SERIES_ENTRY> _index;
+  uint64_t _rawBytes;
+  uint64_t _bytesWritten;
+
+  void open(uint32_t channels, int xRes, int yRes)
+  {
+    openFile("wb");
+    allocate(channels, xRes, yRes);
+
+    FIELD_2D_SERIES_HEADER header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "FIELD2DS", 8);
+    header.version = FIELD_2D_SERIES_VERSION;
+    header.channels = channels;
+    header.xRes = xRes;
+    header.yRes = yRes;
+    header.keyframeEvery = _keyframeEvery;
+    header.mantissaBits = _mantissaBits;
+    write(&header, sizeof(header));
+  };
+
+  void openFile(const char* mode)
+  {
+    _file = fopen(_filename.c_str(), mode);
+    if (_file == NULL)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Could not open file " << _filename.c_str() << std::endl;
+      exit(0);
+    }
+  };
+
+  void allocate(uint32_t channels, int xRes, int yRes)
+  {
+    _channels = channels;
+    _xRes = xRes;
+    _yRes = yRes;
+    const size_t count = (size_t)xRes * yRes * channels;
+    _current.resize(count);
+    _previous.resize(count);
+    _delta.resize(count);
+    _shuffled.resize(count * sizeof(uint32_t));
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // round to the nearest float with only _mantissaBits of mantissa,
+  // leaving infinities and NaNs alone
+  ////////////////////////////////////////////////////////////////////////
+  void roundMantissa(uint32_t* words, size_t count)
+  {
+    const int dropped = 23 - _mantissaBits;
+    const uint32_t half = 1u << (dropped - 1);
+    const uint32_t mask = ~((1u << dropped) - 1);
+    for (size_t x = 0; x < count; x++)
+      if ((words[x] & 0x7f800000) != 0x7f800000)
+        words[x] = (words[x] + half) & mask;
+  };
+
+  void write(const void* data, size_t bytes)
+  {
+    fwrite(data, 1, bytes, _file);
+    _bytesWritten += bytes;
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+class FIELD_2D_SERIES_READER {
+public:
+  FIELD_2D_SERIES_READER(const std::string& filename) :
+    _filename(filename), _decoded(-1)
+  {
+    FIELD_2D_SERIES::checkByteOrder();
+    _file = fopen(filename.c_str(), "rb");
+    if (_file == NULL || fread(&_header, sizeof(_header), 1, _file) != 1 ||
+        memcmp(_header.magic, "FIELD2DS", 8) != 0 || _header.version != FIELD_2D_SERIES_VERSION)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " " << filename.c_str() << " is not a version " << FIELD_2D_SERIES_VERSION << " series" << std::endl;
+      exit(0);
+    }
+
+    const size_t count = (size_t)_header.xRes * _header.yRes * _header.channels;
+    _current.resize(count);
+    _delta.resize(count);
+    _shuffled.resize(count * sizeof(uint32_t));
+
+    if (!readIndex())
+      rebuildIndex();
+  };
+
+  ~FIELD_2D_SERIES_READER() { if (_file) fclose(_file); };
+
+  FIELD_2D_SERIES_READER(const FIELD_2D_SERIES_READER&) = delete;
+  FIELD_2D_SERIES_READER& operator=(const FIELD_2D_SERIES_READER&) = delete;
+
+  const int totalFrames() const { return _index.size(); };
+  const int xRes() const { return _header.xRes; };
+  const int yRes() const { return _header.yRes; };
+  const int channels() const { return _header.channels; };
+  const int keyframeEvery() const { return _header.keyframeEvery; };
+  const int mantissaBits() const { return _header.mantissaBits; };
+  const uint64_t step(int frame) const { return _index[frame].step; };
+  const double time(int frame) const { return _index[frame].time; };
+  const FIELD_2D_SERIES_ENTRY& entry(int frame) const { return _index[frame]; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // decode a frame into field, resizing it if need be
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void read(int frame, FIELD& field)
+  {
+    assert(frame >= 0 && frame < totalFrames());
+    if (FIELD_2D_SERIES::channels<FIELD>() != _header.channels)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " " << _filename.c_str() << " has " << _header.channels << " channel frames" << std::endl;
+      exit(0);
+    }
+
+    if (field.xRes() != (int)_header.xRes || field.yRes() != (int)_header.yRes)
+      field.resizeAndWipe(_header.xRes, _header.yRes);
+    FIELD_2D_SERIES::scatter(&bits(frame)[0], field);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // a frame's floats as raw bits, dense and row by row
+  ////////////////////////////////////////////////////////////////////////
+  const std::vector<uint32_t>& bits(int frame)
+  {
+    assert(frame >= 0 && frame < totalFrames());
+
+    // carry on from the last frame decoded if it's on the way,
+    // otherwise go back to the keyframe
+    const int keyframe = frame - frame % _header.keyframeEvery;
+    const int first = (_decoded >= keyframe && _decoded <= frame) ? _decoded + 1 : keyframe;
+    for (int x = first; x <= frame; x++)
+      decode(x);
+    return _current;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // where the frame after this one starts, or would
+  ////////////////////////////////////////////////////////////////////////
+  const uint64_t frameEnd(int frame)
+  {
+    FIELD_2D_SERIES_FRAME header;
+    if (fseeko(_file, _index[frame].offset, SEEK_SET) != 0 || fread(&header, sizeof(header), 1, _file) != 1)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Frame " << frame << " of " << _filename.c_str() << " is corrupt" << std::endl;
+      exit(0);
+    }
+    return _index[frame].offset + sizeof(header) + header.bytes;
+  };
+
+private:
+  std::string _filename;
+  FILE* _file;
+  FIELD_2D_SERIES_HEADER _header;
+  std::vector<FIELD_2D_SERIES_ENTRY> _index;
+
+  // the last frame decoded, and which one it was
+  std::vector<uint32_t> _current;
+  int _decoded;
+
+  std::vector<uint32_t> _delta;
+  std::vector<uint8_t> _shuffled;
+  std::vector<uint8_t> _compressed;
+
+  ////////////////////////////////////////////////////////////////////////
+  // the index close() left at the end, if it did
+  ////////////////////////////////////////////////////////////////////////
+  bool readIndex()
+  {
+    FIELD_2D_SERIES_TRAILER trailer;
+    if (fseeko(_file, -(off_t)sizeof(trailer), SEEK_END) != 0 ||
+        fread(&trailer, sizeof(trailer), 1, _file) != 1 ||
+        memcmp(trailer.magic, "F2DINDEX", 8) != 0)
+      return false;
+
+    _index.resize(trailer.frames);
+    if (fseeko(_file, trailer.indexOffset, SEEK_SET) != 0 ||
+        (trailer.frames > 0 && fread(&_index[0], sizeof(FIELD_2D_SERIES_ENTRY), trailer.frames, _file) != trailer.frames))
+    {
+      _index.clear();
+      return false;
+    }
+    return true;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // no index, so walk the frames and keep the ones that are all there
+  ////////////////////////////////////////////////////////////////////////
+  void rebuildIndex()
+  {
+    _index.clear();
+    fseeko(_file, 0, SEEK_END);
+    const uint64_t end = ftello(_file);
+
+    uint64_t offset = sizeof(FIELD_2D_SERIES_HEADER);
+    FIELD_2D_SERIES_FRAME frame;
+    while (fseeko(_file, offset, SEEK_SET) == 0 && fread(&frame, sizeof(frame), 1, _file) == 1 &&
+           memcmp(frame.magic, "FRAM", 4) == 0 && offset + sizeof(frame) + frame.bytes <= end)
+    {
+      FIELD_2D_SERIES_ENTRY entry;
+      entry.offset = offset;
+      entry.step = frame.step;
+      entry.time = frame.time;
+      _index.push_back(entry);
+      offset += sizeof(frame) + frame.bytes;
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // decode frame into _current, which has to hold the frame before it
+  // unless it's a keyframe
+  ////////////////////////////////////////////////////////////////////////
+  void decode(int frame)
+  {
+    FIELD_2D_SERIES_FRAME header;
+    bool valid = fseeko(_file, _index[frame].offset, SEEK_SET) == 0 &&
+                 fread(&header, sizeof(header), 1, _file) == 1 &&
+                 memcmp(header.magic, "FRAM", 4) == 0;
+
+    if (valid && (header.flags & FIELD_2D_SERIES_STORED))
+      valid = header.bytes == _shuffled.size() && fread(&_shuffled[0], 1, _shuffled.size(), _file) == _shuffled.size();
+    else if (valid)
+    {
+      _compressed.resize(header.bytes);
+      valid = fread(&_compressed[0], 1, header.bytes, _file) == header.bytes &&
+              FIELD_2D_LZ::decompress(&_compressed[0], header.bytes, &_shuffled[0], _shuffled.size());
+    }
+
+    if (!valid)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Frame " << frame << " of " << _filename.c_str() << " is corrupt" << std::endl;
+      exit(0);
+    }
+
+    const size_t count = _current.size();
+    if (header.flags & FIELD_2D_SERIES_KEYFRAME)
+      FIELD_2D_SERIES::unshuffle(&_shuffled[0], count, &_current[0]);
+    else
+    {
+      assert(_decoded == frame - 1);
+      FIELD_2D_SERIES::unshuffle(&_shuffled[0], count, &_delta[0]);
+      for (size_t x = 0; x < count; x++)
+        _current[x] ^= _delta[x];
+    }
+    _decoded = frame;
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// Down here since it needs the reader. Drops the index and anything
+// from step on, then sets up as if the frames kept had just been
+// appended.
+///////////////////////////////////////////////////////////////////////
+inline void FIELD_2D_SERIES_WRITER::resume(uint64_t step)
+{
+  assert(_file == NULL && _index.empty());
+
+  // nothing there yet, so the first append() starts it like always
+  if (access(_filename.c_str(), F_OK) != 0)
+    return;
+
+  uint64_t end;
+  {
+    FIELD_2D_SERIES_READER reader(_filename);
+    if (reader.keyframeEvery() != _keyframeEvery || reader.mantissaBits() != _mantissaBits)
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " " << _filename.c_str() << " was written with different settings, so it can't be resumed" << std::endl;
+      exit(0);
+    }
+
+    int kept = 0;
+    while (kept < reader.totalFrames() && reader.step(kept) < step)
+      kept++;
+    if (kept == 0)
+      return;
+
+    allocate(reader.channels(), reader.xRes(), reader.yRes());
+    _previous = reader.bits(kept - 1);
+    for (int x = 0; x < kept; x++)
+      _index.push_back(reader.entry(x));
+    end = reader.frameEnd(kept - 1);
+  }
+
+  if (truncate(_filename.c_str(), end) != 0)
+  {
+    std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+    std::cout << " Could not write " << _filename.c_str() << std::endl;
+    exit(0);
+  }
+  openFile("r+b");
+  fseeko(_file, end, SEEK_SET);
+  _bytesWritten = end;
+  _rawBytes = (uint64_t)_index.size() * _previous.size() * sizeof(float);
+};
+
+#endif
@@ -0,0 +1,601 @@
+#ifndef FIELD_2D_TEXTURE_H
+#define FIELD_2D_TEXTURE_H
+
+///////////////////////////////////////////////////////////////////////
+// A GL texture that keeps itself in sync with a FIELD_2D or
+// COLOR_FIELD_2D, uploading only what changed:
+//
+//   FIELD_2D_TEXTURE fieldTexture;
+//   ...
+//   fieldTexture.upload(field);
+//   ...
+//   fieldTexture.draw(xLength, yLength);
+//
+// The texture is only allocated again when the field changes size.
+// Every other upload compares the field row by row against a copy of
+// what was sent last time, and only the runs of rows that differ go
+// through glTexSubImage2D. If nothing differs, nothing gets sent.
+// When the caller already knows which tiles of the field it changed,
+// passing a mask of them skips comparing the rest.
+//
+// Where pixel buffer objects are available, the changed rows get
+// copied into one of two of them and GL pulls them from there on its
+// own time, while the next upload fills the other one. Otherwise they
+// are sent straight from memory.
+//
+// The display only has 8 bits a channel, so by default the rows are
+// quantized to bytes on the way out, a quarter of the float traffic.
+// setRange() picks which values map to black and white. Half floats
+// are there too, for when the range is too wide for 256 levels:
+//
+//   FIELD_2D_DISPLAY=float|half|byte   (byte is the default)
+//
+// Scalar fields can also be drawn through a colormap, which is looked
+// up on the GPU from a 256 entry 1D texture, so the upload stays at
+// one channel:
+//
+//   FIELD_2D_COLORMAP=gray|heat|coolwarm|viridis
+//
+// or nextColormap(), which the viewers hang off of the 'k' key.
+// Colormaps need GL 2, the same as the pixel buffers, and fall back to
+// gray without it, which is also what nextColormap() then reports.
+//
+// Only for row-major fields, which is everything the viewers draw.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D_TYPED.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if _WIN32
+#include <gl/glut.h>
+#elif __APPLE__
+#include <GLUT/glut.h>
+#else
+#include <GL/gl.h>
+#endif
+
+// pixel buffer objects and shaders are core since GL 2.1, which the
+// Mac headers declare, elsewhere the prototypes have to be asked for
+// with GL_GLEXT_PROTOTYPES
+#if __APPLE__ || defined(GL_GLEXT_PROTOTYPES)
+#define FIELD_2D_TEXTURE_GL2 1
+#endif
+
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+#ifndef GL_RGB16F
+#define GL_RGB16F 0x881B
+#endif
+
+// what each channel gets sent to GL as
+enum FIELD_2D_TEXTURE_FORMAT {
+  FIELD_2D_TEXTURE_FLOAT,
+  FIELD_2D_TEXTURE_HALF,
+  FIELD_2D_TEXTURE_BYTE
+};
+
+// colormaps for scalar fields, GRAY draws the value as is
+enum FIELD_2D_COLORMAP {
+  FIELD_2D_COLORMAP_GRAY,
+  FIELD_2D_COLORMAP_HEAT,
+  FIELD_2D_COLORMAP_COOLWARM,
+  FIELD_2D_COLORMAP_VIRIDIS,
+  FIELD_2D_COLORMAPS
+};
+
+class FIELD_2D_TEXTURE {
+public:
+  FIELD_2D_TEXTURE() :
+    _texture(0), _xRes(0), _yRes(0), _channels(0), _next(0),
+    _format(FIELD_2D_TEXTURE_BYTE), _low(0.0f), _high(1.0f), _stale(false),
+    _colormap(FIELD_2D_COLORMAP_GRAY), _colormapTexture(0), _colormapBuilt(-1), _program(0), _programFailed(false)
+  {
+    _buffers[0] = _buffers[1] = 0;
+
+    const char* format = getenv("FIELD_2D_DISPLAY");
+    if (format && strcmp(format, "float") == 0) _format = FIELD_2D_TEXTURE_FLOAT;
+    if (format && strcmp(format, "half") == 0)  _format = FIELD_2D_TEXTURE_HALF;
+
+    const char* colormap = getenv("FIELD_2D_COLORMAP");
+    for (int x = 0; colormap && x < FIELD_2D_COLORMAPS; x++)
+      if (strcmp(colormap, colormapName((FIELD_2D_COLORMAP)x)) == 0)
+        _colormap = (FIELD_2D_COLORMAP)x;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // bring the texture up to date with field, and leave it bound
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void upload(const FIELD& field)
+  {
+    const bool everything = prepare(field);
+
+    // gather up the runs of rows that changed
+    const int rowFloats = _xRes * _channels;
+    const size_t rowBytes = rowFloats * sizeof(float);
+    _runs.clear();
+    for (int y = 0; y < _yRes; y++)
+    {
+      const float* row = (const float*)field.row(y);
+      float* last = &_last[(size_t)y * rowFloats];
+      if (!everything && memcmp(row, last, rowBytes) == 0)
+        continue;
+
+      memcpy(last, row, rowBytes);
+      addRow(y);
+    }
+
+    if (!_runs.empty())
+      send();
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the same, when whoever changed the field knows which tiles of it
+  // they touched, e.g. LIFE_2D::changedTiles(). dirty has a flag per
+  // tileWidth x tileHeight tile, row by row of tiles, and everything
+  // outside the dirty tiles is taken to be the same as last time, so
+  // only those spans get compared. A mask that doesn't fit the field
+  // falls back to comparing everything.
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void upload(const FIELD& field, const std::vector<unsigned char>& dirty, int tileWidth, int tileHeight)
+  {
+    const int xTiles = (tileWidth > 0) ? (field.xRes() + tileWidth - 1) / tileWidth : 0;
+    const int yTiles = (tileHeight > 0) ? (field.yRes() + tileHeight - 1) / tileHeight : 0;
+    if (xTiles == 0 || yTiles == 0 || dirty.size() != (size_t)xTiles * yTiles ||
+        _stale || _texture == 0 || field.xRes() != _xRes || field.yRes() != _yRes)
+    {
+      upload(field);
+      return;
+    }
+
+    prepare(field);
+
+    const int rowFloats = _xRes * _channels;
+    _runs.clear();
+    for (int y = 0; y < _yRes; y++)
+    {
+      const unsigned char* tiles = &dirty[(y / tileHeight) * xTiles];
+      const float* row = (const float*)field.row(y);
+      float* last = &_last[(size_t)y * rowFloats];
+
+      bool changed = false;
+      for (int x = 0; x < xTiles; x++)
+      {
+        if (!tiles[x]) continue;
+        const int begin = x * tileWidth * _channels;
+        const int end = (begin + tileWidth * _channels < rowFloats) ? begin + tileWidth * _channels : rowFloats;
+        const size_t bytes = (end - begin) * sizeof(float);
+        if (memcmp(row + begin, last + begin, bytes) == 0)
+          continue;
+        memcpy(last + begin, row + begin, bytes);
+        changed = true;
+      }
+
+      if (changed)
+        addRow(y);
+    }
+
+    if (!_runs.empty())
+      send();
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // draw the texture over [0, xLength] x [0, yLength], through the
+  // colormap if there is one
+  ////////////////////////////////////////////////////////////////////////
+  void draw(float xLength, float yLength)
+  {
+#if FIELD_2D_TEXTURE_GL2
+    const bool mapping = useColormap();
+    if (mapping)
+    {
+      glUseProgram(_program);
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_1D, _colormapTexture);
+      glActiveTexture(GL_TEXTURE0);
+    }
+#endif
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
+
+    glEnable(GL_TEXTURE_2D);
+    glBegin(GL_QUADS);
+      glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, 0.0);
+      glTexCoord2f(0.0, 1.0); glVertex3f(0.0, yLength, 0.0);
+      glTexCoord2f(1.0, 1.0); glVertex3f(xLength, yLength, 0.0);
+      glTexCoord2f(1.0, 0.0); glVertex3f(xLength, 0.0, 0.0);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
+
+#if FIELD_2D_TEXTURE_GL2
+    if (mapping)
+      glUseProgram(0);
+#endif
+  };
+
+  // how the channels get sent, takes effect on the next upload
+  void setFormat(FIELD_2D_TEXTURE_FORMAT format) { _format = format; _xRes = 0; };
+  const FIELD_2D_TEXTURE_FORMAT format() const { return _format; };
+
+  // the values that get drawn as black and white, or as the two ends
+  // of the colormap
+  void setRange(float low, float high)
+  {
+    _stale = _stale || low != _low || high != _high;
+    _low = low;
+    _high = high;
+  };
+
+  void setColormap(FIELD_2D_COLORMAP colormap) { _colormap = colormap; };
+  const FIELD_2D_COLORMAP colormap() const { return _colormap; };
+
+  // step to the next colormap and return its name. Needs a current GL
+  // context, and stays on gray when colormaps can't be drawn
+  const char* nextColormap()
+  {
+    if (!colormapsWork())
+      _colormap = FIELD_2D_COLORMAP_GRAY;
+    else
+      _colormap = (FIELD_2D_COLORMAP)((_colormap + 1) % FIELD_2D_COLORMAPS);
+    return colormapName(_colormap);
+  };
+
+  static const char* colormapName(FIELD_2D_COLORMAP colormap)
+  {
+    static const char* names[] = { "gray", "heat", "coolwarm", "viridis" };
+    return names[colormap];
+  };
+
+  // rows sent by the last upload(), 0 if nothing had changed, mostly
+  // for seeing whether the dirty tracking is paying off
+  int rowsSent() const
+  {
+    int total = 0;
+    for (unsigned int x = 0; x < _runs.size(); x++)
+      total += _runs[x].end - _runs[x].begin;
+    return total;
+  };
+
+  // bytes GL has to pull per row in the current format
+  size_t bytesPerRow() const { return (size_t)_xRes * _channels * bytesPerChannel(); };
+
+private:
+  // rows [begin, end) that need sending
+  struct RUN {
+    RUN(int b, int e) : begin(b), end(e) {};
+    int begin;
+    int end;
+  };
+
+  GLuint _texture;
+  GLuint _buffers[2];
+  int _xRes;
+  int _yRes;
+  int _channels;
+
+  // which of the two buffers to fill next
+  int _next;
+
+  // what the texture holds, as of the last upload
+  std::vector<float> _last;
+  std::vector<RUN> _runs;
+
+  FIELD_2D_TEXTURE_FORMAT _format;
+  float _low;
+  float _high;
+
+  // the range changed, so every row needs sending again
+  bool _stale;
+
+  // rows converted to the send format when there's no buffer to
+  // convert straight into, and a row scaled into [0,1]
+  std::vector<char> _converted;
+  std::vector<float> _scaled;
+
+  FIELD_2D_COLORMAP _colormap;
+  GLuint _colormapTexture;
+
+  // which colormap is in _colormapTexture, if any
+  int _colormapBuilt;
+
+  GLuint _program;
+  bool _programFailed;
+
+  ////////////////////////////////////////////////////////////////////////
+  // allocate if the field changed shape and bind, returning whether
+  // every row has to go
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  bool prepare(const FIELD& field)
+  {
+    // 1 for FIELD_2D, 3 for the VEC3F in COLOR_FIELD_2D
+    const int channels = sizeof(field(0, 0)) / sizeof(float);
+
+    bool everything = _stale;
+    if (_texture == 0 || field.xRes() != _xRes || field.yRes() != _yRes || channels != _channels)
+    {
+      allocate(field.xRes(), field.yRes(), channels);
+      everything = true;
+    }
+    _stale = false;
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    return everything;
+  };
+
+  // add row y to the runs that need sending
+  void addRow(int y)
+  {
+    if (!_runs.empty() && _runs.back().end == y)
+      _runs.back().end++;
+    else
+      _runs.push_back(RUN(y, y + 1));
+  };
+
+  const GLenum glFormat() const { return (_channels == 1) ? GL_LUMINANCE : GL_RGB; };
+
+  const GLenum glType() const
+  {
+    if (_format == FIELD_2D_TEXTURE_HALF) return GL_HALF_FLOAT;
+    if (_format == FIELD_2D_TEXTURE_BYTE) return GL_UNSIGNED_BYTE;
+    return GL_FLOAT;
+  };
+
+  const int bytesPerChannel() const
+  {
+    if (_format == FIELD_2D_TEXTURE_HALF) return sizeof(HALF);
+    if (_format == FIELD_2D_TEXTURE_BYTE) return 1;
+    return sizeof(float);
+  };
+
+  // what GL keeps, half floats keep their precision on the card too.
+  // Scalars still get stored as RGB, since GL_DECAL is only defined
+  // for RGB textures.
+  const GLint internalFormat() const
+  {
+    return (_format == FIELD_2D_TEXTURE_HALF) ? GL_RGB16F : GL_RGB;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // (re)build the texture storage, and the buffers to fill it from
+  ////////////////////////////////////////////////////////////////////////
+  void allocate(int xRes, int yRes, int channels)
+  {
+    _xRes = xRes;
+    _yRes = yRes;
+    _channels = channels;
+    _last.assign((size_t)xRes * yRes * channels, 0.0f);
+    _scaled.resize((size_t)xRes * channels);
+
+    if (_texture == 0)
+    {
+      glGenTextures(1, &_texture);
+#if FIELD_2D_TEXTURE_GL2
+      glGenBuffers(2, _buffers);
+#endif
+    }
+
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(), _xRes, _yRes, 0, glFormat(), glType(), NULL);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // rescale count floats to the range and write them in the send
+  // format, using the SIMD conversions in FIELD_2D_TYPED.h
+  ////////////////////////////////////////////////////////////////////////
+  void convert(const float* input, char* output, int count)
+  {
+    const float* values = input;
+    const float scale = ((_format == FIELD_2D_TEXTURE_BYTE) ? 255.0f : 1.0f) / (_high - _low);
+    if (scale != 1.0f || _low != 0.0f)
+    {
+      float* scaled = &_scaled[0];
+      for (int x = 0; x < count; x++)
+        scaled[x] = (input[x] - _low) * scale;
+      values = scaled;
+    }
+
+    if (_format == FIELD_2D_TEXTURE_BYTE)
+      FIELD_2D_STORAGE<unsigned char>::fromFloats(values, (unsigned char*)output, count);
+    else if (_format == FIELD_2D_TEXTURE_HALF)
+      FIELD_2D_STORAGE<HALF>::fromFloats(values, (HALF*)output, count);
+    else
+      memcpy(output, values, count * sizeof(float));
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // convert the changed runs, which are already in _last, and send them
+  ////////////////////////////////////////////////////////////////////////
+  void send()
+  {
+    const int rowFloats = _xRes * _channels;
+    const size_t rowBytes = bytesPerRow();
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+#if FIELD_2D_TEXTURE_GL2
+    // fill the buffer the previous upload didn't use, so GL can still
+    // be reading that one. Handing glBufferData NULL first lets the
+    // driver swap in fresh memory instead of waiting on it either way.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffers[_next]);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, rowBytes * _yRes, NULL, GL_STREAM_DRAW);
+    char* mapped = (char*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if (mapped != NULL)
+    {
+      for (unsigned int x = 0; x < _runs.size(); x++)
+        for (int y = _runs[x].begin; y < _runs[x].end; y++)
+          convert(&_last[(size_t)y * rowFloats], mapped + y * rowBytes, rowFloats);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+      // the "pointers" are now offsets into the bound buffer
+      for (unsigned int x = 0; x < _runs.size(); x++)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, _runs[x].begin, _xRes, _runs[x].end - _runs[x].begin,
+                        glFormat(), glType(), (const GLvoid*)(_runs[x].begin * rowBytes));
+
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      _next = 1 - _next;
+      return;
+    }
+
+    // couldn't map it, so fall back to sending from memory
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+
+    _converted.resize(rowBytes * _yRes);
+    for (unsigned int x = 0; x < _runs.size(); x++)
+    {
+      for (int y = _runs[x].begin; y < _runs[x].end; y++)
+        convert(&_last[(size_t)y * rowFloats], &_converted[y * rowBytes], rowFloats);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, _runs[x].begin, _xRes, _runs[x].end - _runs[x].begin,
+                      glFormat(), glType(), &_converted[_runs[x].begin * rowBytes]);
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // color at t in [0,1] along the colormap, linear between stops
+  ////////////////////////////////////////////////////////////////////////
+  static VEC3F colormapColor(FIELD_2D_COLORMAP colormap, float t)
+  {
+    // viridis is from matplotlib, sampled at eighths
+    static const float gray[]     = { 0,0,0, 1,1,1 };
+    static const float heat[]     = { 0,0,0, 0.7,0,0, 1,0.5,0, 1,1,0.2, 1,1,1 };
+    static const float coolwarm[] = { 0.23,0.30,0.75, 0.87,0.87,0.87, 0.71,0.02,0.15 };
+    static const float viridis[]  = { 0.267,0.004,0.329, 0.278,0.176,0.482, 0.231,0.322,0.545,
+                                      0.173,0.447,0.557, 0.129,0.569,0.549, 0.157,0.682,0.502,
+                                      0.369,0.788,0.383, 0.678,0.863,0.188, 0.992,0.906,0.145 };
+    static const float* stops[] = { gray, heat, coolwarm, viridis };
+    static const int counts[] = { 2, 5, 3, 9 };
+
+    const float* stop = stops[colormap];
+    const float position = t * (counts[colormap] - 1);
+    int first = (int)position;
+    first = (first < counts[colormap] - 1) ? first : counts[colormap] - 2;
+    const float blend = position - first;
+
+    VEC3F color;
+    for (int x = 0; x < 3; x++)
+      color[x] = (1.0f - blend) * stop[3 * first + x] + blend * stop[3 * (first + 1) + x];
+    return color;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // can draw() put anything through a colormap? Only scalar fields
+  // can, and only once the program that reads them has built
+  ////////////////////////////////////////////////////////////////////////
+  bool colormapsWork()
+  {
+#if FIELD_2D_TEXTURE_GL2
+    if (_channels > 1 || _programFailed)
+      return false;
+    return _program != 0 || buildProgram();
+#else
+    return false;
+#endif
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // get the colormap texture and the program that reads it ready, and
+  // return whether to draw through them
+  ////////////////////////////////////////////////////////////////////////
+  bool useColormap()
+  {
+#if FIELD_2D_TEXTURE_GL2
+    if (_channels != 1 || _colormap == FIELD_2D_COLORMAP_GRAY || !colormapsWork())
+      return false;
+
+    // the table only changes when the colormap does
+    if (_colormapTexture == 0)
+      glGenTextures(1, &_colormapTexture);
+    if (_colormapBuilt != _colormap)
+    {
+      unsigned char table[256 * 3];
+      for (int x = 0; x < 256; x++)
+      {
+        VEC3F color = colormapColor(_colormap, x / 255.0f);
+        for (int y = 0; y < 3; y++)
+          table[3 * x + y] = FIELD_2D_STORAGE<unsigned char>::fromFloat(color[y] * 255.0f);
+      }
+      glBindTexture(GL_TEXTURE_1D, _colormapTexture);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, table);
+      glTexParameterf(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameterf(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameterf(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      _colormapBuilt = _colormap;
+    }
+    return true;
+#else
+    return false;
+#endif
+  };
+
+#if FIELD_2D_TEXTURE_GL2
+  ////////////////////////////////////////////////////////////////////////
+  // a fragment program that looks the field value up in the colormap,
+  // the fixed pipeline still does the vertices
+  ////////////////////////////////////////////////////////////////////////
+  bool buildProgram()
+  {
+    // the half texel shifts make 0 and 1 land on the first and last
+    // entries rather than between them and the edge
+    const char* source =
+      "uniform sampler2D field;\n"
+      "uniform sampler1D colormap;\n"
+      "void main()\n"
+      "{\n"
+      "  float value = texture2D(field, gl_TexCoord[0].st).r;\n"
+      "  gl_FragColor = texture1D(colormap, value * (255.0 / 256.0) + 0.5 / 256.0);\n"
+      "}\n";
+
+    GLuint shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+      char log[1024];
+      glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+      cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+      cout << " Colormap shader didn't compile, drawing in gray: " << log << endl;
+      glDeleteShader(shader);
+      _programFailed = true;
+      return false;
+    }
+
+    _program = glCreateProgram();
+    glAttachShader(_program, shader);
+    glLinkProgram(_program);
+    glDeleteShader(shader);
+
+    GLint linked = 0;
+    glGetProgramiv(_program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+      cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << endl;
+      cout << " Colormap shader didn't link, drawing in gray" << endl;
+      glDeleteProgram(_program);
+      _program = 0;
+      _programFailed = true;
+      return false;
+    }
+
+    glUseProgram(_program);
+    glUniform1i(glGetUniformLocation(_program, "field"), 0);
+    glUniform1i(glGetUniformLocation(_program, "colormap"), 1);
+    glUseProgram(0);
+    return true;
+  };
+#endif
+};
+
+#endif
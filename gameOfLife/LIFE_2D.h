@@ -0,0 +1,405 @@
+#ifndef LIFE_2D_H
+#define LIFE_2D_H
+
+///////////////////////////////////////////////////////////////////////
+// A Game of Life board that packs 64 cells into each 64-bit word, and
+// steps a whole word of them at once with bit-sliced adders instead
+// of counting neighbors one cell at a time.
+//
+//   LIFE_2D life(xRes, yRes);
+//   life.set(x, y, true);
+//   life.step();
+//   FIELD_2D_CONVERT(life, field);
+//
+// The board wraps around into a torus, like the FIELD_2D version did.
+// Bit x % 64 of word x / 64 in a row holds cell x, and the unused bits
+// at the end of a row always stay zero. FIELD_2D_CONVERT only needs
+// to be called when something wants to look at the cells.
+//
+// The board is also cut into LIFE_2D_TILE x LIFE_2D_TILE tiles, and a
+// tile can only change if it or one of its eight neighbors changed the
+// step before, so only those get stepped, split across the
+// THREAD_POOL. A board that's mostly empty or settled costs about as
+// much as the part of it that's still moving. changedTiles() says
+// which tiles the last step changed, and unpackChanged() and
+// FIELD_2D_TEXTURE::upload() use it to skip the rest:
+//
+//   life.step();
+//   life.unpackChanged(field);
+//   fieldTexture.upload(field, life.changedTiles(), LIFE_2D_TILE, LIFE_2D_TILE);
+//
+// set() keeps track of what it touched, but anything written straight
+// through row() has to be followed by wake(), which marks every tile
+// as changed.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "THREAD_POOL.h"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// cells on a side of a tile, one word across
+#define LIFE_2D_TILE 64
+
+class LIFE_2D {
+public:
+  LIFE_2D(int xRes = 0, int yRes = 0) :
+    _xRes(0), _yRes(0), _words(0), _xTiles(0), _yTiles(0), _activeTiles(0)
+  {
+    resizeAndWipe(xRes, yRes);
+  };
+
+  const int xRes() const { return _xRes; };
+  const int yRes() const { return _yRes; };
+
+  // 64-bit words per row
+  const int words() const { return _words; };
+
+  // tiles across and down
+  const int xTiles() const { return _xTiles; };
+  const int yTiles() const { return _yTiles; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // resize, with every cell dead
+  ////////////////////////////////////////////////////////////////////////
+  void resizeAndWipe(int xRes, int yRes)
+  {
+    _xRes = xRes;
+    _yRes = yRes;
+    _words = (xRes + 63) / 64;
+    _cells.assign((size_t)_words * yRes, 0);
+    _next.assign((size_t)_words * yRes, 0);
+
+    // the valid bits of the last word in each row
+    _lastMask = (xRes % 64 == 0) ? ~(uint64_t)0 : ((uint64_t)1 << (xRes % 64)) - 1;
+
+    _xTiles = _words;
+    _yTiles = (yRes + LIFE_2D_TILE - 1) / LIFE_2D_TILE;
+    _changed.assign(_xTiles * _yTiles, 0);
+    _activeTiles = 0;
+  };
+
+  void clear() { resizeAndWipe(_xRes, _yRes); };
+
+  // mark every tile as changed, after writing through row()
+  void wake() { _changed.assign(_changed.size(), 1); };
+
+  ////////////////////////////////////////////////////////////////////////
+  // cell access, for setting up patterns and mouse edits
+  ////////////////////////////////////////////////////////////////////////
+  inline bool operator()(int x, int y) const {
+    assert(x >= 0 && x < _xRes && y >= 0 && y < _yRes);
+    return (row(y)[x >> 6] >> (x & 63)) & 1;
+  };
+
+  inline void set(int x, int y, bool alive) {
+    assert(x >= 0 && x < _xRes && y >= 0 && y < _yRes);
+    const uint64_t bit = (uint64_t)1 << (x & 63);
+    uint64_t& word = row(y)[x >> 6];
+    word = alive ? (word | bit) : (word & ~bit);
+    _changed[(y / LIFE_2D_TILE) * _xTiles + (x >> 6)] = 1;
+  };
+
+  inline uint64_t* row(int y) { return &_cells[(size_t)y * _words]; };
+  inline const uint64_t* row(int y) const { return &_cells[(size_t)y * _words]; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // live cells on the board
+  ////////////////////////////////////////////////////////////////////////
+  long population() const
+  {
+    long total = 0;
+    for (size_t x = 0; x < _cells.size(); x++)
+      total += __builtin_popcountll(_cells[x]);
+    return total;
+  };
+
+  // which tiles the last step changed, row by row of tiles
+  const std::vector<uint8_t>& changedTiles() const { return _changed; };
+
+  // tiles the last step had to look at
+  const int activeTiles() const { return _activeTiles; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // advance a generation of B3/S23
+  ////////////////////////////////////////////////////////////////////////
+  void step()
+  {
+    if (_xRes == 0 || _yRes == 0) return;
+
+    // everything next to a change, wrapping around
+    _active.assign(_changed.size(), 0);
+    for (int y = 0; y < _yTiles; y++)
+      for (int x = 0; x < _xTiles; x++)
+      {
+        if (!_changed[y * _xTiles + x]) continue;
+        for (int dy = -1; dy <= 1; dy++)
+          for (int dx = -1; dx <= 1; dx++)
+            _active[((y + dy + _yTiles) % _yTiles) * _xTiles + (x + dx + _xTiles) % _xTiles] = 1;
+      }
+
+    _schedule.clear();
+    for (unsigned int x = 0; x < _active.size(); x++)
+      if (_active[x])
+        _schedule.push_back(x);
+    _activeTiles = (int)_schedule.size();
+
+    // Tiles left out didn't change last time, so both buffers already
+    // hold the same thing there. Tiles that are stepped write all of
+    // theirs, so swapping keeps it that way.
+    _nextChanged.assign(_changed.size(), 0);
+    if (_activeTiles == _xTiles * _yTiles)
+    {
+      // everything is awake, so go a row of tiles at a time and stay
+      // in memory order instead of walking down each tile's column
+      THREAD_POOL::shared().parallelFor(_yTiles, [&](int begin, int end) {
+        for (int y = begin; y < end; y++)
+          stepTileRow(y);
+      });
+    }
+    else
+      THREAD_POOL::shared().parallelFor(_activeTiles, [&](int begin, int end) {
+        for (int x = begin; x < end; x++)
+          stepTile(_schedule[x]);
+      }, 4);
+    _cells.swap(_next);
+    _changed.swap(_nextChanged);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // bring a field that matched the generation before the last step up
+  // to date, only touching the tiles that changed
+  ////////////////////////////////////////////////////////////////////////
+  void unpackChanged(FIELD_2D& field) const
+  {
+    assert(field.xRes() == _xRes && field.yRes() == _yRes);
+
+    std::vector<int> changed;
+    for (unsigned int x = 0; x < _changed.size(); x++)
+      if (_changed[x])
+        changed.push_back(x);
+
+    THREAD_POOL::shared().parallelFor((int)changed.size(), [&](int begin, int end) {
+      float values[64];
+      for (int x = begin; x < end; x++)
+      {
+        const int w = changed[x] % _xTiles;
+        const int yBegin = (changed[x] / _xTiles) * LIFE_2D_TILE;
+        const int yEnd = (yBegin + LIFE_2D_TILE < _yRes) ? yBegin + LIFE_2D_TILE : _yRes;
+        const int count = (64 * w + 64 < _xRes) ? 64 : _xRes - 64 * w;
+        for (int y = yBegin; y < yEnd; y++)
+        {
+          const uint64_t word = row(y)[w];
+          for (int bit = 0; bit < count; bit++)
+            values[bit] = (float)((word >> bit) & 1);
+          field.setRun(64 * w, y, count, values);
+        }
+      }
+    }, 4);
+  };
+
+private:
+  int _xRes;
+  int _yRes;
+  int _words;
+  uint64_t _lastMask;
+
+  std::vector<uint64_t> _cells;
+  std::vector<uint64_t> _next;
+
+  int _xTiles;
+  int _yTiles;
+
+  // tiles that changed last step, and are changing this one
+  std::vector<uint8_t> _changed;
+  std::vector<uint8_t> _nextChanged;
+
+  // tiles that need stepping, as a mask and as a list
+  std::vector<uint8_t> _active;
+  std::vector<int> _schedule;
+  int _activeTiles;
+
+  ////////////////////////////////////////////////////////////////////////
+  // word w of a row shifted over by one cell each way, so bit i lines
+  // up with the cell to the west or east of cell i, wrapping around
+  // the ends of the row
+  ////////////////////////////////////////////////////////////////////////
+  inline void shifted(const uint64_t* cells, int w, uint64_t& west, uint64_t& east) const
+  {
+    const uint64_t word = cells[w];
+
+    const uint64_t before = (w > 0) ? cells[w - 1] >> 63 : (cells[_words - 1] >> ((_xRes - 1) & 63)) & 1;
+    west = (word << 1) | before;
+
+    // the padding above the last cell is zero, so shifting it down
+    // leaves a hole right where cell 0 wraps around to
+    const uint64_t after = (w < _words - 1) ? cells[w + 1] << 63 : (cells[0] & 1) << ((_xRes - 1) & 63);
+    east = (word >> 1) | after;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // how many of west, word and east are set, as a two bit number
+  ////////////////////////////////////////////////////////////////////////
+  inline void threeSum(const uint64_t* cells, int w, uint64_t& ones, uint64_t& twos) const
+  {
+    uint64_t west, east;
+    shifted(cells, w, west, east);
+    const uint64_t word = cells[w];
+    const uint64_t half = west ^ word;
+    ones = half ^ east;
+    twos = (west & word) | (half & east);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // Add up the 3x3 block around every cell in the word, center
+  // included. A cell is alive next time if that comes to 3, or if it
+  // comes to 4 and the cell is already alive, which is B3/S23.
+  ////////////////////////////////////////////////////////////////////////
+  inline uint64_t nextWord(const uint64_t* above, const uint64_t* middle, const uint64_t* below, int w) const
+  {
+    uint64_t a0, a1, b0, b1, c0, c1;
+    threeSum(above, w, a0, a1);
+    threeSum(middle, w, b0, b1);
+    threeSum(below, w, c0, c1);
+
+    // ones column, carrying into the twos
+    const uint64_t ones = a0 ^ b0 ^ c0;
+    const uint64_t carry = (a0 & b0) | (c0 & (a0 ^ b0));
+
+    // the twos column has four bits to add, a1, b1, c1 and carry,
+    // and the total can only be 3 or 4 when they add up to 1 or 2.
+    // Pair them off first.
+    const uint64_t pairAB = a1 ^ b1, bothAB = a1 & b1;
+    const uint64_t pairCD = c1 ^ carry, bothCD = c1 & carry;
+    const uint64_t odd = pairAB ^ pairCD;
+    const uint64_t bothPairs = pairAB & pairCD;
+
+    // at most two of these can be set, since all four bits set
+    // leaves the pairs empty
+    const uint64_t anyFours = bothAB | bothCD | bothPairs;
+    const uint64_t oneFour = bothAB ^ bothCD ^ bothPairs;
+
+    const uint64_t three = ones & odd & ~anyFours;
+    const uint64_t four = ~ones & ~odd & oneFour;
+    return three | (four & middle[w]);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // step one tile, and note whether anything in it changed
+  ////////////////////////////////////////////////////////////////////////
+  void stepTile(int tile)
+  {
+    const int w = tile % _xTiles;
+    const int yBegin = (tile / _xTiles) * LIFE_2D_TILE;
+    const int yEnd = (yBegin + LIFE_2D_TILE < _yRes) ? yBegin + LIFE_2D_TILE : _yRes;
+    const uint64_t mask = (w == _words - 1) ? _lastMask : ~(uint64_t)0;
+
+    // slide a window of three rows down the tile
+    const uint64_t* above = row((yBegin + _yRes - 1) % _yRes);
+    const uint64_t* middle = row(yBegin);
+    uint64_t* next = &_next[(size_t)yBegin * _words];
+
+    uint64_t changed = 0;
+    for (int y = yBegin; y < yEnd; y++)
+    {
+      const uint64_t* below = (y + 1 < _yRes) ? middle + _words : row(0);
+      const uint64_t word = nextWord(above, middle, below, w) & mask;
+      changed |= word ^ middle[w];
+      next[w] = word;
+
+      above = middle;
+      middle = below;
+      next += _words;
+    }
+    _nextChanged[tile] = (changed != 0);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // step a whole row of tiles, a row of cells at a time
+  ////////////////////////////////////////////////////////////////////////
+  void stepTileRow(int tileRow)
+  {
+    const int yBegin = tileRow * LIFE_2D_TILE;
+    const int yEnd = (yBegin + LIFE_2D_TILE < _yRes) ? yBegin + LIFE_2D_TILE : _yRes;
+
+    std::vector<uint64_t> changed(_words, 0);
+    for (int y = yBegin; y < yEnd; y++)
+    {
+      const uint64_t* above = row((y + _yRes - 1) % _yRes);
+      const uint64_t* middle = row(y);
+      const uint64_t* below = row((y + 1) % _yRes);
+      uint64_t* next = &_next[(size_t)y * _words];
+
+      for (int w = 0; w < _words; w++)
+        next[w] = nextWord(above, middle, below, w);
+      next[_words - 1] &= _lastMask;
+
+      // a separate pass, while the row is still in cache, so the loop
+      // above stays as tight as a plain row step
+      for (int w = 0; w < _words; w++)
+        changed[w] |= next[w] ^ middle[w];
+    }
+
+    for (int w = 0; w < _words; w++)
+      _nextChanged[tileRow * _xTiles + w] = (changed[w] != 0);
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// unpack into a FIELD_2D of 0s and 1s, for display
+///////////////////////////////////////////////////////////////////////
+inline void FIELD_2D_CONVERT(const LIFE_2D& input, FIELD_2D& output)
+{
+  if (output.xRes() != input.xRes() || output.yRes() != input.yRes())
+    output.resizeAndWipe(input.xRes(), input.yRes());
+
+  const int xRes = input.xRes();
+  THREAD_POOL::shared().parallelFor(input.yRes(), [&](int begin, int end) {
+    std::vector<float> scratch(xRes);
+    for (int y = begin; y < end; y++)
+    {
+      float* values = output.rowMajor() ? output.row(y) : &scratch[0];
+      const uint64_t* cells = input.row(y);
+      for (int x = 0; x < xRes; x++)
+        values[x] = (float)((cells[x >> 6] >> (x & 63)) & 1);
+      if (!output.rowMajor())
+        output.setRun(0, y, xRes, &scratch[0]);
+    }
+  }, 65536 / (xRes > 0 ? xRes : 1) + 1);
+}
+
+///////////////////////////////////////////////////////////////////////
+// pack a FIELD_2D, where anything brighter than half is alive
+///////////////////////////////////////////////////////////////////////
+inline void FIELD_2D_CONVERT(const FIELD_2D& input, LIFE_2D& output)
+{
+  if (output.xRes() != input.xRes() || output.yRes() != input.yRes())
+    output.resizeAndWipe(input.xRes(), input.yRes());
+
+  const int xRes = input.xRes();
+  THREAD_POOL::shared().parallelFor(input.yRes(), [&](int begin, int end) {
+    std::vector<float> scratch(xRes);
+    for (int y = begin; y < end; y++)
+    {
+      const float* values = &scratch[0];
+      if (input.rowMajor())
+        values = input.row(y);
+      else
+        input.getRun(0, y, xRes, &scratch[0]);
+
+      uint64_t* cells = output.row(y);
+      for (int w = 0; w < output.words(); w++)
+      {
+        uint64_t word = 0;
+        const int last = (64 * w + 64 < xRes) ? 64 : xRes - 64 * w;
+        for (int bit = 0; bit < last; bit++)
+          word |= (uint64_t)(values[64 * w + bit] >= 0.5f) << bit;
+        cells[w] = word;
+      }
+    }
+  }, 65536 / (xRes > 0 ? xRes : 1) + 1);
+  output.wake();
+}
+
+#endif
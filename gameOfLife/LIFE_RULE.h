@@ -0,0 +1,397 @@
+#ifndef LIFE_RULE_H
+#define LIFE_RULE_H
+
+///////////////////////////////////////////////////////////////////////
+// Life-like and Larger-than-Life rules, parsed from the usual
+// rulestrings and compiled into a lookup table indexed by a cell's
+// state and its neighbor count, so stepping never branches on the
+// rule:
+//
+//   LIFE_RULE rule("B36/S23");
+//   rule.step(cells, next);
+//   cells.swap(next);
+//
+// cells and next are BYTE_FIELD_2Ds where anything nonzero is alive,
+// and the board wraps around into a torus, like LIFE_2D. Both kinds
+// of rulestring are understood:
+//
+//   B3/S23, b3s23, S23/B3, 23/3          Life-like, the 8 neighbors
+//   R5,C0,M1,S34..58,B34..45,NM          Larger-than-Life
+//
+// Larger-than-Life counts everything in the (2R+1) x (2R+1) box around
+// a cell, the cell itself too if M is 1. Those counts come out of a
+// summed-area table, four lookups a cell no matter what R is, so big
+// radii cost the same per cell as small ones. Only two states (C0 or
+// C2) and the box neighborhood (NM) are supported.
+//
+// parse() says what it didn't like and keeps the rule it had, which
+// starts out as B3/S23. That includes rules with no counts at all, like
+// an empty string, which would just kill every cell.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D_TYPED.h"
+#include "THREAD_POOL.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// the biggest Larger-than-Life radius parse() takes
+#define LIFE_RULE_MAX_RADIUS 500
+
+class LIFE_RULE {
+public:
+  LIFE_RULE(const char* rulestring = "B3/S23") :
+    _radius(1), _middle(0)
+  {
+    if (!parse(rulestring))
+    {
+      if (rulestring != NULL)
+        printf(" %s %s %i : Running B3/S23 instead\n", __FILE__, __FUNCTION__, __LINE__);
+      parse("B3/S23");
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // compile a rulestring, returning false and keeping the old rule if
+  // it doesn't make sense
+  ////////////////////////////////////////////////////////////////////////
+  bool parse(const char* rulestring)
+  {
+    if (rulestring == NULL)
+      return false;
+
+    // everything is case and space insensitive
+    std::string rule;
+    for (const char* c = rulestring; *c != '\0'; c++)
+      if (!isspace((unsigned char)*c))
+        rule += (char)toupper((unsigned char)*c);
+
+    const bool largerThanLife = rule.size() > 1 && rule[0] == 'R' && isdigit((unsigned char)rule[1]);
+    const bool parsed = largerThanLife ? parseLargerThanLife(rule) : parseLifeLike(rule);
+    if (!parsed)
+    {
+      printf(" %s %s %i : Couldn't parse rule %s\n", __FILE__, __FUNCTION__, __LINE__, rulestring);
+      return false;
+    }
+    return true;
+  };
+
+  // the rule, written back out in its canonical form
+  const std::string& name() const { return _name; };
+
+  // cells out from the center the neighborhood reaches
+  const int radius() const { return _radius; };
+
+  // is it plain B3/S23, which LIFE_2D and HASHLIFE run faster?
+  bool conway() const { return _name == "B3/S23"; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // what a cell in state (0 or 1) becomes with count neighbors
+  ////////////////////////////////////////////////////////////////////////
+  inline unsigned char next(int state, int count) const
+  {
+    return _table[state * _counts + count];
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // advance a generation from cells into next
+  ////////////////////////////////////////////////////////////////////////
+  void step(const BYTE_FIELD_2D& cells, BYTE_FIELD_2D& next)
+  {
+    if (next.xRes() != cells.xRes() || next.yRes() != cells.yRes())
+      next.resizeAndWipe(cells.xRes(), cells.yRes());
+    if (cells.xRes() == 0 || cells.yRes() == 0)
+      return;
+
+    if (_radius == 1)
+      stepMoore(cells, next);
+    else
+      stepSummed(cells, next);
+  };
+
+private:
+  int _radius;
+
+  // 1 if a cell counts itself
+  int _middle;
+
+  // rows of the table, one per state, each with every possible count
+  int _counts;
+  std::vector<unsigned char> _table;
+
+  std::string _name;
+
+  // the summed-area table, (xRes + 2 * _radius + 1) wide, and the
+  // source row of each padded row
+  std::vector<int> _summed;
+  std::vector<int> _sourceRows;
+
+  ////////////////////////////////////////////////////////////////////////
+  // lay out a table where nothing is born and nothing survives
+  ////////////////////////////////////////////////////////////////////////
+  static void emptyTable(int radius, std::vector<unsigned char>& table, int& counts)
+  {
+    counts = (2 * radius + 1) * (2 * radius + 1) + 1;
+    table.assign(2 * counts, 0);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // B3/S23, S23/B3, or the old 23/3 survival/birth form
+  ////////////////////////////////////////////////////////////////////////
+  bool parseLifeLike(const std::string& rule)
+  {
+    std::vector<unsigned char> table;
+    int counts;
+    emptyTable(1, table, counts);
+
+    // which half of the table the digits are going into, -1 before a
+    // letter or slash has said
+    const bool lettered = rule.find('B') != std::string::npos || rule.find('S') != std::string::npos;
+    int state = lettered ? -1 : 1;
+
+    // each half can only be given once, and something has to be in one
+    bool given[2] = { false, !lettered };
+    bool counted = false;
+    for (unsigned int x = 0; x < rule.size(); x++)
+    {
+      const char c = rule[x];
+      if (c == 'B' || c == 'S')
+      {
+        state = (c == 'B') ? 0 : 1;
+        if (given[state]) return false;
+        given[state] = true;
+      }
+      else if (c == '/')
+      {
+        // the unlettered form goes survival then birth
+        if (lettered) continue;
+        if (given[0]) return false;
+        state = 0;
+        given[0] = true;
+      }
+      else if (c >= '0' && c <= '8' && state >= 0)
+      {
+        table[state * counts + (c - '0')] = 1;
+        counted = true;
+      }
+      else
+        return false;
+    }
+    if (!counted)
+      return false;
+
+    _radius = 1;
+    _middle = 0;
+    _counts = counts;
+    _table.swap(table);
+
+    _name = "B";
+    for (int x = 0; x <= 8; x++)
+      if (_table[x]) _name += (char)('0' + x);
+    _name += "/S";
+    for (int x = 0; x <= 8; x++)
+      if (_table[_counts + x]) _name += (char)('0' + x);
+    return true;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // Rr,Cc,Mm,Smin..max,Bmin..max,Nn, in any order
+  ////////////////////////////////////////////////////////////////////////
+  bool parseLargerThanLife(const std::string& rule)
+  {
+    int radius = 1, states = 0, middle = 0;
+    int survive[2] = { 1, 0 }, birth[2] = { 1, 0 };
+
+    size_t start = 0;
+    while (start <= rule.size())
+    {
+      size_t end = rule.find(',', start);
+      if (end == std::string::npos) end = rule.size();
+      const std::string field = rule.substr(start, end - start);
+      start = end + 1;
+
+      if (field.empty())
+        return false;
+
+      const char* value = field.c_str() + 1;
+      switch (field[0])
+      {
+        case 'R': if (!parseNumber(value, radius)) return false; break;
+        case 'C': if (!parseNumber(value, states)) return false; break;
+        case 'M': if (!parseNumber(value, middle)) return false; break;
+        case 'S': if (!parseRange(value, survive)) return false; break;
+        case 'B': if (!parseRange(value, birth)) return false; break;
+        case 'N':
+          // only the box, the diamond doesn't fall out of one table
+          if (field != "NM") return false;
+          break;
+        default:
+          return false;
+      }
+    }
+
+    // C0 and C2 both mean two states
+    if (radius < 1 || radius > LIFE_RULE_MAX_RADIUS || (states != 0 && states != 2) || middle > 1)
+      return false;
+
+    std::vector<unsigned char> table;
+    int counts;
+    emptyTable(radius, table, counts);
+
+    // a count can't go past everything in the box
+    for (int x = birth[0]; x <= birth[1] && x < counts; x++)
+      table[x] = 1;
+    for (int x = survive[0]; x <= survive[1] && x < counts; x++)
+      table[counts + x] = 1;
+
+    _radius = radius;
+    _middle = middle;
+    _counts = counts;
+    _table.swap(table);
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "R%i,C0,M%i,S%i..%i,B%i..%i,NM",
+             radius, middle, survive[0], survive[1], birth[0], birth[1]);
+    _name = buffer;
+    return true;
+  };
+
+  static bool parseNumber(const char* value, int& number)
+  {
+    char* end;
+    const long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || parsed < 0 || parsed > 1 << 24)
+      return false;
+    number = (int)parsed;
+    return true;
+  };
+
+  // "min..max", or a single count
+  static bool parseRange(const char* value, int range[2])
+  {
+    const std::string both(value);
+    const size_t dots = both.find("..");
+    if (dots == std::string::npos)
+    {
+      if (!parseNumber(value, range[0])) return false;
+      range[1] = range[0];
+      return true;
+    }
+    return parseNumber(both.substr(0, dots).c_str(), range[0]) &&
+           parseNumber(both.substr(dots + 2).c_str(), range[1]);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // radius 1 adds up the 3x3 block directly, which beats building a
+  // summed-area table. The table takes the count without the center.
+  ////////////////////////////////////////////////////////////////////////
+  void stepMoore(const BYTE_FIELD_2D& cells, BYTE_FIELD_2D& next) const
+  {
+    const int xRes = cells.xRes();
+    const int yRes = cells.yRes();
+    const unsigned char* table = &_table[0];
+    const int counts = _counts;
+    const int notMiddle = 1 - _middle;
+
+    THREAD_POOL::shared().parallelFor(yRes, [&](int begin, int end) {
+      for (int y = begin; y < end; y++)
+      {
+        const unsigned char* above = cells.row((y + yRes - 1) % yRes);
+        const unsigned char* middle = cells.row(y);
+        const unsigned char* below = cells.row((y + 1) % yRes);
+        unsigned char* output = next.row(y);
+
+        for (int x = 0; x < xRes; x++)
+        {
+          const int left = (x == 0) ? xRes - 1 : x - 1;
+          const int right = (x == xRes - 1) ? 0 : x + 1;
+          const int state = middle[x] != 0;
+          const int sum = (above[left] != 0) + (above[x] != 0) + (above[right] != 0) +
+                          (middle[left] != 0) + state + (middle[right] != 0) +
+                          (below[left] != 0) + (below[x] != 0) + (below[right] != 0);
+          output[x] = table[state * counts + sum - notMiddle * state];
+        }
+      }
+    }, 16);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // Build a summed-area table over the board padded out by the radius
+  // on every side, wrapping around, so every box sum is four lookups
+  // with no edge cases.
+  ////////////////////////////////////////////////////////////////////////
+  void stepSummed(const BYTE_FIELD_2D& cells, BYTE_FIELD_2D& next)
+  {
+    const int xRes = cells.xRes();
+    const int yRes = cells.yRes();
+    const int r = _radius;
+    const int width = xRes + 2 * r + 1;
+    const int height = yRes + 2 * r + 1;
+
+    _summed.resize((size_t)width * height);
+    _sourceRows.resize(height);
+    for (int y = 1; y < height; y++)
+      _sourceRows[y] = ((y - 1 - r) % yRes + yRes) % yRes;
+
+    // the first row and column stay zero, then each row gets summed
+    // across on its own
+    int* summed = &_summed[0];
+    for (int x = 0; x < width; x++)
+      summed[x] = 0;
+    THREAD_POOL::shared().parallelFor(height - 1, [&](int begin, int end) {
+      for (int y = begin + 1; y < end + 1; y++)
+      {
+        const unsigned char* source = cells.row(_sourceRows[y]);
+        int* row = summed + (size_t)y * width;
+        row[0] = 0;
+        int total = 0;
+        int column = ((-r) % xRes + xRes) % xRes;
+        for (int x = 1; x < width; x++)
+        {
+          total += source[column] != 0;
+          row[x] = total;
+          column = (column == xRes - 1) ? 0 : column + 1;
+        }
+      }
+    }, 16);
+
+    // then down, in strips of columns
+    THREAD_POOL::shared().parallelFor(width, [&](int begin, int end) {
+      for (int y = 1; y < height; y++)
+      {
+        int* row = summed + (size_t)y * width;
+        const int* previous = row - width;
+        for (int x = begin; x < end; x++)
+          row[x] += previous[x];
+      }
+    }, 256);
+
+    const unsigned char* table = &_table[0];
+    const int counts = _counts;
+    const int notMiddle = 1 - _middle;
+    const int side = 2 * r + 1;
+
+    THREAD_POOL::shared().parallelFor(yRes, [&](int begin, int end) {
+      for (int y = begin; y < end; y++)
+      {
+        // the box around (x, y) covers padded rows y .. y + 2r, which
+        // sit between summed rows y and y + 2r + 1
+        const int* top = summed + (size_t)y * width;
+        const int* bottom = top + (size_t)side * width;
+        const unsigned char* middle = cells.row(y);
+        unsigned char* output = next.row(y);
+
+        for (int x = 0; x < xRes; x++)
+        {
+          const int sum = bottom[x + side] - bottom[x] - top[x + side] + top[x];
+          const int state = middle[x] != 0;
+          output[x] = table[state * counts + sum - notMiddle * state];
+        }
+      }
+    }, 16);
+  };
+};
+
+#endif
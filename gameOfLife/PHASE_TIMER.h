@@ -0,0 +1,191 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+///////////////////////////////////////////////////////////////////////
+// Times the named phases of a frame (stepping, uploading, drawing,
+// capturing...) so it's obvious which one the frame rate is waiting
+// on. Wrap each phase in a scope:
+//
+//   {
+//     PHASE_TIMER::SCOPE scope(timings, "updateTexture");
+//     updateTexture(field);
+//   }
+//
+// Each phase keeps its last 256 samples, and lines() summarizes them
+// as p50/p95/p99 in milliseconds, one line per phase in the order
+// they were first seen, for printGlString() to put on screen. Phases
+// can nest, and they can be timed from the simulation thread too, see
+// SIMULATION_THREAD.h, since adding a sample takes a lock.
+//
+// If PHASE_TIMER_CSV is set, e.g.
+//
+//   PHASE_TIMER_CSV=timings.csv ./fieldViewer
+//
+// a summary of every phase gets written there on exit. The mean and
+// max are over the whole run, the percentiles over the last samples.
+///////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class PHASE_TIMER {
+public:
+  PHASE_TIMER(int window = 256) : _window(window), _showing(false) {};
+
+  ~PHASE_TIMER()
+  {
+    const char* filename = getenv("PHASE_TIMER_CSV");
+    if (filename != NULL && filename[0] != '\0')
+      writeCSV(filename);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // times from construction to destruction, on a monotonic clock
+  ////////////////////////////////////////////////////////////////////////
+  class SCOPE {
+  public:
+    SCOPE(PHASE_TIMER& timer, const char* phase) :
+      _timer(timer), _phase(phase), _start(std::chrono::steady_clock::now()) {};
+
+    ~SCOPE()
+    {
+      const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+      _timer.add(_phase, std::chrono::duration<double, std::milli>(end - _start).count());
+    };
+
+  private:
+    PHASE_TIMER& _timer;
+    const char* _phase;
+    std::chrono::steady_clock::time_point _start;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // record a sample, in milliseconds
+  ////////////////////////////////////////////////////////////////////////
+  void add(const char* phase, double milliseconds)
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    PHASE& found = find(phase);
+
+    if ((int)found.samples.size() < _window)
+      found.samples.push_back(milliseconds);
+    else
+      found.samples[found.next] = milliseconds;
+    found.next = (found.next + 1) % _window;
+
+    found.count++;
+    found.total += milliseconds;
+    found.max = std::max(found.max, milliseconds);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // one summary line per phase, for the overlay
+  ////////////////////////////////////////////////////////////////////////
+  std::vector<std::string> lines()
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    std::vector<std::string> final;
+    char buffer[256];
+    for (unsigned int x = 0; x < _phases.size(); x++)
+    {
+      double p50, p95, p99;
+      percentiles(_phases[x].samples, p50, p95, p99);
+      snprintf(buffer, sizeof(buffer), "%s: %.3f / %.3f / %.3f ms",
+               _phases[x].name.c_str(), p50, p95, p99);
+      final.push_back(buffer);
+    }
+    return final;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // write a row per phase, returning false if the file didn't open
+  ////////////////////////////////////////////////////////////////////////
+  bool writeCSV(const char* filename)
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    FILE* file = fopen(filename, "w");
+    if (file == NULL)
+    {
+      printf(" %s %s %i : Couldn't open %s\n", __FILE__, __FUNCTION__, __LINE__, filename);
+      return false;
+    }
+
+    fprintf(file, "phase,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+    for (unsigned int x = 0; x < _phases.size(); x++)
+    {
+      const PHASE& phase = _phases[x];
+      double p50, p95, p99;
+      percentiles(phase.samples, p50, p95, p99);
+      fprintf(file, "%s,%li,%.4f,%.4f,%.4f,%.4f,%.4f\n", phase.name.c_str(), phase.count,
+              phase.total / phase.count, p50, p95, p99, phase.max);
+    }
+    fclose(file);
+    return true;
+  };
+
+  // is the overlay up?
+  bool showing() const { return _showing; };
+  void toggle() { _showing = !_showing; };
+
+private:
+  struct PHASE {
+    PHASE(const char* phaseName) :
+      name(phaseName), next(0), count(0), total(0.0), max(0.0) {};
+
+    std::string name;
+    std::vector<double> samples;
+    int next;
+    long count;
+    double total;
+    double max;
+  };
+
+  int _window;
+  bool _showing;
+  std::vector<PHASE> _phases;
+  std::mutex _lock;
+
+  ////////////////////////////////////////////////////////////////////////
+  // there's only ever a handful, so a linear search is plenty
+  ////////////////////////////////////////////////////////////////////////
+  PHASE& find(const char* phase)
+  {
+    for (unsigned int x = 0; x < _phases.size(); x++)
+      if (strcmp(_phases[x].name.c_str(), phase) == 0)
+        return _phases[x];
+
+    _phases.push_back(PHASE(phase));
+    return _phases.back();
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // nearest-rank percentiles of a copy of the samples
+  ////////////////////////////////////////////////////////////////////////
+  static void percentiles(std::vector<double> samples, double& p50, double& p95, double& p99)
+  {
+    p50 = p95 = p99 = 0.0;
+    if (samples.empty())
+      return;
+
+    p50 = rank(samples, 0.50);
+    p95 = rank(samples, 0.95);
+    p99 = rank(samples, 0.99);
+  };
+
+  static double rank(std::vector<double>& samples, double fraction)
+  {
+    const int size = samples.size();
+    const int index = std::min(size - 1, std::max(0, (int)ceil(fraction * size) - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+  };
+};
+
+#endif
@@ -1,10 +1,18 @@
 #include <cmath>
 #include "FIELD_2D.h"
+#include "LIFE_2D.h"
+#include "HASHLIFE.h"
+#include "LIFE_RULE.h"
 #include "VEC3F.h"
 #include <iostream>
 #include "QUICKTIME_MOVIE.h"
 #include "MERSENNE_TWISTER.h"
 #include "TimeStamper.h"
+#include "HEADLESS.h"
+#include "FIELD_2D_TEXTURE.h"
+#include "PHASE_TIMER.h"
+#include "FIELD_2D_TRIPLE.h"
+#include "SIMULATION_THREAD.h"
 
 #if _WIN32
 #include <gl/glut.h>
@@ -15,13 +23,38 @@
 using namespace std;
 
 
-// resolution of the field
-int xRes = 100;
-int yRes = 100;
+// resolution of the field, big enough for the pulsars runOnce() seeds
+int xRes = HEADLESS::xRes(100, 92);
+int yRes = HEADLESS::yRes(100, 92);
 
-// the field being drawn and manipulated
+// the board, 64 cells to a word, see LIFE_2D.h
+LIFE_2D cells(xRes, yRes);
+
+// the same board as an infinite plane, for jumping far ahead, see
+// HASHLIFE.h
+HASHLIFE hashlife;
+
+// step hashlife instead of cells?
+bool hashLifing = false;
+
+// hashlife takes 2^hashLifeExponent generations per frame
+int hashLifeExponent = 0;
+
+// the rule to run, from the environment, e.g.
+//
+//   LIFE_RULE=B36/S23 ./fieldViewer
+//   LIFE_RULE=R5,C0,M1,S34..58,B34..45,NM ./fieldViewer
+//
+// Anything but B3/S23 gets stepped a byte per cell in ruleCells, since
+// cells and hashlife only know B3/S23. See LIFE_RULE.h
+LIFE_RULE rule(getenv("LIFE_RULE"));
+bool ruling = !rule.conway();
+BYTE_FIELD_2D ruleCells;
+BYTE_FIELD_2D ruleNext;
+
+// the field being drawn, converted from cells every generation.
+// Patterns get drawn here too, then packed into cells.
 FIELD_2D field(xRes, yRes);
-FIELD_2D next(xRes, yRes);
 // the resolution of the OpenGL window -- independent of the field resolution
 int xScreenRes = 850;
 int yScreenRes = 850;
@@ -61,6 +94,27 @@ float zoom = 1.0;
 // Quicktime movie to capture to
 QUICKTIME_MOVIE movie;
 
+// the field as a GL texture, see FIELD_2D_TEXTURE.h
+FIELD_2D_TEXTURE fieldTexture;
+
+// tiles of cells that changed since the last frame was published
+vector<unsigned char> dirtyTiles;
+
+// finished frames, handed from the simulation thread to the display
+FIELD_2D_TRIPLE<FIELD_2D> frames(xRes, yRes);
+
+// tiles that changed in any frame published since the display last
+// picked one up. Both sides hold publishLock while handing frames
+// over, so these always go with the frame the display ends up with.
+vector<unsigned char> publishedTiles;
+mutex publishLock;
+
+// per-phase timings, shown with 't', see PHASE_TIMER.h
+PHASE_TIMER timings;
+
+// runs runEverytime() off of the GL thread, see SIMULATION_THREAD.h
+SIMULATION_THREAD simulation;
+
 // a random number generator
 MERSENNE_TWISTER twister(123456);
 
@@ -71,6 +125,9 @@ void runOnce();
 // forward declare the timestepping function here so that we can
 // put it at the bottom of the file
 void runEverytime();
+
+// copy the field over for the display, see SIMULATION_THREAD.h
+void publishFrame();
 int frameCounter = 0;
 struct Algo {
     
@@ -177,23 +234,34 @@ void printGlString(string output)
 }
 
 ///////////////////////////////////////////////////////////////////////
-// dump the field contents to a GL texture for drawing
+// add the tiles the last step (or edit) changed to dirtyTiles, since
+// there can be more than one step between publishes
 ///////////////////////////////////////////////////////////////////////
-void updateTexture(FIELD_2D& texture)
+void markDirtyTiles()
 {
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, 3, 
-                 texture.xRes(), 
-                 texture.yRes(), 0, 
-                 GL_LUMINANCE, GL_FLOAT, 
-                 texture.data());
-    
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-    glEnable(GL_TEXTURE_2D);
+    const vector<unsigned char>& changed = cells.changedTiles();
+    if (dirtyTiles.size() != changed.size())
+        dirtyTiles.assign(changed.size(), 1);
+    for (unsigned int x = 0; x < changed.size(); x++)
+        dirtyTiles[x] |= changed[x];
+}
+
+///////////////////////////////////////////////////////////////////////
+// bring the GL texture up to date with the field, only sending
+// what changed, see FIELD_2D_TEXTURE.h
+///////////////////////////////////////////////////////////////////////
+void updateTexture(const FIELD_2D& texture, const vector<unsigned char>& tiles)
+{
+    PHASE_TIMER::SCOPE scope(timings, "updateTexture");
+
+    if (hashLifing || ruling)
+    {
+        fieldTexture.upload(texture);
+        return;
+    }
+
+    // only look at the tiles the packed engine says it touched
+    fieldTexture.upload(texture, tiles, LIFE_2D_TILE, LIFE_2D_TILE);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -201,6 +269,8 @@ void updateTexture(FIELD_2D& texture)
 ///////////////////////////////////////////////////////////////////////
 void drawGrid()
 {
+    PHASE_TIMER::SCOPE scope(timings, "drawGrid");
+
     glColor4f(0.1, 0.1, 0.1, 1.0);
     
     float dx = 1.0 / xRes;
@@ -212,12 +282,12 @@ void drawGrid()
         dy *= (float)yRes / xRes;
     
     glBegin(GL_LINES);
-    for (int x = 0; x < field.xRes() + 1; x++)
+    for (int x = 0; x < frames.front().xRes() + 1; x++)
     {
         glVertex3f(x * dx, 0, 1);
         glVertex3f(x * dx, 1, 1);
     }
-    for (int y = 0; y < field.yRes() + 1; y++)
+    for (int y = 0; y < frames.front().yRes() + 1; y++)
     {
         glVertex3f(0, y * dy, 1);
         glVertex3f(1, y * dy, 1);
@@ -225,11 +295,31 @@ void drawGrid()
     glEnd();
 }
 
+///////////////////////////////////////////////////////////////////////
+// print the per-phase timings down the top left corner
+///////////////////////////////////////////////////////////////////////
+void drawTimings()
+{
+    glLoadIdentity();
+    float halfZoom = 0.5 * zoom;
+
+    vector<string> lines = timings.lines();
+    for (unsigned int x = 0; x < lines.size(); x++)
+    {
+        // must set color before setting raster position, otherwise it won't take
+        glColor4f(1.0f, 0.0f, 0.0f, 1.0f);
+        glRasterPos3f(-halfZoom * 0.95, halfZoom * (0.9 - 0.06 * x), 0);
+        printGlString(lines[x]);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////
 // GL and GLUT callbacks
 ///////////////////////////////////////////////////////////////////////
 void glutDisplay()
 {
+    PHASE_TIMER::SCOPE scope(timings, "glutDisplay");
+
     // Make ensuing transforms affect the projection matrix
     glMatrixMode(GL_PROJECTION);
     
@@ -258,14 +348,7 @@ void glutDisplay()
     if (yRes < xRes)
         yLength = (float)yRes / xRes;
     
-    glEnable(GL_TEXTURE_2D); 
-    glBegin(GL_QUADS);
-    glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, 0.0);
-    glTexCoord2f(0.0, 1.0); glVertex3f(0.0, yLength, 0.0);
-    glTexCoord2f(1.0, 1.0); glVertex3f(xLength, yLength, 0.0);
-    glTexCoord2f(1.0, 0.0); glVertex3f(xLength, 0.0, 0.0);
-    glEnd();
-    glDisable(GL_TEXTURE_2D); 
+    fieldTexture.draw(xLength, yLength);
     
     // draw the grid, but only if the user wants
     if (drawingGrid)
@@ -273,7 +356,7 @@ void glutDisplay()
     
     // if there's a valid field index, print it
     if (xField >= 0 && yField >= 0 &&
-        xField < field.xRes() && yField < field.yRes())
+        xField < frames.front().xRes() && yField < frames.front().yRes())
     {
         glLoadIdentity();
         
@@ -291,7 +374,7 @@ void glutDisplay()
         fieldValue = fieldValue + string(buffer);
         sprintf(buffer, "%i", yField);
         fieldValue = fieldValue + string(", ") + string(buffer) + string(") = ");
-        sprintf(buffer, "%f", field(xField, yField));
+        sprintf(buffer, "%f", frames.front()(xField, yField));
         fieldValue = fieldValue + string(buffer);
         
         // draw the grid, but only if the user wants
@@ -301,8 +384,15 @@ void glutDisplay()
     
     // if we're recording a movie, capture a frame
     if (captureMovie)
-        movie.addFrameGL();
+    {
+        PHASE_TIMER::SCOPE scope(timings, "movie");
+        movie.addFrameFIELD_2D(frames.front());
+    }
     
+    // print the phase timings, but only if the user wants
+    if (timings.showing())
+        drawTimings();
+
     glutSwapBuffers();
 }
 
@@ -315,10 +405,14 @@ void printCommands()
     cout << "=============================================================== " << endl;
     cout << " q           - quit" << endl;
     cout << " v           - type the value of the cell under the mouse" << endl;
+    cout << " k           - cycle through the colormaps" << endl;
     cout << " g           - throw a grid over everything" << endl;
+    cout << " t           - time each part of a frame, see PHASE_TIMER.h" << endl;
     cout << " m           - start/stop capturing a movie" << endl;
     cout << " r           - read in a PNG file " << endl;
     cout << " w           - write out a PNG file " << endl;
+    cout << " h           - switch between the packed and HashLife engines" << endl;
+    cout << " +/-         - double/halve the HashLife generations per frame" << endl;
     cout << " left mouse  - pan around" << endl;
     cout << " right mouse - zoom in and out " << endl;
     cout << " shift left mouse - draw on the grid " << endl;
@@ -353,6 +447,7 @@ void glutKeyboard(unsigned char key, int x, int y)
     {
         case 'a':
             animate = !animate;
+            simulation.setRunning(animate);
             break;
         case 'g':
             drawingGrid = !drawingGrid;
@@ -360,6 +455,9 @@ void glutKeyboard(unsigned char key, int x, int y)
         case '?':
             printCommands();
             break;
+        case 'k':
+            cout << " Colormap: " << fieldTexture.nextColormap() << endl;
+            break;
         case 'v':
             drawingValues = !drawingValues;
             break;
@@ -379,20 +477,76 @@ void glutKeyboard(unsigned char key, int x, int y)
             else
             {
                 cout << " Starting to capture movie. " << endl;
+                movie.streamTo("movie.mov");
                 captureMovie = true;
             }
             break;
         case 'r':
+        {
+            lock_guard<mutex> guard(simulation.lock());
             field.readPNG("lena.png");
             xRes = field.xRes();
             yRes = field.yRes();
+
+            // anything brighter than half is alive, and the field
+            // should only hold 0s and 1s from here on, since steps only
+            // unpack the tiles that changed
+            FIELD_2D_CONVERT(field, cells);
+            FIELD_2D_CONVERT(cells, field);
+            FIELD_2D_CONVERT(field, ruleCells);
+            cells.wake();
+            if (hashLifing)
+                hashlife.setCells(field);
+        }
+            simulation.refresh();
+            break;
+        case 'h':
+            if (ruling)
+            {
+                cout << " HashLife only runs B3/S23, not " << rule.name() << endl;
+                break;
+            }
+
+            // carry over whatever is on screen
+            {
+                lock_guard<mutex> guard(simulation.lock());
+                hashLifing = !hashLifing;
+                if (hashLifing)
+                {
+                    hashlife.setCells(field);
+                    cout << " HashLife, 2^" << hashLifeExponent << " generations per frame" << endl;
+                }
+                else
+                {
+                    FIELD_2D_CONVERT(field, cells);
+                    cells.wake();
+                    cout << " Packed engine, 1 generation per frame" << endl;
+                }
+            }
+            simulation.refresh();
+            break;
+        case '+':
+        case '=':
+        case '-':
+        {
+            lock_guard<mutex> guard(simulation.lock());
+            hashLifeExponent += (key == '-') ? -1 : 1;
+            hashLifeExponent = (hashLifeExponent < 0) ? 0 : hashLifeExponent;
+            hashLifeExponent = (hashLifeExponent > 56) ? 56 : hashLifeExponent;
+            cout << " HashLife generations per frame: 2^" << hashLifeExponent
+                 << ", at generation " << hashlife.generation() << endl;
+        }
             break;
         case 'w':
         {
             TimeStamper ts;
+            lock_guard<mutex> guard(simulation.lock());
             field.writePNG(ts.timestampedFilename("output",".png"));
         }
             break;
+        case 't':
+            timings.toggle();
+            break;
         case 'q':
             exit(0);
             break;
@@ -417,7 +571,15 @@ void glutMouseClick(int button, int state, int x, int y)
         refreshMouseFieldIndex(x,y);
         
         // set the cell
-        field(xField, yField) = 1;
+        {
+            lock_guard<mutex> guard(simulation.lock());
+            cells.set(xField, yField, true);
+            if (hashLifing)
+                hashlife.set(xField, yField, true);
+            ruleCells(xField, yField) = 1;
+            field(xField, yField) = 1;
+        }
+        simulation.refresh();
         
         // make sure nothing else is called
         return;
@@ -440,7 +602,15 @@ void glutMouseMotion(int x, int y)
         refreshMouseFieldIndex(x,y);
         
         // set the cell
-        field(xField, yField) = 1;
+        {
+            lock_guard<mutex> guard(simulation.lock());
+            cells.set(xField, yField, true);
+            if (hashLifing)
+                hashlife.set(xField, yField, true);
+            ruleCells(xField, yField) = 1;
+            field(xField, yField) = 1;
+        }
+        simulation.refresh();
         
         // make sure nothing else is called
         return;
@@ -470,16 +640,36 @@ void glutPassiveMouseMotion(int x, int y)
     refreshMouseFieldIndex(x,y);
 }
 
+///////////////////////////////////////////////////////////////////////
+// runEverytime(), timed for the overlay
+///////////////////////////////////////////////////////////////////////
+void timedRunEverytime()
+{
+    PHASE_TIMER::SCOPE scope(timings, "runEverytime");
+    runEverytime();
+}
+
 ///////////////////////////////////////////////////////////////////////
 // animate and display new result
 ///////////////////////////////////////////////////////////////////////
 void glutIdle()
 {
-    if (animate)
+    // the simulation thread does the stepping, so just pick up
+    // whatever it finished last, if anything, along with the tiles
+    // that changed on the way there
+    vector<unsigned char> tiles;
+    bool fresh;
     {
-        runEverytime();
+        lock_guard<mutex> guard(publishLock);
+        fresh = frames.update();
+        if (fresh)
+        {
+            tiles = publishedTiles;
+            publishedTiles.assign(publishedTiles.size(), 0);
+        }
     }
-    updateTexture(field);
+    if (fresh)
+        updateTexture(frames.front(), tiles);
     glutPostRedisplay();
 }
 
@@ -515,6 +705,34 @@ int glvuWindow()
     return EXIT_SUCCESS;
 }
 
+///////////////////////////////////////////////////////////////////////
+// The board lives in whichever engine is running, and the field is
+// just what's displayed, so checkpoints go through these. Restoring
+// loads every engine the same way 'r' does. HashLife never runs
+// headless, and if it did, only the cells on screen would be saved.
+///////////////////////////////////////////////////////////////////////
+void saveBoard(FIELD_2D& board)
+{
+    if (ruling)
+        FIELD_2D_CONVERT(ruleCells, board);
+    else if (hashLifing)
+    {
+        board.resizeAndWipe(field.xRes(), field.yRes());
+        hashlife.getCells(board);
+    }
+    else
+        FIELD_2D_CONVERT(cells, board);
+}
+
+void restoreBoard(const FIELD_2D& board)
+{
+    field = board;
+    FIELD_2D_CONVERT(field, cells);
+    FIELD_2D_CONVERT(field, ruleCells);
+    if (hashLifing)
+        hashlife.setCells(field);
+}
+
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 int main(int argc, char** argv)
@@ -531,6 +749,18 @@ int main(int argc, char** argv)
         eyeCenter[1] = yLength * 0.5;
     }
     runOnce();
+    if (ruling)
+        cout << " Rule: " << rule.name() << endl;
+    
+    // run without a window if asked to, see HEADLESS.h
+    HEADLESS headless(argc, argv);
+    // the state a -restart has to bring back
+    headless.checkpoint().add("board", saveBoard, restoreBoard);
+    if (headless.enabled())
+        return headless.run(runEverytime, field);
+    
+    // step on a thread of our own, paused until 'a' gets pressed
+    simulation.start(timedRunEverytime, publishFrame);
     
     // initialize GLUT and GL
     glutInit(&argc, argv);
@@ -547,34 +777,40 @@ int main(int argc, char** argv)
 // here.
 ///////////////////////////////////////////////////////////////////////
 void runEverytime(){
-   
-    for (int x = 0; x < xRes; x++){
-        for (int y = 0; y < yRes; y++){ 
-            int xBound1 = x % xRes;
-            int xBound2 = xRes - x;
-            int yBound1 = y % yRes;
-            int yBound2 = yRes - y;
-    
-            x = x < 0    ? xBound2 : x;
-            x = x > xRes ? xBound1 : x;
-            y = y < 0    ? yBound2 : y;
-            y = y > yRes ? yBound1 : y;
-
-            int neighbors = field(x-1,y+1) + field(x,y+1) + field(x+1,y+1) +
-                            field(x-1,y)   + field(x+1,y) + field(x-1,y-1) +
-                            field(x,y-1)   + field(x+1,y-1);
-
-            if (field(x,y) == 1){
-                next(x,y) = neighbors == 2 || neighbors == 3 ? 1 : 0;
-            }   
-            if (field(x,y) == 0){
-                next(x,y) = neighbors == 3 ? 1 : 0;
-            }
-
-        }
+    if (ruling){
+        rule.step(ruleCells, ruleNext);
+        ruleCells.swap(ruleNext);
+        FIELD_2D_CONVERT(ruleCells, field);
+        return;
     }
-    field = next;
-    //usleep(1000000);
+    if (hashLifing){
+        hashlife.step(hashLifeExponent);
+        hashlife.getCells(field);
+        return;
+    }
+    cells.step();
+    cells.unpackChanged(field);
+    markDirtyTiles();
+}
+
+///////////////////////////////////////////////////////////////////////
+// Called on the simulation thread after every step, to hand a copy
+// of the field over to the display, along with the tiles that
+// changed since the last one
+///////////////////////////////////////////////////////////////////////
+void publishFrame()
+{
+    // pick up mouse edits too, which don't go through a step
+    markDirtyTiles();
+    frames.back() = field;
+
+    lock_guard<mutex> guard(publishLock);
+    if (publishedTiles.size() != dirtyTiles.size())
+        publishedTiles.assign(dirtyTiles.size(), 1);
+    for (unsigned int x = 0; x < dirtyTiles.size(); x++)
+        publishedTiles[x] |= dirtyTiles[x];
+    dirtyTiles.assign(dirtyTiles.size(), 0);
+    frames.publish();
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -582,11 +818,7 @@ void runEverytime(){
 // something here
 ///////////////////////////////////////////////////////////////////////
 void runOnce(){
-     for (int x = 0; x < xRes; x++){
-        for (int y = 0; y < yRes; y++){
-          field(x,y) = 0;
-        }
-     }
+     field = 0;
      //automaton->glosperGliderGun(60); 
     //automaton->glosperGliderGun(80);
      //automaton->glosperGliderGun(100);
@@ -611,5 +843,6 @@ void runOnce(){
      automaton->pulsar(65,35);
      automaton->pulsar(55,45);
 
-     
+     FIELD_2D_CONVERT(field, cells);
+     FIELD_2D_CONVERT(field, ruleCells);
 }
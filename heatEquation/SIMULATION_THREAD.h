@@ -0,0 +1,150 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+///////////////////////////////////////////////////////////////////////
+// Runs a viewer's runEverytime() on a thread of its own, so a slow
+// step doesn't freeze the window and a fast one isn't held back to
+// the display rate.
+//
+//   simulation.start(runEverytime, publishFrame);
+//   simulation.setRunning(true);
+//
+// While running, the thread steps as fast as it will go, and calls
+// publishFrame() after every step to hand the result over, usually
+// by copying the field into a FIELD_2D_TRIPLE for the display to pick
+// up. step() asks for a single step, and refresh() just republishes,
+// e.g. after a mouse edit while paused.
+//
+// The step and publish both happen while holding lock(), so anything
+// on the GL thread that touches the simulation's fields has to hold
+// it too:
+//
+//   {
+//     std::lock_guard<std::mutex> guard(simulation.lock());
+//     field(xField, yField) = 1;
+//   }
+//   simulation.refresh();
+//
+// So far heatEquation, waveEquation, gameOfLife and
+// reactionDiffusion_grayscale run on it. The other viewers still
+// call runEverytime() from glutIdle(). Moving one over takes the
+// lines above, plus finding everything on the GL thread that reads
+// or writes the simulation's state, like mouse edits, PNG and movie
+// I/O, and drawing straight from the fields.
+///////////////////////////////////////////////////////////////////////
+
+#include "THREAD_POOL.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class SIMULATION_THREAD {
+public:
+  SIMULATION_THREAD() :
+    _step(NULL), _publish(NULL), _running(false), _pendingSteps(0), _refresh(false), _quit(false)
+  {
+    // statics get destroyed in the reverse order they were built, so
+    // build the pool first, or exit() could tear it down while a step
+    // is still using it
+    THREAD_POOL::shared();
+  };
+
+  ~SIMULATION_THREAD() { stop(); };
+
+  ////////////////////////////////////////////////////////////////////////
+  // start up paused, with the current state published once
+  ////////////////////////////////////////////////////////////////////////
+  void start(void (*step)(), void (*publish)())
+  {
+    stop();
+    _step = step;
+    _publish = publish;
+    _quit = false;
+    _refresh = true;
+    _thread = std::thread(&SIMULATION_THREAD::loop, this);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // finish the current step, if any, and shut the thread down
+  ////////////////////////////////////////////////////////////////////////
+  void stop()
+  {
+    if (!_thread.joinable())
+      return;
+
+    {
+      std::lock_guard<std::mutex> guard(_wakeLock);
+      _quit = true;
+    }
+    _wake.notify_one();
+    _thread.join();
+  };
+
+  // step continuously or not
+  void setRunning(bool running) { signal([&]() { _running = running; }); };
+
+  // take one step, and publish it
+  void step() { signal([&]() { _pendingSteps++; }); };
+
+  // publish again without stepping
+  void refresh() { signal([&]() { _refresh = true; }); };
+
+  // hold this to touch anything the simulation reads or writes
+  std::mutex& lock() { return _lock; };
+
+private:
+  void (*_step)();
+  void (*_publish)();
+
+  std::thread _thread;
+  std::mutex _lock;
+
+  // everything below is guarded by _wakeLock
+  std::mutex _wakeLock;
+  std::condition_variable _wake;
+  bool _running;
+  int _pendingSteps;
+  bool _refresh;
+  bool _quit;
+
+  ////////////////////////////////////////////////////////////////////////
+  // change the requests under _wakeLock, then wake the thread
+  ////////////////////////////////////////////////////////////////////////
+  template <class CHANGE>
+  void signal(const CHANGE& change)
+  {
+    {
+      std::lock_guard<std::mutex> guard(_wakeLock);
+      change();
+    }
+    _wake.notify_one();
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // sleep until there's something to do, then do it
+  ////////////////////////////////////////////////////////////////////////
+  void loop()
+  {
+    while (true)
+    {
+      bool stepping;
+      {
+        std::unique_lock<std::mutex> wait(_wakeLock);
+        _wake.wait(wait, [this] { return _quit || _running || _pendingSteps > 0 || _refresh; });
+        if (_quit)
+          return;
+
+        stepping = _running || _pendingSteps > 0;
+        _pendingSteps = (_pendingSteps > 0) ? _pendingSteps - 1 : 0;
+        _refresh = false;
+      }
+
+      std::lock_guard<std::mutex> guard(_lock);
+      if (stepping)
+        _step();
+      _publish();
+    }
+  };
+};
+
+#endif
@@ -1,10 +1,17 @@
 #include <cmath>
 #include "FIELD_2D.h"
+#include "FIELD_2D_BUFFER.h"
+#include "FIELD_2D_STENCIL.h"
+#include "FIELD_2D_TRIPLE.h"
 #include "VEC3F.h"
 #include <iostream>
 #include "QUICKTIME_MOVIE.h"
 #include "MERSENNE_TWISTER.h"
 #include "TimeStamper.h"
+#include "HEADLESS.h"
+#include "FIELD_2D_TEXTURE.h"
+#include "PHASE_TIMER.h"
+#include "SIMULATION_THREAD.h"
 
 #if _WIN32
 #include <gl/glut.h>
@@ -15,12 +22,25 @@
 using namespace std;
 
 // resolution of the field
-int xRes = 200;
-int yRes = 200;
+int xRes = HEADLESS::xRes(200);
+int yRes = HEADLESS::yRes(200);
 
 // the field being drawn and manipulated
-FIELD_2D field(xRes, yRes);
-FIELD_2D old(xRes, yRes);
+FIELD_2D_BUFFER<FIELD_2D> temperatures(xRes, yRes);
+FIELD_2D& field = temperatures.current();
+
+// timesteps to take per frame -- more than one get temporally blocked,
+// which is a lot faster on big fields
+int stepsPerFrame = 1;
+
+// finished frames, handed from the simulation thread to the display
+FIELD_2D_TRIPLE<FIELD_2D> frames(xRes, yRes);
+
+// per-phase timings, shown with 't', see PHASE_TIMER.h
+PHASE_TIMER timings;
+
+// runs runEverytime() off of the GL thread, see SIMULATION_THREAD.h
+SIMULATION_THREAD simulation;
 
 // the resolution of the OpenGL window -- independent of the field resolution
 int xScreenRes = 850;
@@ -61,6 +81,9 @@ float zoom = 1.0;
 // Quicktime movie to capture to
 QUICKTIME_MOVIE movie;
 
+// the field as a GL texture, see FIELD_2D_TEXTURE.h
+FIELD_2D_TEXTURE fieldTexture;
+
 // a random number generator
 MERSENNE_TWISTER twister(123456);
 
@@ -72,6 +95,9 @@ void runOnce();
 // put it at the bottom of the file
 void runEverytime();
 
+// copy the field over for the display, see SIMULATION_THREAD.h
+void publishFrame();
+
 ///////////////////////////////////////////////////////////////////////
 // Figure out which field element is being pointed at, set xField and
 // yField to them
@@ -131,23 +157,14 @@ void printGlString(string output)
 }
 
 ///////////////////////////////////////////////////////////////////////
-// dump the field contents to a GL texture for drawing
+// bring the GL texture up to date with the field, only sending
+// what changed, see FIELD_2D_TEXTURE.h
 ///////////////////////////////////////////////////////////////////////
-void updateTexture(FIELD_2D& texture)
+void updateTexture(const FIELD_2D& texture)
 {
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, 3, 
-                 texture.xRes(), 
-                 texture.yRes(), 0, 
-                 GL_LUMINANCE, GL_FLOAT, 
-                 texture.data());
-    
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-    glEnable(GL_TEXTURE_2D);
+    PHASE_TIMER::SCOPE scope(timings, "updateTexture");
+
+    fieldTexture.upload(texture);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -155,6 +172,8 @@ void updateTexture(FIELD_2D& texture)
 ///////////////////////////////////////////////////////////////////////
 void drawGrid()
 {
+    PHASE_TIMER::SCOPE scope(timings, "drawGrid");
+
     glColor4f(0.1, 0.1, 0.1, 1.0);
     
     float dx = 1.0 / xRes;
@@ -166,12 +185,12 @@ void drawGrid()
         dy *= (float)yRes / xRes;
     
     glBegin(GL_LINES);
-    for (int x = 0; x < field.xRes() + 1; x++)
+    for (int x = 0; x < frames.front().xRes() + 1; x++)
     {
         glVertex3f(x * dx, 0, 1);
         glVertex3f(x * dx, 1, 1);
     }
-    for (int y = 0; y < field.yRes() + 1; y++)
+    for (int y = 0; y < frames.front().yRes() + 1; y++)
     {
         glVertex3f(0, y * dy, 1);
         glVertex3f(1, y * dy, 1);
@@ -179,11 +198,31 @@ void drawGrid()
     glEnd();
 }
 
+///////////////////////////////////////////////////////////////////////
+// print the per-phase timings down the top left corner
+///////////////////////////////////////////////////////////////////////
+void drawTimings()
+{
+    glLoadIdentity();
+    float halfZoom = 0.5 * zoom;
+
+    vector<string> lines = timings.lines();
+    for (unsigned int x = 0; x < lines.size(); x++)
+    {
+        // must set color before setting raster position, otherwise it won't take
+        glColor4f(1.0f, 0.0f, 0.0f, 1.0f);
+        glRasterPos3f(-halfZoom * 0.95, halfZoom * (0.9 - 0.06 * x), 0);
+        printGlString(lines[x]);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////
 // GL and GLUT callbacks
 ///////////////////////////////////////////////////////////////////////
 void glutDisplay()
 {
+    PHASE_TIMER::SCOPE scope(timings, "glutDisplay");
+
     // Make ensuing transforms affect the projection matrix
     glMatrixMode(GL_PROJECTION);
     
@@ -212,14 +251,7 @@ void glutDisplay()
     if (yRes < xRes)
         yLength = (float)yRes / xRes;
     
-    glEnable(GL_TEXTURE_2D); 
-    glBegin(GL_QUADS);
-    glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, 0.0);
-    glTexCoord2f(0.0, 1.0); glVertex3f(0.0, yLength, 0.0);
-    glTexCoord2f(1.0, 1.0); glVertex3f(xLength, yLength, 0.0);
-    glTexCoord2f(1.0, 0.0); glVertex3f(xLength, 0.0, 0.0);
-    glEnd();
-    glDisable(GL_TEXTURE_2D); 
+    fieldTexture.draw(xLength, yLength);
     
     // draw the grid, but only if the user wants
     if (drawingGrid)
@@ -227,7 +259,7 @@ void glutDisplay()
     
     // if there's a valid field index, print it
     if (xField >= 0 && yField >= 0 &&
-        xField < field.xRes() && yField < field.yRes())
+        xField < frames.front().xRes() && yField < frames.front().yRes())
     {
         glLoadIdentity();
         
@@ -245,7 +277,7 @@ void glutDisplay()
         fieldValue = fieldValue + string(buffer);
         sprintf(buffer, "%i", yField);
         fieldValue = fieldValue + string(", ") + string(buffer) + string(") = ");
-        sprintf(buffer, "%f", field(xField, yField));
+        sprintf(buffer, "%f", frames.front()(xField, yField));
         fieldValue = fieldValue + string(buffer);
         
         // draw the grid, but only if the user wants
@@ -255,8 +287,15 @@ void glutDisplay()
     
     // if we're recording a movie, capture a frame
     if (captureMovie)
-        movie.addFrameGL();
+    {
+        PHASE_TIMER::SCOPE scope(timings, "movie");
+        movie.addFrameFIELD_2D(frames.front());
+    }
     
+    // print the phase timings, but only if the user wants
+    if (timings.showing())
+        drawTimings();
+
     glutSwapBuffers();
 }
 
@@ -269,7 +308,9 @@ void printCommands()
     cout << "=============================================================== " << endl;
     cout << " q           - quit" << endl;
     cout << " v           - type the value of the cell under the mouse" << endl;
+    cout << " k           - cycle through the colormaps" << endl;
     cout << " g           - throw a grid over everything" << endl;
+    cout << " t           - time each part of a frame, see PHASE_TIMER.h" << endl;
     cout << " m           - start/stop capturing a movie" << endl;
     cout << " r           - read in a PNG file " << endl;
     cout << " w           - write out a PNG file " << endl;
@@ -307,6 +348,7 @@ void glutKeyboard(unsigned char key, int x, int y)
     {
         case 'a':
             animate = !animate;
+            simulation.setRunning(animate);
             break;
         case 'g':
             drawingGrid = !drawingGrid;
@@ -314,6 +356,9 @@ void glutKeyboard(unsigned char key, int x, int y)
         case '?':
             printCommands();
             break;
+        case 'k':
+            cout << " Colormap: " << fieldTexture.nextColormap() << endl;
+            break;
         case 'v':
             drawingValues = !drawingValues;
             break;
@@ -333,25 +378,38 @@ void glutKeyboard(unsigned char key, int x, int y)
             else
             {
                 cout << " Starting to capture movie. " << endl;
+                movie.streamTo("movie.mov");
                 captureMovie = true;
             }
             break;
         case 'r':
+        {
+            lock_guard<mutex> guard(simulation.lock());
             field.readPNG("bunny.png");
             xRes = field.xRes();
             yRes = field.yRes();
+        }
+            simulation.refresh();
             break;
         case 'u':
+        {
+            lock_guard<mutex> guard(simulation.lock());
         	field.readPNG("candle.png");
         	xRes = field.xRes();
         	yRes = field.yRes();
+        }
+            simulation.refresh();
         	break;
         case 'w':
         {
             TimeStamper ts;
+            lock_guard<mutex> guard(simulation.lock());
             field.writePNG(ts.timestampedFilename("output",".png"));
         }
             break;
+        case 't':
+            timings.toggle();
+            break;
         case 'q':
             exit(0);
             break;
@@ -376,7 +434,11 @@ void glutMouseClick(int button, int state, int x, int y)
         refreshMouseFieldIndex(x,y);
         
         // set the cell
-        field(xField, yField) = 1;
+        {
+            lock_guard<mutex> guard(simulation.lock());
+            field(xField, yField) = 1;
+        }
+        simulation.refresh();
         
         // make sure nothing else is called
         return;
@@ -399,7 +461,11 @@ void glutMouseMotion(int x, int y)
         refreshMouseFieldIndex(x,y);
         
         // set the cell
-        field(xField, yField) = 1;
+        {
+            lock_guard<mutex> guard(simulation.lock());
+            field(xField, yField) = 1;
+        }
+        simulation.refresh();
         
         // make sure nothing else is called
         return;
@@ -429,16 +495,24 @@ void glutPassiveMouseMotion(int x, int y)
     refreshMouseFieldIndex(x,y);
 }
 
+///////////////////////////////////////////////////////////////////////
+// runEverytime(), timed for the overlay
+///////////////////////////////////////////////////////////////////////
+void timedRunEverytime()
+{
+    PHASE_TIMER::SCOPE scope(timings, "runEverytime");
+    runEverytime();
+}
+
 ///////////////////////////////////////////////////////////////////////
 // animate and display new result
 ///////////////////////////////////////////////////////////////////////
 void glutIdle()
 {
-    if (animate)
-    {
-        runEverytime();
-    }
-    updateTexture(field);
+    // the simulation thread does the stepping, so just pick up
+    // whatever it finished last, if anything
+    if (frames.update())
+        updateTexture(frames.front());
     glutPostRedisplay();
 }
 
@@ -492,6 +566,16 @@ int main(int argc, char** argv)
     
     runOnce();
     
+    // run without a window if asked to, see HEADLESS.h
+    HEADLESS headless(argc, argv);
+    // the state a -restart has to bring back
+    headless.checkpoint().add("temperature", field);
+    if (headless.enabled())
+        return headless.run(runEverytime, field);
+    
+    // step on a thread of our own, paused until 'a' gets pressed
+    simulation.start(timedRunEverytime, publishFrame);
+    
     // initialize GLUT and GL
     glutInit(&argc, argv);
     
@@ -506,15 +590,23 @@ int main(int argc, char** argv)
 ///////////////////////////////////////////////////////////////////////
 void runEverytime()
 {
-	old = field;
     float dt = 0.01;
     float alpha = 0.9;
-    float laplacian;
-    for (int y = 1; y < yRes-1; y++) for (int x = 1; x < xRes-1; x++){
-        laplacian = -4 * old(x,y) + old(x+1,y) + old(x-1,y) + old(x,y+1) + old(x,y-1);
-        field(x,y) += dt * alpha * laplacian;
-    }
 
+    // the border isn't stepped, the stencil just carries it over. The
+    // other buffer is scratch space, and the answer lands in field.
+    FIELD_2D_STENCIL<FIELD_2D_LAPLACIAN_5>::steps(field, temperatures[1], dt * alpha, stepsPerFrame);
+
+}
+
+///////////////////////////////////////////////////////////////////////
+// Called on the simulation thread after every step, to hand a copy
+// of the field over to the display
+///////////////////////////////////////////////////////////////////////
+void publishFrame()
+{
+    frames.back() = field;
+    frames.publish();
 }
 
 ///////////////////////////////////////////////////////////////////////
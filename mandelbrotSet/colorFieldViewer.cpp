@@ -9,6 +9,9 @@
 #include "MATRIX.h"
 #include "VECTOR.h"
 #include "TimeStamper.h"
+#include "HEADLESS.h"
+#include "FIELD_2D_TEXTURE.h"
+#include "PHASE_TIMER.h"
 
 #if _WIN32
 #include <gl/glut.h>
@@ -19,8 +22,8 @@
 using namespace std;
 
 // resolution of the field
-int xRes = 900;
-int yRes = 900;
+int xRes = HEADLESS::xRes(900);
+int yRes = HEADLESS::yRes(900);
 
 bool mandelbrot = true;
 bool julia = false;
@@ -73,6 +76,12 @@ float zoom = 1.0;
 // Quicktime movie to capture to
 QUICKTIME_MOVIE movie;
 
+// the field as a GL texture, see FIELD_2D_TEXTURE.h
+FIELD_2D_TEXTURE fieldTexture;
+
+// per-phase timings, shown with 't', see PHASE_TIMER.h
+PHASE_TIMER timings;
+
 // a random number generator
 MERSENNE_TWISTER twister(123456);
 
@@ -143,39 +152,14 @@ void printGlString(string output)
 }
 
 ///////////////////////////////////////////////////////////////////////
-// dump the field contents to a GL texture for drawing
+// bring the GL texture up to date with the field, only sending
+// what changed, see FIELD_2D_TEXTURE.h
 ///////////////////////////////////////////////////////////////////////
 void updateTexture(const COLOR_FIELD_2D& texture)
 {
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  PHASE_TIMER::SCOPE scope(timings, "updateTexture");
 
-  // create a flatten array of the color values
-  int totalCells = texture.xRes() * texture.yRes();
-  float* flatData = new float[totalCells * 3];
-
-  for (int x = 0; x < totalCells; x++)
-  {
-    flatData[3 * x] = texture[x][0];
-    flatData[3 * x + 1] = texture[x][1];
-    flatData[3 * x + 2] = texture[x][2];
-  }
-
-  // send the data to the texture
-  glTexImage2D(GL_TEXTURE_2D, 0, 3, 
-      texture.xRes(), 
-      texture.yRes(), 0, 
-      GL_RGB, GL_FLOAT, 
-      flatData);
-
-  // remember to clean up after ourselves
-  delete[] flatData;
-
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-  glEnable(GL_TEXTURE_2D);
+  fieldTexture.upload(texture);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -183,6 +167,8 @@ void updateTexture(const COLOR_FIELD_2D& texture)
 ///////////////////////////////////////////////////////////////////////
 void drawGrid()
 {
+  PHASE_TIMER::SCOPE scope(timings, "drawGrid");
+
   glColor4f(0.1, 0.1, 0.1, 1.0);
 
   float dx = 1.0 / xRes;
@@ -207,11 +193,31 @@ void drawGrid()
   glEnd();
 }
 
+///////////////////////////////////////////////////////////////////////
+// print the per-phase timings down the top left corner
+///////////////////////////////////////////////////////////////////////
+void drawTimings()
+{
+  glLoadIdentity();
+  float halfZoom = 0.5 * zoom;
+
+  vector<string> lines = timings.lines();
+  for (unsigned int x = 0; x < lines.size(); x++)
+  {
+    // must set color before setting raster position, otherwise it won't take
+    glColor4f(1.0f, 0.0f, 0.0f, 1.0f);
+    glRasterPos3f(-halfZoom * 0.95, halfZoom * (0.9 - 0.06 * x), 0);
+    printGlString(lines[x]);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////
 // GL and GLUT callbacks
 ///////////////////////////////////////////////////////////////////////
 void glutDisplay()
 {
+  PHASE_TIMER::SCOPE scope(timings, "glutDisplay");
+
   // Make ensuing transforms affect the projection matrix
   glMatrixMode(GL_PROJECTION);
 
@@ -240,14 +246,7 @@ void glutDisplay()
   if (yRes < xRes)
     yLength = (float)yRes / xRes;
 
-  glEnable(GL_TEXTURE_2D); 
-  glBegin(GL_QUADS);
-    glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, 0.0);
-    glTexCoord2f(0.0, 1.0); glVertex3f(0.0, yLength, 0.0);
-    glTexCoord2f(1.0, 1.0); glVertex3f(xLength, yLength, 0.0);
-    glTexCoord2f(1.0, 0.0); glVertex3f(xLength, 0.0, 0.0);
-  glEnd();
-  glDisable(GL_TEXTURE_2D); 
+  fieldTexture.draw(xLength, yLength);
 
   // draw the grid, but only if the user wants
   if (drawingGrid)
@@ -285,7 +284,14 @@ void glutDisplay()
 
   // if we're recording a movie, capture a frame
   if (captureMovie)
-    movie.addFrameGL();
+  {
+    PHASE_TIMER::SCOPE scope(timings, "movie");
+    movie.addFrameCOLOR_FIELD_2D(field);
+  }
+
+  // print the phase timings, but only if the user wants
+  if (timings.showing())
+    drawTimings();
 
   glutSwapBuffers();
 }
@@ -300,6 +306,7 @@ void printCommands()
   cout << " q           - quit" << endl;
   cout << " v           - type the value of the cell under the mouse" << endl;
   cout << " g           - throw a grid over everything" << endl;
+  cout << " t           - time each part of a frame, see PHASE_TIMER.h" << endl;
   cout << " a           - start/stop animation" << endl;  
   cout << " m           - start/stop capturing a movie" << endl;
   cout << " r           - read in a PNG file " << endl;
@@ -387,6 +394,7 @@ void glutKeyboard(unsigned char key, int x, int y)
       else
       {
         cout << " Starting to capture movie. " << endl;
+        movie.streamTo("movie.mov");
         captureMovie = true;
       }
       break;
@@ -401,6 +409,9 @@ void glutKeyboard(unsigned char key, int x, int y)
       field.writePNG(ts.timestampedFilename("output",".png"));
     }
       break;
+    case 't':
+      timings.toggle();
+      break;
     case 'q':
       exit(0);
       break;
@@ -487,7 +498,8 @@ void glutPassiveMouseMotion(int x, int y)
 void glutIdle()
 {
   if(animate){
-      runEverytime();      
+      PHASE_TIMER::SCOPE scope(timings, "runEverytime");
+      runEverytime();
   }
   updateTexture(field);
   glutPostRedisplay();
@@ -542,6 +554,13 @@ int main(int argc, char** argv)
   }
 
   runOnce();
+  
+  // run without a window if asked to, see HEADLESS.h
+  HEADLESS headless(argc, argv);
+  // the state a -restart has to bring back
+  headless.checkpoint().add("field", field);
+  if (headless.enabled())
+    return headless.run(runEverytime, field);
 
   // initialize GLUT and GL
   glutInit(&argc, argv);
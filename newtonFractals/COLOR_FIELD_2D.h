@@ -5,19 +5,27 @@
 #include <string>
 #include <iostream>
 #include "VEC3F.h"
+#include "FIELD_2D_EXPR.h"
+
+template <int CHANNELS> struct FIELD_2D_REDUCTION;
 
 using namespace std;
 
-class COLOR_FIELD_2D {
+class COLOR_FIELD_2D : public FIELD_2D_EXPR<VEC3F, COLOR_FIELD_2D> {
 public:
   COLOR_FIELD_2D();
   COLOR_FIELD_2D(const int& rows, const int& cols);
   COLOR_FIELD_2D(const COLOR_FIELD_2D& m);
+  COLOR_FIELD_2D(COLOR_FIELD_2D&& m);
+  template <class E> COLOR_FIELD_2D(const FIELD_2D_EXPR<VEC3F, E>& expression);
   ~COLOR_FIELD_2D();
 
   // accessors
-  inline VEC3F& operator()(int x, int y) { return _data[y * _xRes + x]; };
-  const  VEC3F operator()(int x, int y) const { return _data[y * _xRes + x]; };
+  inline VEC3F& operator()(int x, int y) { return _data[y * _pitch + x]; };
+  const  VEC3F operator()(int x, int y) const { return _data[y * _pitch + x]; };
+
+  // raw index into the storage, which only walks the cells in order
+  // when pitch() == xRes(), i.e. anything but a view
   inline VEC3F& operator[](int x) { return _data[x]; };
   const  VEC3F operator[](int x) const { return _data[x]; };
   VEC3F* data() { return _data; };
@@ -26,6 +34,18 @@ public:
   const int yRes() const { return _yRes; };
   const int totalCells() const { return _totalCells; };
 
+  // cells from the start of one row to the start of the next
+  const int pitch() const { return _pitch; };
+  inline VEC3F* row(int y) { return _data + y * _pitch; };
+  inline const VEC3F* row(int y) const { return _data + y * _pitch; };
+
+  // true if this is a COLOR_FIELD_2D_VIEW into another field's storage
+  const bool isView() const { return _view; };
+
+  // for FIELD_2D_EXPR, color fields are always row-major
+  inline const VEC3F rowMajorCell(int x, int y) const { return _data[y * _pitch + x]; };
+  const bool rowMajor() const { return true; };
+
   // common field operations
   void clear();
   void normalize();
@@ -34,6 +54,9 @@ public:
   VEC3F min();
   VEC3F max();
 
+  // per-channel min, max and sum all at once
+  void minMaxSum(VEC3F& minFound, VEC3F& maxFound, VEC3F& total) const;
+
   // take the log
   void log(float base = 2.0);
  
@@ -46,9 +69,14 @@ public:
   // change dimensions and clear the colors
   void resizeAndWipe(int xRes, int yRes);
 
+  // exchange contents with another field without copying, unless
+  // one of them is a view, which has to swap cell by cell
+  void swap(COLOR_FIELD_2D& input);
+
   // overloaded operators
   COLOR_FIELD_2D& operator=(const float& alpha);
   COLOR_FIELD_2D& operator=(const COLOR_FIELD_2D& A);
+  COLOR_FIELD_2D& operator=(COLOR_FIELD_2D&& A);
   COLOR_FIELD_2D& operator*=(const float& alpha);
   COLOR_FIELD_2D& operator/=(const float& alpha);
   COLOR_FIELD_2D& operator+=(const float& alpha);
@@ -57,25 +85,147 @@ public:
   COLOR_FIELD_2D& operator*=(const COLOR_FIELD_2D& input);
   COLOR_FIELD_2D& operator/=(const COLOR_FIELD_2D& input);
 
+  // evaluate a lazy expression in a single pass, see FIELD_2D_EXPR.h
+  template <class E> COLOR_FIELD_2D& operator=(const FIELD_2D_EXPR<VEC3F, E>& expression);
+  template <class E> COLOR_FIELD_2D& operator+=(const FIELD_2D_EXPR<VEC3F, E>& expression);
+  template <class E> COLOR_FIELD_2D& operator-=(const FIELD_2D_EXPR<VEC3F, E>& expression);
+
   // sum of all entries
   VEC3F sum();
   
   // set to a checkboard for debugging
   void setToCheckerboard(int xChecks = 10, int yChecks = 10);
-  
+
+protected:
+  // wrap storage that belongs to some other field, see COLOR_FIELD_2D_VIEW
+  COLOR_FIELD_2D(VEC3F* data, int xRes, int yRes, int pitch);
+
 private:
+  friend class COLOR_FIELD_2D_VIEW;
+
   int _xRes;
   int _yRes;
+  int _pitch;
   int _totalCells;
   VEC3F* _data;
+
+  // _data belongs to some other field, so never delete it
+  bool _view;
+
+  FIELD_2D_REDUCTION<3> reduce() const;
+
+  // new dense storage, without wiping it
+  void reallocate(int xRes, int yRes);
+
+  // run op on every cell, or on every pair of matching cells
+  template <class OP> void forEachCell(OP op);
+  template <class OP> void forEachCell(const COLOR_FIELD_2D& input, OP op);
 };
 
-COLOR_FIELD_2D operator*(const COLOR_FIELD_2D& A, const float alpha);
-COLOR_FIELD_2D operator/(const COLOR_FIELD_2D& A, const float alpha);
-COLOR_FIELD_2D operator+(const COLOR_FIELD_2D& A, const float alpha);
-COLOR_FIELD_2D operator*(const float alpha, const COLOR_FIELD_2D& A);
-COLOR_FIELD_2D operator+(const float alpha, const COLOR_FIELD_2D& A);
-COLOR_FIELD_2D operator-(const COLOR_FIELD_2D& A, const COLOR_FIELD_2D& B);
-COLOR_FIELD_2D operator+(const COLOR_FIELD_2D& A, const COLOR_FIELD_2D& B);
+// fields are leaves of an expression, so hold them by reference
+template <>
+struct FIELD_2D_OPERAND<COLOR_FIELD_2D> {
+  typedef const COLOR_FIELD_2D& type;
+};
+
+///////////////////////////////////////////////////////////////////////
+// A rectangle of some other color field, without copying it, that
+// works the same way FIELD_2D_VIEW does
+///////////////////////////////////////////////////////////////////////
+class COLOR_FIELD_2D_VIEW : public COLOR_FIELD_2D {
+public:
+  COLOR_FIELD_2D_VIEW(COLOR_FIELD_2D& field, int x, int y, int xRes, int yRes) :
+    COLOR_FIELD_2D(field.data() + y * field.pitch() + x, xRes, yRes, field.pitch())
+  {
+    assert(x >= 0 && xRes >= 0 && x + xRes <= field.xRes());
+    assert(y >= 0 && yRes >= 0 && y + yRes <= field.yRes());
+  };
+  COLOR_FIELD_2D_VIEW(const COLOR_FIELD_2D_VIEW& view) :
+    COLOR_FIELD_2D(view._data, view.xRes(), view.yRes(), view.pitch()) {};
+
+  using COLOR_FIELD_2D::operator=;
+  COLOR_FIELD_2D_VIEW& operator=(const COLOR_FIELD_2D_VIEW& view)
+  {
+    COLOR_FIELD_2D::operator=(view);
+    return *this;
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class E>
+COLOR_FIELD_2D::COLOR_FIELD_2D(const FIELD_2D_EXPR<VEC3F, E>& expression) :
+  _xRes(expression.self().xRes()), _yRes(expression.self().yRes()), _pitch(_xRes), _view(false)
+{
+  const E& A = expression.self();
+  _totalCells = _xRes * _yRes;
+  _data = new VEC3F[_totalCells];
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    for (int x = 0; x < _xRes; x++)
+      cells[x] = A(x, y);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+// each cell only depends on the same cell of its operands, so this
+// is safe even if this field appears in the expression
+///////////////////////////////////////////////////////////////////////
+template <class E>
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const FIELD_2D_EXPR<VEC3F, E>& expression)
+{
+  const E& A = expression.self();
+  if (A.xRes() != _xRes || A.yRes() != _yRes)
+    resizeAndWipe(A.xRes(), A.yRes());
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    for (int x = 0; x < _xRes; x++)
+      cells[x] = A(x, y);
+  }
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class E>
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator+=(const FIELD_2D_EXPR<VEC3F, E>& expression)
+{
+  const E& A = expression.self();
+  assert(A.xRes() == _xRes);
+  assert(A.yRes() == _yRes);
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    for (int x = 0; x < _xRes; x++)
+      cells[x] += A(x, y);
+  }
+
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class E>
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator-=(const FIELD_2D_EXPR<VEC3F, E>& expression)
+{
+  const E& A = expression.self();
+  assert(A.xRes() == _xRes);
+  assert(A.yRes() == _yRes);
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    for (int x = 0; x < _xRes; x++)
+      cells[x] -= A(x, y);
+  }
+
+  return *this;
+}
 
 #endif
@@ -7,6 +7,21 @@
 // and "writeMovie" to write the MOV out when you're done.
 //
 // Or, to grab a frame from GL, call "addFrameGL"
+//
+// Fields can go in directly with "addFrameFIELD_2D" and
+// "addFrameCOLOR_FIELD_2D", at their own resolution rather than the
+// window's, and without a trip through GL. "setDownscale" averages
+// each n x n block of cells down to one pixel on the way in.
+//
+// Where pixel buffer objects are around, "addFrameGL" doesn't wait on
+// the read: each call starts reading the window into one buffer and
+// adds the frame read into the other one on the call before.
+//
+// Every frame gets held in memory until writeMovie(), unless
+// "streamTo" is called first, in which case each frame gets
+// compressed and written out as soon as it comes in. Either way the
+// JPEG compression is spread over as many threads as FIELD_2D_THREADS
+// asks for, and the frames still land in the file in order.
 ///////////////////////////////////////////////////////////////////////
 
 #ifndef QUICKTIME_MOVIE_H
@@ -16,8 +31,17 @@
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <jpeglib.h>
+#include "FIELD_2D.h"
+#include "THREAD_POOL.h"
 
 // enables OpenGL screengrabs
 #if _WIN32
@@ -30,7 +54,16 @@
 #include <arpa/inet.h>
 #endif
 
-using namespace std;
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// pixel buffer objects are core since GL 2.1, which the Mac headers
+// declare, elsewhere the prototypes have to be asked for with
+// GL_GLEXT_PROTOTYPES
+#if __APPLE__ || defined(GL_GLEXT_PROTOTYPES)
+#define QUICKTIME_MOVIE_PBO 1
+#endif
 
 typedef unsigned int uint;
 typedef unsigned short ushort;
@@ -70,65 +103,105 @@ public:
     _width = -1;
     _height = -1;
     _totalFrames = 0;
+    _file = NULL;
+    _mdat = NULL;
+    _mdatBegin = 0;
+    _finishing = false;
+    _downscale = 1;
+    _readBuffers[0] = _readBuffers[1] = 0;
+    _nextRead = 0;
+    _readPending = false;
+    _readWidth = _readHeight = 0;
   };
 
+  // a movie that's still streaming gets finished, so the file plays
   ~QUICKTIME_MOVIE() {
-    for (unsigned int x = 0; x < _frameRows.size(); x++)
-      delete[] _frameRows[x];
+    if (streaming())
+      finishStream();
   };
 
+  // the viewers reset with movie = QUICKTIME_MOVIE(), so it has to move,
+  // but two copies streaming to one file would be a mess, and the
+  // writer thread holds on to this, so not while streaming either
+  QUICKTIME_MOVIE(QUICKTIME_MOVIE&& movie) : QUICKTIME_MOVIE() { swap(movie); };
+  QUICKTIME_MOVIE& operator=(QUICKTIME_MOVIE&& movie) { swap(movie); return *this; };
+  QUICKTIME_MOVIE(const QUICKTIME_MOVIE&) = delete;
+  QUICKTIME_MOVIE& operator=(const QUICKTIME_MOVIE&) = delete;
+
   ////////////////////////////////////////////////////////////////////////
-  // add a new frame to the movie, assuming it is luminance, [0,1]
+  // Compress each frame as it comes in and append it to filename,
+  // instead of holding every frame until writeMovie(). Only the size
+  // and offset of each frame stays in memory, so a long capture
+  // doesn't grow, and writeMovie() just has the header left to write.
+  //
+  // The compressing happens on a thread of its own, a batch of frames
+  // at a time, so adding a frame only waits if the writer has fallen
+  // more than a couple of batches behind.
   ////////////////////////////////////////////////////////////////////////
-  void addFrameCOLOR_FIELD_2D(COLOR_FIELD_2D const & frame) 
+  void streamTo(const char* filename)
   {
-    int width = frame.xRes();
-    int height = frame.yRes();
-        
-    if (_width == -1 && _height == -1)
+    assert(!streaming() && _totalFrames == 0);
+    _file = fopen(filename, "wb");
+    if (_file == NULL)
     {
-      _width = width;
-      _height = height;
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " Could not open movie file " << filename << std::endl;
+      exit(0);
     }
-    assert(width == _width);
-    assert(height == _height);
-        
-    for (int y = 0; y < _height; y++)
-    {
-      JSAMPLE* row = new JSAMPLE[3 * _width];
-            
-      for (int x = 0; x < _width; x++)
-      {
-        VEC3F colorSample = frame(x,height-y-1);
-          for(int i=0; i<3; i++){
-            float sample = colorSample[i];
-            sample = (sample > 1.0) ? 1.0 : sample;
-            sample = (sample < 0.0) ? 0.0 : sample;
-                    
-            unsigned char scaled = (unsigned char)(sample * 255); 
-            row[3 * x + i] = scaled;
-            }
-          }
-          _frameRows.push_back(row);
-      }
-      _totalFrames++;
-    };  
+    _filename = filename;
+
+    // the frames all go in the mdat atom, which stays open until the end
+    _mdatBegin = ftell(_file);
+    _mdat = new QT_ATOM(_file, "mdat");
+
+    _finishing = false;
+    _writer = std::thread(&QUICKTIME_MOVIE::writerLoop, this);
+  };
+
+  const bool streaming() const { return _file != NULL; };
+  const int totalFrames() const { return _totalFrames; };
+
+  // average each factor x factor block of field cells into one pixel
+  void setDownscale(int factor) { assert(factor >= 1 && _totalFrames == 0); _downscale = factor; };
+
   ////////////////////////////////////////////////////////////////////////
   // add a new frame to the movie, assuming it is luminance, [0,1]
   ////////////////////////////////////////////////////////////////////////
-  void addLuminanceFrame(const float* image, const int& width, const int& height) 
+  void addFrameFIELD_2D(FIELD_2D const & frame) 
   {
-    if (_width == -1 && _height == -1)
+    // the rows get read straight out of the storage
+    if (!frame.rowMajor())
     {
-      _width = width;
-      _height = height;
+      FIELD_2D rowMajor(frame.xRes(), frame.yRes());
+      rowMajor = frame;
+      addField(rowMajor);
+      return;
     }
-    assert(width == _width);
-    assert(height == _height);
+    addField(frame);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // add a new frame to the movie, assuming it is RGB, [0,1]
+  //
+  // a template so this header doesn't need COLOR_FIELD_2D.h, which
+  // the scalar viewers don't have
+  ////////////////////////////////////////////////////////////////////////
+  template <class COLOR_FIELD>
+  void addFrameCOLOR_FIELD_2D(COLOR_FIELD const & frame) 
+  {
+    addField(frame);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // add a new frame to the movie, assuming it is luminance, [0,1]
+  ////////////////////////////////////////////////////////////////////////
+  void addLuminanceFrame(const float* image, const int& width, const int& height) 
+  {
+    JSAMPLE* pixels = newFrame(width, height);
 
     for (int y = 0; y < _height; y++)
     {
-      JSAMPLE* row = new JSAMPLE[3 * _width];
+      JSAMPLE* row = pixels + y * 3 * _width;
 
       for (int x = 0; x < _width; x++)
       {
@@ -141,10 +214,8 @@ public:
         row[3 * x + 1] = scaled;
         row[3 * x + 2] = scaled;
       }
-
-      _frameRows.push_back(row);
     }
-    _totalFrames++;
+    frameDone();
   };
 
   ////////////////////////////////////////////////////////////////////////
@@ -166,12 +237,152 @@ public:
     // get the screen pixels
     int width = glutGet((GLenum)GLUT_WINDOW_WIDTH);
     int height = glutGet((GLenum)GLUT_WINDOW_HEIGHT);
-    int NumPixels = width * height;
-    GLubyte* Pixels = new GLubyte[NumPixels*3];
-    if (Pixels==NULL) { printf("UNABLE TO ALLOC PIXEL READ ARRAY!\n"); return; }
-    glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,Pixels);
 
-    // store the screen pixels
+#if QUICKTIME_MOVIE_PBO
+    // start this frame reading into one buffer, and while GL gets on
+    // with that, add the frame that was read into the other one
+    if (_readBuffers[0] == 0)
+      glGenBuffers(2, _readBuffers);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _readBuffers[_nextRead]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 3, NULL, GL_STREAM_READ);
+    glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    finishReadGL();
+    _nextRead = 1 - _nextRead;
+    _readWidth = width;
+    _readHeight = height;
+    _readPending = true;
+#else
+    std::vector<GLubyte> Pixels(width * height * 3);
+    glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,&Pixels[0]);
+    addPixelsGL(&Pixels[0], width, height);
+#endif
+
+    glPixelStorei(GL_PACK_ALIGNMENT,OldPackAlignment);
+    glReadBuffer((GLenum)OldReadBuffer);
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  // add the frame addFrameGL() left reading, if any. writeMovie() calls
+  // this, so it only needs calling to pick up the last frame early.
+  ////////////////////////////////////////////////////////////////////////
+  void finishReadGL()
+  {
+#if QUICKTIME_MOVIE_PBO
+    if (!_readPending)
+      return;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _readBuffers[1 - _nextRead]);
+    const GLubyte* Pixels = (const GLubyte*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (Pixels != NULL)
+    {
+      addPixelsGL(Pixels, _readWidth, _readHeight);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    _readPending = false;
+#endif
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // dump out the final movie
+  //
+  // if it was streaming, the frames are already in the file, so this
+  // only writes the header, and moves the file if it's a new name
+  ////////////////////////////////////////////////////////////////////////
+  void writeMovie(const char* filename)
+  {
+    std::cout << " Writing movie " << filename << "..."; flush(std::cout);
+    finishReadGL();
+
+    if (streaming())
+    {
+      const std::string streamed = _filename;
+      finishStream();
+      if (streamed != filename)
+        rename(streamed.c_str(), filename);
+      std::cout << " done." << std::endl;
+      return;
+    }
+
+    FILE *fp=fopen(filename,"wb");
+
+    // Write the samples (i.e. the mdat part in the quicktime), a batch
+    // at a time so only one batch worth of JPEGs is ever held at once
+    {_mdatBegin=ftell(fp);
+    QT_ATOM mdat(fp,"mdat");
+      const int batch = batchSize();
+      for (unsigned int first = 0; first < _frames.size(); first += batch)
+      {
+        std::vector<const JSAMPLE*> pixels;
+        for (unsigned int i = first; i < _frames.size() && i < first + batch; i++)
+          pixels.push_back(&_frames[i][0]);
+
+        std::vector<std::vector<unsigned char> > jpegs;
+        compress(pixels, jpegs);
+        for (unsigned int i = 0; i < jpegs.size(); i++)
+          append(jpegs[i], fp);
+      }
+    }
+
+    writeHeader(fp);
+    fclose(fp);
+    std::cout << " done." << std::endl;
+  }
+
+private:
+  // video dimensions
+  int _width;
+  int _height;
+  int _totalFrames;
+
+  // RGB pixels, a frame at a time, when not streaming
+  std::vector<std::vector<JSAMPLE> > _frames;
+
+  // when streaming, the frame being filled, the file it's going to,
+  // and its still open mdat atom
+  std::vector<JSAMPLE> _frame;
+  FILE* _file;
+  std::string _filename;
+  QT_ATOM* _mdat;
+
+  // also when streaming, frames waiting on the writer thread, in
+  // order, and spent frames for newFrame() to reuse, all guarded by
+  // _queueLock
+  std::thread _writer;
+  std::mutex _queueLock;
+  std::condition_variable _queueChanged;
+  std::deque<std::vector<JSAMPLE> > _pending;
+  std::vector<std::vector<JSAMPLE> > _spare;
+  bool _finishing;
+
+  // average blocks this wide into one pixel, and somewhere to do it
+  int _downscale;
+  std::vector<float> _blockSums;
+
+  // addFrameGL()'s pair of pixel buffers, the one to read into next,
+  // and whether the other one is holding a frame yet to be added
+  GLuint _readBuffers[2];
+  int _nextRead;
+  bool _readPending;
+  int _readWidth;
+  int _readHeight;
+
+  // the threads doing the compressing, separate from the shared pool
+  // so they don't hold up the simulation's loops or get held up by them
+  std::unique_ptr<THREAD_POOL> _encoders;
+
+  // where each compressed frame went, for the header
+  long _mdatBegin;
+  std::vector<int> _sampleSizes;
+  std::vector<int> _offsets;
+
+  ////////////////////////////////////////////////////////////////////////
+  // somewhere to put the next frame's RGB pixels, top row first
+  ////////////////////////////////////////////////////////////////////////
+  JSAMPLE* newFrame(int width, int height)
+  {
     if (_width == -1 && _height == -1)
     {
       _width = width;
@@ -179,37 +390,321 @@ public:
     }
     assert(width == _width);
     assert(height == _height);
-    for (int y = 0; y < _height; y++)
+
+    if (streaming())
     {
-      JSAMPLE* row = new JSAMPLE[3 * _width];
+      std::unique_lock<std::mutex> lock(_queueLock);
+      if (!_spare.empty())
+      {
+        _frame.swap(_spare.back());
+        _spare.pop_back();
+      }
+      _frame.resize(3 * _width * _height);
+      return &_frame[0];
+    }
+    _frames.push_back(std::vector<JSAMPLE>(3 * _width * _height));
+    return &_frames.back()[0];
+  };
 
-      // invert y, because of pixel ordering
-      for (int x = 0; x < _width * 3; x++)
-        row[x] = Pixels[x + (height - 1 - y) * (3 * _width)];
+  // the pixels from newFrame() are filled in
+  void frameDone()
+  {
+    if (streaming())
+    {
+      // hand it to the writer, waiting if it's too far behind
+      std::unique_lock<std::mutex> lock(_queueLock);
+      _queueChanged.wait(lock, [this] { return (int)_pending.size() < 2 * batchSize(); });
+      _pending.push_back(std::vector<JSAMPLE>());
+      _pending.back().swap(_frame);
+      _queueChanged.notify_all();
+    }
+    _totalFrames++;
+  };
 
-      _frameRows.push_back(row);
+  ////////////////////////////////////////////////////////////////////////
+  // a FIELD_2D or COLOR_FIELD_2D, row-major, as a frame, scaled down
+  // if setDownscale() asked for it
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  void addField(const FIELD& frame)
+  {
+    // 1 for FIELD_2D, 3 for the VEC3F in COLOR_FIELD_2D
+    const int channels = sizeof(frame(0, 0)) / sizeof(float);
+    const int width = frame.xRes() / _downscale;
+    const int height = frame.yRes() / _downscale;
+    JSAMPLE* pixels = newFrame(width, height);
+
+    const int fieldFloats = frame.xRes() * channels;
+    const int frameFloats = width * channels;
+    const float average = 1.0f / (_downscale * _downscale);
+    _blockSums.resize(fieldFloats);
+
+    for (int y = 0; y < height; y++)
+    {
+      // the movie goes top down, the field bottom up
+      const int yField = (height - 1 - y) * _downscale;
+      JSAMPLE* row = pixels + y * 3 * width;
+
+      if (_downscale == 1)
+      {
+        toPixels((const float*)frame.row(yField), row, frameFloats, channels);
+        continue;
+      }
+
+      // add up the block's rows, then each block's columns, in place
+      float* sums = &_blockSums[0];
+      memcpy(sums, frame.row(yField), fieldFloats * sizeof(float));
+      for (int j = 1; j < _downscale; j++)
+        addRow(sums, (const float*)frame.row(yField + j), fieldFloats);
+
+      for (int x = 0; x < width; x++)
+        for (int k = 0; k < channels; k++)
+        {
+          float sum = 0.0f;
+          for (int j = 0; j < _downscale; j++)
+            sum += sums[(x * _downscale + j) * channels + k];
+          sums[x * channels + k] = sum * average;
+        }
+      toPixels(sums, row, frameFloats, channels);
     }
+    frameDone();
+  };
 
-    // clean up
-    delete[] Pixels;
+  // sum[x] += row[x], four at a time where there's SSE
+  static void addRow(float* sum, const float* row, const int count)
+  {
+    int x = 0;
+#if defined(__SSE__)
+    for (; x + 4 <= count; x += 4)
+      _mm_storeu_ps(sum + x, _mm_add_ps(_mm_loadu_ps(sum + x), _mm_loadu_ps(row + x)));
+#endif
+    for (; x < count; x++)
+      sum[x] += row[x];
+  };
 
-    glPixelStorei(GL_PACK_ALIGNMENT,OldPackAlignment);
-    glReadBuffer((GLenum)OldReadBuffer);
+  // [0,1] floats to RGB bytes, copying luminance to all three
+  static void toPixels(const float* values, JSAMPLE* row, const int count, const int channels)
+  {
+    for (int x = 0; x < count; x++)
+    {
+      float sample = values[x];
+      sample = (sample > 1.0f) ? 1.0f : sample;
+      sample = (sample < 0.0f) ? 0.0f : sample;
+      const unsigned char scaled = (unsigned char)(sample * 255);
+
+      if (channels == 3)
+        row[x] = scaled;
+      else
+        row[3 * x] = row[3 * x + 1] = row[3 * x + 2] = scaled;
+    }
+  };
 
-    _totalFrames++;
-  }
+  ////////////////////////////////////////////////////////////////////////
+  // GL's bottom up pixels as a frame
+  ////////////////////////////////////////////////////////////////////////
+  void addPixelsGL(const GLubyte* Pixels, int width, int height)
+  {
+    JSAMPLE* pixels = newFrame(width, height);
+    for (int y = 0; y < _height; y++)
+    {
+      // invert y, because of pixel ordering
+      memcpy(pixels + y * 3 * _width, &Pixels[(height - 1 - y) * (3 * _width)], 3 * _width);
+    }
+    frameDone();
+  };
+
+  // frames compressed at once, a couple per encoding thread
+  int batchSize() { return 2 * encoders().threads(); };
+
+  THREAD_POOL& encoders()
+  {
+    if (!_encoders)
+      _encoders.reset(new THREAD_POOL(THREAD_POOL::shared().threads()));
+    return *_encoders;
+  };
 
   ////////////////////////////////////////////////////////////////////////
-  // dump out the final movie
+  // libjpeg destination that grows a vector, so each thread can
+  // compress into memory and the file writes can stay in order
   ////////////////////////////////////////////////////////////////////////
-  void writeMovie(const char* filename)
+  struct JPEG_DESTINATION {
+    struct jpeg_destination_mgr manager;
+    std::vector<unsigned char>* jpeg;
+
+    static void start(j_compress_ptr cinfo)
+    {
+      JPEG_DESTINATION* destination = (JPEG_DESTINATION*)cinfo->dest;
+      destination->jpeg->resize(1 << 16);
+      destination->manager.next_output_byte = &(*destination->jpeg)[0];
+      destination->manager.free_in_buffer = destination->jpeg->size();
+    };
+
+    static boolean grow(j_compress_ptr cinfo)
+    {
+      JPEG_DESTINATION* destination = (JPEG_DESTINATION*)cinfo->dest;
+      const size_t used = destination->jpeg->size();
+      destination->jpeg->resize(2 * used);
+      destination->manager.next_output_byte = &(*destination->jpeg)[used];
+      destination->manager.free_in_buffer = used;
+      return TRUE;
+    };
+
+    static void finish(j_compress_ptr cinfo)
+    {
+      JPEG_DESTINATION* destination = (JPEG_DESTINATION*)cinfo->dest;
+      destination->jpeg->resize(destination->jpeg->size() - destination->manager.free_in_buffer);
+    };
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // JPEG every frame in pixels in parallel, with one compressor per
+  // chunk of frames rather than one per frame
+  ////////////////////////////////////////////////////////////////////////
+  void compress(const std::vector<const JSAMPLE*>& pixels, std::vector<std::vector<unsigned char> >& jpegs)
+  {
+    jpegs.resize(pixels.size());
+    encoders().parallelFor((int)pixels.size(), [&](int begin, int end) {
+      struct jpeg_compress_struct cinfo;
+      struct jpeg_error_mgr jerr;
+      cinfo.err=jpeg_std_error(&jerr);
+      jpeg_create_compress(&cinfo);
+
+      JPEG_DESTINATION destination;
+      destination.manager.init_destination = JPEG_DESTINATION::start;
+      destination.manager.empty_output_buffer = JPEG_DESTINATION::grow;
+      destination.manager.term_destination = JPEG_DESTINATION::finish;
+      cinfo.dest = &destination.manager;
+
+      for (int i = begin; i < end; i++)
+      {
+        destination.jpeg = &jpegs[i];
+
+        cinfo.image_width=_width;
+        cinfo.image_height=_height;
+        cinfo.input_components=3;
+        cinfo.in_color_space=JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+
+        jpeg_set_quality(&cinfo,95,TRUE);
+        jpeg_start_compress(&cinfo,TRUE);
+
+        while(cinfo.next_scanline < cinfo.image_height)
+        {
+          JSAMPROW row_pointer[]={(JSAMPROW)pixels[i] + cinfo.next_scanline * 3 * _width};
+          jpeg_write_scanlines(&cinfo,row_pointer,1);
+        }
+        jpeg_finish_compress(&cinfo);
+      }
+      jpeg_destroy_compress(&cinfo);
+    });
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // write one compressed frame onto the end of fp, and note where it went
+  ////////////////////////////////////////////////////////////////////////
+  void append(const std::vector<unsigned char>& jpeg, FILE* fp)
+  {
+    long initial_pos=ftell(fp);
+    _offsets.push_back(int(initial_pos-_mdatBegin));
+    fwrite(&jpeg[0], 1, jpeg.size(), fp);
+    _sampleSizes.push_back(int(ftell(fp)-initial_pos));
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the streaming writer thread: take whatever frames are waiting, up
+  // to a batch, compress them all at once, and write them out in order
+  ////////////////////////////////////////////////////////////////////////
+  void writerLoop()
+  {
+    std::vector<std::vector<JSAMPLE> > batch;
+    std::vector<std::vector<unsigned char> > jpegs;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(_queueLock);
+
+        // the last batch's frames can be filled again
+        for (unsigned int x = 0; x < batch.size(); x++)
+          _spare.push_back(std::vector<JSAMPLE>());
+        for (unsigned int x = 0; x < batch.size(); x++)
+          _spare[_spare.size() - batch.size() + x].swap(batch[x]);
+        batch.clear();
+
+        _queueChanged.wait(lock, [this] { return _finishing || !_pending.empty(); });
+        if (_pending.empty())
+          return;
+
+        while (!_pending.empty() && (int)batch.size() < batchSize())
+        {
+          batch.push_back(std::vector<JSAMPLE>());
+          batch.back().swap(_pending.front());
+          _pending.pop_front();
+        }
+        _queueChanged.notify_all();
+      }
+
+      std::vector<const JSAMPLE*> pixels;
+      for (unsigned int x = 0; x < batch.size(); x++)
+        pixels.push_back(&batch[x][0]);
+      compress(pixels, jpegs);
+      for (unsigned int x = 0; x < jpegs.size(); x++)
+        append(jpegs[x], _file);
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // close off the mdat atom, then write the header and close the file
+  ////////////////////////////////////////////////////////////////////////
+  void finishStream()
+  {
+    // let the writer drain what's left
+    {
+      std::unique_lock<std::mutex> lock(_queueLock);
+      _finishing = true;
+    }
+    _queueChanged.notify_all();
+    _writer.join();
+    _spare.clear();
+
+    delete _mdat;
+    _mdat = NULL;
+    writeHeader(_file);
+    fclose(_file);
+    _file = NULL;
+    _frame.clear();
+  };
+
+  void swap(QUICKTIME_MOVIE& movie)
+  {
+    assert(!streaming() && !movie.streaming());
+    std::swap(_width, movie._width);
+    std::swap(_height, movie._height);
+    std::swap(_totalFrames, movie._totalFrames);
+    _frames.swap(movie._frames);
+    _frame.swap(movie._frame);
+    std::swap(_file, movie._file);
+    _filename.swap(movie._filename);
+    std::swap(_mdat, movie._mdat);
+    std::swap(_mdatBegin, movie._mdatBegin);
+    _sampleSizes.swap(movie._sampleSizes);
+    _offsets.swap(movie._offsets);
+    _encoders.swap(movie._encoders);
+    std::swap(_downscale, movie._downscale);
+    std::swap(_readBuffers[0], movie._readBuffers[0]);
+    std::swap(_readBuffers[1], movie._readBuffers[1]);
+    std::swap(_nextRead, movie._nextRead);
+    std::swap(_readPending, movie._readPending);
+    std::swap(_readWidth, movie._readWidth);
+    std::swap(_readHeight, movie._readHeight);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // everything after the frames, mostly the tables saying where they are
+  ////////////////////////////////////////////////////////////////////////
+  void writeHeader(FILE* fp)
   {
-    std::cout << " Writing movie " << filename << "..."; flush(std::cout);
     unsigned char EndianTest[2]={0,1};
     big_endian=*(short*)EndianTest==1;
-    //std::cout<<"big endian is "<<big_endian<<std::endl;
-
-    FILE *fp=fopen(filename,"w");
 
     const int frames_per_second=30;
 
@@ -217,55 +712,8 @@ public:
     const int width = _width;
     const int height = _height;
 
-    std::vector<int> samplesizes;
-    std::vector<int> offsets;
-
-    // Write the samples (i.e. the mdat part in the quicktime)
-    {long mdat_begin=ftell(fp);
-    QT_ATOM mdat(fp,"mdat");
-
-        struct jpeg_compress_struct cinfo;
-        struct jpeg_error_mgr jerr;
-     
-        // this is where image data is set
-        int currentFrameRow = 0;
-        for(int i = 0; i < frames; i++){
-          long initial_pos=ftell(fp);
-          offsets.push_back(int(initial_pos-mdat_begin));
-          cinfo.err=jpeg_std_error(&jerr);
-
-          jpeg_create_compress(&cinfo);
-          jpeg_stdio_dest(&cinfo,fp);
-          
-          cinfo.image_width=width;
-          cinfo.image_height=height;
-          cinfo.input_components=3;
-          cinfo.in_color_space=JCS_RGB;
-          jpeg_set_defaults(&cinfo);
-
-          jpeg_set_quality(&cinfo,95,TRUE);
-          jpeg_start_compress(&cinfo,TRUE);
-          
-          //int row_stride = cinfo.image_width * 3;
-          //JSAMPLE* row = new JSAMPLE[row_stride];
-          //unsigned char rowi=i;
-          while(cinfo.next_scanline < cinfo.image_height)
-          {
-            JSAMPROW row_pointer[]={_frameRows[currentFrameRow]};
-            /*
-            int j;
-            for(j = 0; j < row_stride; j++) 
-              row[j] = rowi;
-            rowi = (rowi+1) % 256;
-            */
-            jpeg_write_scanlines(&cinfo,row_pointer,1);
-            currentFrameRow++;
-          }
-          jpeg_finish_compress(&cinfo);
-          jpeg_destroy_compress(&cinfo);
-          samplesizes.push_back(int(ftell(fp)-initial_pos));
-        }
-    }
+    const std::vector<int>& samplesizes = _sampleSizes;
+    const std::vector<int>& offsets = _offsets;
 
     // Write the header
     {QT_ATOM a(fp,"moov");
@@ -405,16 +853,7 @@ public:
             }
         }
     }
-    fclose(fp);
-    std::cout << " done." << std::endl;
-  }
-
-private:
-  // video dimensions
-  int _width;
-  int _height;
-  std::vector<JSAMPLE*> _frameRows;
-  int _totalFrames;
+  };
 
   bool big_endian;
 
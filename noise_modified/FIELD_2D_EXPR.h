@@ -0,0 +1,164 @@
+#ifndef FIELD_2D_EXPR_H
+#define FIELD_2D_EXPR_H
+
+///////////////////////////////////////////////////////////////////////
+// Lazy arithmetic for FIELD_2D and COLOR_FIELD_2D
+//
+// The binary operators here don't compute anything, they just build
+// a small tree of nodes that gets evaluated cell by cell when it is
+// finally assigned to a field. So a line like
+//
+//   height = dt * dt / (dx * dx) * C * laplacian + 2 * height;
+//
+// turns into a single loop over the grid with no temporary fields.
+//
+// T is the cell type (float or VEC3F), so grayscale and color fields
+// can't be accidentally mixed in the same expression. When every field
+// in an expression is row-major, it gets read through rowMajorCell(),
+// which skips the layout check in FIELD_2D::operator() and lets the
+// loop vectorize. Since nodes
+// hold references to the fields they read from, don't hang onto an
+// expression past the line it was built on.
+///////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+
+template <class T, class E>
+class FIELD_2D_EXPR {
+public:
+  const E& self() const { return static_cast<const E&>(*this); };
+};
+
+///////////////////////////////////////////////////////////////////////
+// Fields are held by reference, everything else (the nodes) by value.
+// FIELD_2D.h and COLOR_FIELD_2D.h specialize this for themselves.
+///////////////////////////////////////////////////////////////////////
+template <class E>
+struct FIELD_2D_OPERAND {
+  typedef const E type;
+};
+
+///////////////////////////////////////////////////////////////////////
+// the per-cell operations
+///////////////////////////////////////////////////////////////////////
+struct FIELD_2D_ADD {
+  template <class T, class S>
+  static inline T apply(const T& a, const S& b) { return a + b; };
+};
+
+struct FIELD_2D_SUBTRACT {
+  template <class T, class S>
+  static inline T apply(const T& a, const S& b) { return a - b; };
+};
+
+struct FIELD_2D_MULTIPLY {
+  template <class T, class S>
+  static inline T apply(const T& a, const S& b) { return a * b; };
+};
+
+struct FIELD_2D_DIVIDE {
+  template <class T, class S>
+  static inline T apply(const T& a, const S& b) { return a / b; };
+};
+
+///////////////////////////////////////////////////////////////////////
+// a field combined with another field
+///////////////////////////////////////////////////////////////////////
+template <class T, class A, class B, class OP>
+class FIELD_2D_BINARY : public FIELD_2D_EXPR<T, FIELD_2D_BINARY<T, A, B, OP> > {
+public:
+  FIELD_2D_BINARY(const A& a, const B& b) :
+    _a(a), _b(b)
+  {
+    assert(a.xRes() == b.xRes());
+    assert(a.yRes() == b.yRes());
+  };
+
+  inline const T operator()(int x, int y) const { return OP::apply(_a(x, y), _b(x, y)); };
+  inline const T rowMajorCell(int x, int y) const { return OP::apply(_a.rowMajorCell(x, y), _b.rowMajorCell(x, y)); };
+  const bool rowMajor() const { return _a.rowMajor() && _b.rowMajor(); };
+  const int xRes() const { return _a.xRes(); };
+  const int yRes() const { return _a.yRes(); };
+  const int totalCells() const { return _a.totalCells(); };
+
+private:
+  typename FIELD_2D_OPERAND<A>::type _a;
+  typename FIELD_2D_OPERAND<B>::type _b;
+};
+
+///////////////////////////////////////////////////////////////////////
+// a field combined with a scalar
+///////////////////////////////////////////////////////////////////////
+template <class T, class A, class OP>
+class FIELD_2D_SCALAR : public FIELD_2D_EXPR<T, FIELD_2D_SCALAR<T, A, OP> > {
+public:
+  FIELD_2D_SCALAR(const A& a, const float alpha) :
+    _a(a), _alpha(alpha)
+  {
+  };
+
+  inline const T operator()(int x, int y) const { return OP::apply(_a(x, y), _alpha); };
+  inline const T rowMajorCell(int x, int y) const { return OP::apply(_a.rowMajorCell(x, y), _alpha); };
+  const bool rowMajor() const { return _a.rowMajor(); };
+  const int xRes() const { return _a.xRes(); };
+  const int yRes() const { return _a.yRes(); };
+  const int totalCells() const { return _a.totalCells(); };
+
+private:
+  typename FIELD_2D_OPERAND<A>::type _a;
+  const float _alpha;
+};
+
+///////////////////////////////////////////////////////////////////////
+// overloaded operators
+///////////////////////////////////////////////////////////////////////
+template <class T, class A, class B>
+inline FIELD_2D_BINARY<T, A, B, FIELD_2D_ADD>
+operator+(const FIELD_2D_EXPR<T, A>& a, const FIELD_2D_EXPR<T, B>& b)
+{
+  return FIELD_2D_BINARY<T, A, B, FIELD_2D_ADD>(a.self(), b.self());
+}
+
+template <class T, class A, class B>
+inline FIELD_2D_BINARY<T, A, B, FIELD_2D_SUBTRACT>
+operator-(const FIELD_2D_EXPR<T, A>& a, const FIELD_2D_EXPR<T, B>& b)
+{
+  return FIELD_2D_BINARY<T, A, B, FIELD_2D_SUBTRACT>(a.self(), b.self());
+}
+
+template <class T, class A>
+inline FIELD_2D_SCALAR<T, A, FIELD_2D_MULTIPLY>
+operator*(const FIELD_2D_EXPR<T, A>& a, const float alpha)
+{
+  return FIELD_2D_SCALAR<T, A, FIELD_2D_MULTIPLY>(a.self(), alpha);
+}
+
+template <class T, class A>
+inline FIELD_2D_SCALAR<T, A, FIELD_2D_MULTIPLY>
+operator*(const float alpha, const FIELD_2D_EXPR<T, A>& a)
+{
+  return FIELD_2D_SCALAR<T, A, FIELD_2D_MULTIPLY>(a.self(), alpha);
+}
+
+template <class T, class A>
+inline FIELD_2D_SCALAR<T, A, FIELD_2D_DIVIDE>
+operator/(const FIELD_2D_EXPR<T, A>& a, const float alpha)
+{
+  return FIELD_2D_SCALAR<T, A, FIELD_2D_DIVIDE>(a.self(), alpha);
+}
+
+template <class T, class A>
+inline FIELD_2D_SCALAR<T, A, FIELD_2D_ADD>
+operator+(const FIELD_2D_EXPR<T, A>& a, const float alpha)
+{
+  return FIELD_2D_SCALAR<T, A, FIELD_2D_ADD>(a.self(), alpha);
+}
+
+template <class T, class A>
+inline FIELD_2D_SCALAR<T, A, FIELD_2D_ADD>
+operator+(const float alpha, const FIELD_2D_EXPR<T, A>& a)
+{
+  return FIELD_2D_SCALAR<T, A, FIELD_2D_ADD>(a.self(), alpha);
+}
+
+#endif
@@ -0,0 +1,617 @@
+#ifndef FIELD_2D_STENCIL_H
+#define FIELD_2D_STENCIL_H
+
+///////////////////////////////////////////////////////////////////////
+// Stencils over a FIELD_2D, e.g. the Laplacian for the PDE demos
+//
+// The coefficients and the boundary handling are both compile time
+// parameters, so the interior loop is fully unrolled over the taps and
+// runs straight down the rows with no index math. Rows are split
+// across THREAD_POOL::shared() for big fields. Building with -mavx2 or
+// -mavx512f (or just -march=native) turns on the explicit 8 and 16 wide
+// inner loops, otherwise it's left to the auto-vectorizer.
+//
+// To take a Laplacian:
+//
+//   FIELD_2D_STENCIL<FIELD_2D_LAPLACIAN_5>::apply(height, laplacian);
+//
+// or to do an explicit diffusion step, output = input + scale * L(input):
+//
+//   FIELD_2D_STENCIL<FIELD_2D_LAPLACIAN_5>::step(old, field, dt * alpha);
+//
+// Sums are accumulated in tap order, so LAPLACIAN_5 gives the exact
+// same floats as the hand-written -4 * center + right + left + up + down.
+//
+// To take several explicit steps at once, temporally blocked:
+//
+//   FIELD_2D_STENCIL<FIELD_2D_LAPLACIAN_5>::steps(field, scratch, dt * alpha, 8);
+//
+// The rows get swept once per pass with every intermediate timestep
+// kept in a few cached rows, so a pass over memory buys several
+// timesteps instead of one. The results are the same as calling
+// step() that many times.
+//
+// Fields in one of the tiled layouts get swept a tile at a time. Each
+// tile and a RADIUS wide halo around it are copied into a small
+// row-major block that stays in cache, and the same inner loop runs
+// over that, so every layout gives the same results (the border cells
+// can differ in the last bit if the compiler fuses multiply-adds).
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "THREAD_POOL.h"
+#include <cassert>
+#include <vector>
+
+// default and largest number of timesteps per pass for steps()
+#define FIELD_2D_STENCIL_DEPTH 8
+#define FIELD_2D_STENCIL_MAX_DEPTH 32
+
+#if defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////
+// Coefficient sets. Each one lists its taps as (dx, dy, weight) and
+// how far out from the center they reach.
+///////////////////////////////////////////////////////////////////////
+
+// the usual 5-point Laplacian
+struct FIELD_2D_LAPLACIAN_5 {
+  enum { RADIUS = 1, TAPS = 5 };
+  static inline int dx(int t)       { static const int d[TAPS] = {0, 1, -1, 0, 0}; return d[t]; };
+  static inline int dy(int t)       { static const int d[TAPS] = {0, 0, 0, 1, -1}; return d[t]; };
+  static inline float weight(int t) { static const float w[TAPS] = {-4, 1, 1, 1, 1}; return w[t]; };
+};
+
+// the isotropic 9-point Laplacian, (4 * edges + corners - 20 * center) / 6
+struct FIELD_2D_LAPLACIAN_9 {
+  enum { RADIUS = 1, TAPS = 9 };
+  static inline int dx(int t) { static const int d[TAPS] = {0, 1, -1, 0, 0, 1, -1, 1, -1}; return d[t]; };
+  static inline int dy(int t) { static const int d[TAPS] = {0, 0, 0, 1, -1, 1, 1, -1, -1}; return d[t]; };
+  static inline float weight(int t) {
+    static const float w[TAPS] = {-20.0f / 6.0f, 4.0f / 6.0f, 4.0f / 6.0f, 4.0f / 6.0f, 4.0f / 6.0f,
+                                  1.0f / 6.0f, 1.0f / 6.0f, 1.0f / 6.0f, 1.0f / 6.0f};
+    return w[t];
+  };
+};
+
+// the fourth order accurate Laplacian, a 5-wide cross
+struct FIELD_2D_LAPLACIAN_4TH {
+  enum { RADIUS = 2, TAPS = 9 };
+  static inline int dx(int t) { static const int d[TAPS] = {0, 1, -1, 0, 0, 2, -2, 0, 0}; return d[t]; };
+  static inline int dy(int t) { static const int d[TAPS] = {0, 0, 0, 1, -1, 0, 0, 2, -2}; return d[t]; };
+  static inline float weight(int t) {
+    static const float w[TAPS] = {-5.0f, 4.0f / 3.0f, 4.0f / 3.0f, 4.0f / 3.0f, 4.0f / 3.0f,
+                                  -1.0f / 12.0f, -1.0f / 12.0f, -1.0f / 12.0f, -1.0f / 12.0f};
+    return w[t];
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// Boundary policies, i.e. what the cells within RADIUS of the edge do
+//
+// GHOSTS says how the cells just outside the field change from one
+// timestep to the next, which steps() needs to know to carry them along
+// in its blocks: not read at all, always zero, copies of the nearest
+// edge cell, wrapped copies of cells that get stepped like any other,
+// or cells of some bigger field that hold still (steps() can't block
+// those, and just takes one step at a time).
+///////////////////////////////////////////////////////////////////////
+
+enum FIELD_2D_GHOSTS { FIELD_2D_GHOSTS_UNUSED, FIELD_2D_GHOSTS_ZERO, FIELD_2D_GHOSTS_CLAMP,
+                       FIELD_2D_GHOSTS_WRAP, FIELD_2D_GHOSTS_HELD };
+
+// the stencil is zero on the border, so the border just holds its value
+// (this is what the interior-only demo loops have always done)
+struct FIELD_2D_BOUNDARY_FIXED {
+  enum { SAMPLES_BORDER = 0 };
+  static const FIELD_2D_GHOSTS GHOSTS = FIELD_2D_GHOSTS_UNUSED;
+  static inline float sample(const FIELD_2D& field, int x, int y) { return 0; };
+};
+
+// everything outside the field is zero
+struct FIELD_2D_BOUNDARY_ZERO {
+  enum { SAMPLES_BORDER = 1 };
+  static const FIELD_2D_GHOSTS GHOSTS = FIELD_2D_GHOSTS_ZERO;
+  static inline float sample(const FIELD_2D& field, int x, int y) {
+    if (x < 0 || y < 0 || x >= field.xRes() || y >= field.yRes()) return 0;
+    return field(x, y);
+  };
+};
+
+// repeat the edge values outward, i.e. no flux through the border
+struct FIELD_2D_BOUNDARY_CLAMP {
+  enum { SAMPLES_BORDER = 1 };
+  static const FIELD_2D_GHOSTS GHOSTS = FIELD_2D_GHOSTS_CLAMP;
+  static inline float sample(const FIELD_2D& field, int x, int y) {
+    x = (x < 0) ? 0 : (x >= field.xRes()) ? field.xRes() - 1 : x;
+    y = (y < 0) ? 0 : (y >= field.yRes()) ? field.yRes() - 1 : y;
+    return field(x, y);
+  };
+};
+
+// wrap around, so the field is a torus
+struct FIELD_2D_BOUNDARY_PERIODIC {
+  enum { SAMPLES_BORDER = 1 };
+  static const FIELD_2D_GHOSTS GHOSTS = FIELD_2D_GHOSTS_WRAP;
+  static inline float sample(const FIELD_2D& field, int x, int y) {
+    x = ((x % field.xRes()) + field.xRes()) % field.xRes();
+    y = ((y % field.yRes()) + field.yRes()) % field.yRes();
+    return field(x, y);
+  };
+};
+
+// read straight through to the cells around a FIELD_2D_VIEW, so a view
+// of the interior gets the same answer as the whole field would. The
+// view needs RADIUS cells of its field on every side.
+struct FIELD_2D_BOUNDARY_HALO {
+  enum { SAMPLES_BORDER = 1 };
+  static const FIELD_2D_GHOSTS GHOSTS = FIELD_2D_GHOSTS_HELD;
+  static inline float sample(const FIELD_2D& field, int x, int y) {
+    assert(field.isView());
+    return field.data()[y * field.pitch() + x];
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class STENCIL, class BOUNDARY = FIELD_2D_BOUNDARY_FIXED>
+class FIELD_2D_STENCIL {
+public:
+  ////////////////////////////////////////////////////////////////////////
+  // output = scale * S(input)
+  ////////////////////////////////////////////////////////////////////////
+  static void apply(const FIELD_2D& input, FIELD_2D& output, const float scale = 1.0)
+  {
+    if (output.xRes() != input.xRes() || output.yRes() != input.yRes())
+      output.resizeAndWipe(input.xRes(), input.yRes());
+    run(input, NULL, output, scale);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // output += scale * S(input)
+  ////////////////////////////////////////////////////////////////////////
+  static void accumulate(const FIELD_2D& input, FIELD_2D& output, const float scale = 1.0)
+  {
+    assert(output.xRes() == input.xRes());
+    assert(output.yRes() == input.yRes());
+    run(input, &output, output, scale);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // output = input + scale * S(input), i.e. one explicit Euler step
+  ////////////////////////////////////////////////////////////////////////
+  static void step(const FIELD_2D& input, FIELD_2D& output, const float scale = 1.0)
+  {
+    if (output.xRes() != input.xRes() || output.yRes() != input.yRes())
+      output.resizeAndWipe(input.xRes(), input.yRes());
+    run(input, &input, output, scale);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // take totalSteps explicit Euler steps of field, depth steps per
+  // pass over memory. scratch gets resized if it needs to be, and the
+  // two trade storage, so the answer always ends up in field.
+  ////////////////////////////////////////////////////////////////////////
+  static void steps(FIELD_2D& field, FIELD_2D& scratch, const float scale, const int totalSteps,
+                    const int depth = FIELD_2D_STENCIL_DEPTH)
+  {
+    assert(&field != &scratch);
+    assert(depth > 0 && depth <= FIELD_2D_STENCIL_MAX_DEPTH);
+    if (scratch.xRes() != field.xRes() || scratch.yRes() != field.yRes() || scratch.layout() != field.layout())
+      scratch.resizeAndWipe(field.xRes(), field.yRes(), field.layout());
+
+    // the held cells around a view can't be carried along in a block
+    const int blockDepth = (BOUNDARY::GHOSTS == FIELD_2D_GHOSTS_HELD) ? 1 : depth;
+    for (int done = 0; done < totalSteps; done += blockDepth)
+    {
+      const int passSteps = (totalSteps - done < blockDepth) ? totalSteps - done : blockDepth;
+      if (passSteps == 1)
+        run(field, &field, scratch, scale);
+      else
+        runBlocked(field, scratch, scale, passSteps);
+      field.swap(scratch);
+    }
+  };
+
+private:
+  ////////////////////////////////////////////////////////////////////////
+  // output = base + scale * S(input), where a NULL base means zero
+  ////////////////////////////////////////////////////////////////////////
+  static void run(const FIELD_2D& input, const FIELD_2D* base, FIELD_2D& output, const float scale)
+  {
+    // the stencil reads neighbors, so it can't run in place
+    assert(&input != &output);
+
+    if (input.layout() != FIELD_2D_ROW_MAJOR || output.layout() != FIELD_2D_ROW_MAJOR ||
+        (base && base->layout() != FIELD_2D_ROW_MAJOR))
+    {
+      runTiled(input, base, output, scale);
+      return;
+    }
+
+    const int xRes = input.xRes();
+    const int yRes = input.yRes();
+    const int R = STENCIL::RADIUS;
+
+    // rows far enough from the top and bottom to take the fast path
+    const int yBegin = (yRes > 2 * R) ? R : yRes;
+    const int yEnd = (yRes > 2 * R) ? yRes - R : yRes;
+
+    // keep each chunk at a few tens of thousands of cells so small
+    // fields don't pay for waking up the pool
+    const int minRows = 65536 / (xRes > 0 ? xRes : 1) + 1;
+    THREAD_POOL::shared().parallelFor(yEnd - yBegin, [&](int begin, int end) {
+      for (int y = yBegin + begin; y < yBegin + end; y++)
+      {
+        if (base)
+          row<true>(input, base, output, y, scale);
+        else
+          row<false>(input, base, output, y, scale);
+      }
+    }, minRows);
+
+    // the top and bottom border rows
+    for (int y = 0; y < yRes; y++)
+    {
+      if (y == yBegin) y = yEnd;
+      if (y >= yRes) break;
+      for (int x = 0; x < xRes; x++)
+        borderCell(input, base, output, x, y, scale);
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // run() for fields that aren't row-major, one tile at a time
+  ////////////////////////////////////////////////////////////////////////
+  static void runTiled(const FIELD_2D& input, const FIELD_2D* base, FIELD_2D& output, const float scale)
+  {
+    const int xRes = input.xRes();
+    const int yRes = input.yRes();
+    const int R = STENCIL::RADIUS;
+    const int T = FIELD_2D_TILE;
+    const int xTiles = (xRes + T - 1) / T;
+    const int yTiles = (yRes + T - 1) / T;
+    const int width = T + 2 * R;
+
+    THREAD_POOL::shared().parallelFor(xTiles * yTiles, [&](int begin, int end) {
+      std::vector<float> block(width * width);
+      std::vector<float> baseRow(T);
+      std::vector<float> outRow(T);
+
+      for (int tile = begin; tile < end; tile++)
+      {
+        const int xStart = (tile % xTiles) * T;
+        const int yStart = (tile / xTiles) * T;
+        const int w = (xRes - xStart < T) ? xRes - xStart : T;
+        const int h = (yRes - yStart < T) ? yRes - yStart : T;
+
+        gather(input, xStart, yStart, w, h, R, &block[0], width);
+
+        // the fixed border just holds its value, which gets patched in
+        // after the fact, so those tiles need their own copy of base
+        const bool fixedBorder = !BOUNDARY::SAMPLES_BORDER &&
+          (xStart < R || xStart + w > xRes - R || yStart < R || yStart + h > yRes - R);
+
+        // a row of a tile is contiguous in everything but the Morton
+        // layout, so read and write those in place
+        const bool baseInPlace = base && base->layout() != FIELD_2D_MORTON && !fixedBorder;
+        const bool outInPlace = output.layout() != FIELD_2D_MORTON;
+
+        for (int y = 0; y < h; y++)
+        {
+          const float* taps[STENCIL::TAPS];
+          for (int t = 0; t < STENCIL::TAPS; t++)
+            taps[t] = &block[(y + R + STENCIL::dy(t)) * width + R + STENCIL::dx(t)];
+
+          const float* baseData = NULL;
+          if (baseInPlace)
+            baseData = base->data() + base->index(xStart, yStart + y);
+          else if (base)
+          {
+            base->getRun(xStart, yStart + y, w, &baseRow[0]);
+            baseData = &baseRow[0];
+          }
+          float* outData = outInPlace ? output.data() + output.index(xStart, yStart + y) : &outRow[0];
+
+          if (base)
+            kernel<true>(taps, baseData, outData, 0, w, scale);
+          else
+            kernel<false>(taps, NULL, outData, 0, w, scale);
+
+          if (fixedBorder)
+            for (int x = 0; x < w; x++)
+            {
+              const int xField = xStart + x;
+              const int yField = yStart + y;
+              if (xField < R || xField >= xRes - R || yField < R || yField >= yRes - R)
+                outData[x] = base ? baseData[x] : 0.0f;
+            }
+
+          if (!outInPlace)
+            output.setRun(xStart, yStart + y, w, outData);
+        }
+      }
+    }, 65536 / (T * T) + 1);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // output = input stepped passSteps times, in one sweep down the rows
+  //
+  // Every timestep level keeps a ring of the last 2 * RADIUS + 1 rows
+  // it made. Reading one more input row lets level 1 make the row
+  // RADIUS above it, which lets level 2 make the row RADIUS above that,
+  // and so on, so the rows in flight stay in cache and only the input
+  // and the last level ever touch memory. The rows get split into one
+  // band per thread, and each band starts passSteps * RADIUS rows early
+  // and ends that many late so it doesn't need its neighbors.
+  //
+  // Every row goes through the same kernel() as run(), with the
+  // boundary filled in around it as ghost cells, so the floats come out
+  // the same as stepping one timestep at a time.
+  ////////////////////////////////////////////////////////////////////////
+  static void runBlocked(const FIELD_2D& input, FIELD_2D& output, const float scale, const int passSteps)
+  {
+    const int yRes = input.yRes();
+    const int threads = THREAD_POOL::shared().threads();
+
+    // keep bands a good deal taller than their overlap
+    const int minRows = 16 * passSteps * STENCIL::RADIUS;
+    int bands = yRes / minRows;
+    bands = (bands < threads) ? bands : threads;
+    bands = (bands < 1) ? 1 : bands;
+
+    THREAD_POOL::shared().parallelFor(bands, [&](int begin, int end) {
+      for (int band = begin; band < end; band++)
+        sweep(input, output, scale, passSteps, band * yRes / bands, (band + 1) * yRes / bands);
+    }, 1);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // runBlocked() for output rows [yBegin, yEnd)
+  ////////////////////////////////////////////////////////////////////////
+  static void sweep(const FIELD_2D& input, FIELD_2D& output, const float scale, const int passSteps,
+                    const int yBegin, const int yEnd)
+  {
+    const int xRes = input.xRes();
+    const int yRes = input.yRes();
+    const int R = STENCIL::RADIUS;
+    const int halo = passSteps * R;
+    const int ring = 2 * R + 1;
+    const int width = xRes + 2 * R;
+    const bool wraps = BOUNDARY::GHOSTS == FIELD_2D_GHOSTS_WRAP;
+
+    // rows of level 0 through passSteps, each with R ghosts either side
+    std::vector<float> rows((passSteps + 1) * ring * width);
+    std::vector<float> zeros(width, 0.0f);
+
+    // which rows level k makes. Wrapped ghost rows get stepped like any
+    // other row, while the rest get looked up from the field rows.
+    std::vector<int> first(passSteps + 1), last(passSteps + 1);
+    for (int k = 0; k <= passSteps; k++)
+    {
+      first[k] = yBegin - halo + k * R;
+      last[k] = yEnd + halo - k * R;
+      if (!wraps)
+      {
+        first[k] = (first[k] < 0) ? 0 : first[k];
+        last[k] = (last[k] > yRes) ? yRes : last[k];
+      }
+    }
+
+    for (int y0 = first[0]; y0 < last[0] + halo; y0++)
+    {
+      // read in the next row of level 0
+      if (y0 < last[0])
+      {
+        float* row = ringRow(rows, 0, y0, width);
+        const int ySource = wraps ? ((y0 % yRes) + yRes) % yRes : y0;
+        input.getRun(0, ySource, xRes, row + R);
+        fillGhosts(row, xRes);
+      }
+
+      // and then the rows it frees up further down
+      for (int k = 1; k <= passSteps; k++)
+      {
+        const int y = y0 - k * R;
+        if (y < first[k] || y >= last[k]) continue;
+
+        const float* taps[STENCIL::TAPS];
+        for (int t = 0; t < STENCIL::TAPS; t++)
+          taps[t] = levelRow(rows, zeros, k - 1, y + STENCIL::dy(t), width, yRes) + R + STENCIL::dx(t);
+        const float* baseRow = levelRow(rows, zeros, k - 1, y, width, yRes) + R;
+        float* outRow = ringRow(rows, k, y, width) + R;
+
+        // FIXED holds its border, and never reads past it
+        if (BOUNDARY::GHOSTS == FIELD_2D_GHOSTS_UNUSED && (y < R || y >= yRes - R))
+          for (int x = 0; x < xRes; x++)
+            outRow[x] = baseRow[x];
+        else
+        {
+          kernel<true>(taps, baseRow, outRow, 0, xRes, scale);
+          if (BOUNDARY::GHOSTS == FIELD_2D_GHOSTS_UNUSED)
+            for (int x = 0; x < R && x < xRes; x++)
+            {
+              outRow[x] = baseRow[x];
+              outRow[xRes - 1 - x] = baseRow[xRes - 1 - x];
+            }
+        }
+        fillGhosts(outRow - R, xRes);
+
+        if (k == passSteps && y >= yBegin && y < yEnd)
+          output.setRun(0, y, xRes, outRow);
+      }
+    }
+  };
+
+  // where level k keeps row y
+  static inline float* ringRow(std::vector<float>& rows, const int k, const int y, const int width)
+  {
+    const int ring = 2 * STENCIL::RADIUS + 1;
+    return &rows[(k * ring + ((y % ring) + ring) % ring) * width];
+  };
+
+  // row y of level k, with the rows past the top and bottom looked up
+  // through the boundary policy
+  static inline const float* levelRow(std::vector<float>& rows, const std::vector<float>& zeros,
+                                      const int k, int y, const int width, const int yRes)
+  {
+    if (BOUNDARY::GHOSTS != FIELD_2D_GHOSTS_WRAP && (y < 0 || y >= yRes))
+    {
+      if (BOUNDARY::GHOSTS != FIELD_2D_GHOSTS_CLAMP)
+        return &zeros[0];
+      y = (y < 0) ? 0 : yRes - 1;
+    }
+    return ringRow(rows, k, y, width);
+  };
+
+  // fill in the RADIUS ghost cells on either end of a row
+  static inline void fillGhosts(float* row, const int xRes)
+  {
+    const int R = STENCIL::RADIUS;
+    for (int x = 0; x < R; x++)
+    {
+      float left = 0.0f, right = 0.0f;
+      if (BOUNDARY::GHOSTS == FIELD_2D_GHOSTS_CLAMP)
+      {
+        left = row[R];
+        right = row[R + xRes - 1];
+      }
+      else if (BOUNDARY::GHOSTS == FIELD_2D_GHOSTS_WRAP)
+      {
+        left = row[R + (((x - R) % xRes) + xRes) % xRes];
+        right = row[R + (xRes + x) % xRes];
+      }
+      row[x] = left;
+      row[R + xRes + x] = right;
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // copy the w x h tile starting at (xStart, yStart), plus a halo
+  // around it, into a row-major block. The tile rows come over whole,
+  // the halo cell by cell, and anything outside the field goes through
+  // the boundary policy.
+  ////////////////////////////////////////////////////////////////////////
+  static void gather(const FIELD_2D& input, const int xStart, const int yStart,
+                     const int w, const int h, const int R, float* block, const int width)
+  {
+    const int xRes = input.xRes();
+    const int yRes = input.yRes();
+
+    for (int y = yStart - R; y < yStart + h + R; y++)
+    {
+      // blockRow[x] is cell xStart + x
+      float* blockRow = block + (y - yStart + R) * width + R;
+
+      if (y < 0 || y >= yRes)
+      {
+        for (int x = -R; x < w + R; x++)
+          blockRow[x] = BOUNDARY::sample(input, xStart + x, y);
+        continue;
+      }
+
+      for (int x = -R; x < 0; x++)
+        blockRow[x] = (xStart + x >= 0) ? input(xStart + x, y) : BOUNDARY::sample(input, xStart + x, y);
+      input.getRun(xStart, y, w, blockRow);
+      for (int x = w; x < w + R; x++)
+        blockRow[x] = (xStart + x < xRes) ? input(xStart + x, y) : BOUNDARY::sample(input, xStart + x, y);
+    }
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // a single cell near the border
+  ////////////////////////////////////////////////////////////////////////
+  static inline void borderCell(const FIELD_2D& input, const FIELD_2D* base, FIELD_2D& output,
+                                int x, int y, const float scale)
+  {
+    const float start = base ? (*base)(x, y) : 0.0f;
+
+    if (!BOUNDARY::SAMPLES_BORDER)
+    {
+      output(x, y) = start;
+      return;
+    }
+
+    float sum = STENCIL::weight(0) * BOUNDARY::sample(input, x + STENCIL::dx(0), y + STENCIL::dy(0));
+    for (int t = 1; t < STENCIL::TAPS; t++)
+      sum += STENCIL::weight(t) * BOUNDARY::sample(input, x + STENCIL::dx(t), y + STENCIL::dy(t));
+
+    output(x, y) = base ? start + scale * sum : scale * sum;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // one row that is far enough from the top and bottom, the left and
+  // right ends still go through the boundary policy
+  ////////////////////////////////////////////////////////////////////////
+  template <bool BASE>
+  static void row(const FIELD_2D& input, const FIELD_2D* base, FIELD_2D& output,
+                  const int y, const float scale)
+  {
+    const int xRes = input.xRes();
+    const int R = STENCIL::RADIUS;
+    const int xBegin = (xRes > 2 * R) ? R : xRes;
+    const int xEnd = (xRes > 2 * R) ? xRes - R : xRes;
+
+    for (int x = 0; x < xBegin; x++)
+      borderCell(input, base, output, x, y, scale);
+    for (int x = xEnd; x < xRes; x++)
+      borderCell(input, base, output, x, y, scale);
+
+    // pointers to each tap, offset so that taps[t][x] is the tap for cell x
+    const float* taps[STENCIL::TAPS];
+    for (int t = 0; t < STENCIL::TAPS; t++)
+      taps[t] = input.row(y + STENCIL::dy(t)) + STENCIL::dx(t);
+
+    const float* baseRow = BASE ? base->row(y) : NULL;
+    kernel<BASE>(taps, baseRow, output.row(y), xBegin, xEnd, scale);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // outRow[x] = baseRow[x] + scale * S for x in [begin, end), where
+  // taps[t][x] is tap t for cell x
+  ////////////////////////////////////////////////////////////////////////
+  template <bool BASE>
+  static inline void kernel(const float* const* taps, const float* baseRow, float* outRow,
+                            const int begin, const int end, const float scale)
+  {
+    int x = begin;
+
+#if defined(__AVX512F__)
+    const __m512 scale16 = _mm512_set1_ps(scale);
+    for (; x + 16 <= end; x += 16)
+    {
+      __m512 sum = _mm512_mul_ps(_mm512_set1_ps(STENCIL::weight(0)), _mm512_loadu_ps(taps[0] + x));
+      for (int t = 1; t < STENCIL::TAPS; t++)
+        sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_set1_ps(STENCIL::weight(t)), _mm512_loadu_ps(taps[t] + x)));
+      sum = _mm512_mul_ps(scale16, sum);
+      if (BASE)
+        sum = _mm512_add_ps(_mm512_loadu_ps(baseRow + x), sum);
+      _mm512_storeu_ps(outRow + x, sum);
+    }
+#endif
+#if defined(__AVX__)
+    const __m256 scale8 = _mm256_set1_ps(scale);
+    for (; x + 8 <= end; x += 8)
+    {
+      __m256 sum = _mm256_mul_ps(_mm256_set1_ps(STENCIL::weight(0)), _mm256_loadu_ps(taps[0] + x));
+      for (int t = 1; t < STENCIL::TAPS; t++)
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(STENCIL::weight(t)), _mm256_loadu_ps(taps[t] + x)));
+      sum = _mm256_mul_ps(scale8, sum);
+      if (BASE)
+        sum = _mm256_add_ps(_mm256_loadu_ps(baseRow + x), sum);
+      _mm256_storeu_ps(outRow + x, sum);
+    }
+#endif
+    for (; x < end; x++)
+    {
+      float sum = STENCIL::weight(0) * taps[0][x];
+      for (int t = 1; t < STENCIL::TAPS; t++)
+        sum += STENCIL::weight(t) * taps[t][x];
+      outRow[x] = BASE ? baseRow[x] + scale * sum : scale * sum;
+    }
+  };
+};
+
+#endif
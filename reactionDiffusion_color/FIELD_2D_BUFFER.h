@@ -0,0 +1,57 @@
+#ifndef FIELD_2D_BUFFER_H
+#define FIELD_2D_BUFFER_H
+
+///////////////////////////////////////////////////////////////////////
+// A ring of same-sized fields for time stepping, so a simulation
+// never has to deep copy one timestep into another.
+//
+// Level 0 is the current timestep, level 1 the one before it, and so
+// on. The oldest level is the one to write the next timestep into:
+//
+//   FIELD_2D& next = buffer.oldest();
+//   ... fill in next using buffer[0], buffer[1], ...
+//   buffer.rotate();
+//
+// after which next is buffer[0]. Rotation just swaps data pointers,
+// so each level keeps its identity and can be bound to a reference.
+// Works for both FIELD_2D and COLOR_FIELD_2D.
+///////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+
+template <class FIELD, int LEVELS = 2>
+class FIELD_2D_BUFFER {
+public:
+  FIELD_2D_BUFFER(const int& xRes, const int& yRes)
+  {
+    for (int x = 0; x < LEVELS; x++)
+      _levels[x] = FIELD(xRes, yRes);
+  };
+
+  // accessors
+  inline FIELD& operator[](int x) { assert(x >= 0 && x < LEVELS); return _levels[x]; };
+  inline const FIELD& operator[](int x) const { assert(x >= 0 && x < LEVELS); return _levels[x]; };
+  inline FIELD& current() { return _levels[0]; };
+  inline FIELD& oldest() { return _levels[LEVELS - 1]; };
+  const int levels() const { return LEVELS; };
+
+  // the oldest level becomes the current one, everything else
+  // moves back one step
+  void rotate()
+  {
+    for (int x = LEVELS - 1; x > 0; x--)
+      _levels[x].swap(_levels[x - 1]);
+  };
+
+  // wipe every level
+  void clear()
+  {
+    for (int x = 0; x < LEVELS; x++)
+      _levels[x].clear();
+  };
+
+private:
+  FIELD _levels[LEVELS];
+};
+
+#endif
@@ -2,11 +2,16 @@
 #include <jpeglib.h>
 #include <png.h>
 #include <assert.h>
+#include <algorithm>
+#include "FIELD_2D_REDUCE.h"
+
+// the reductions treat the field as a flat array of floats
+static_assert(sizeof(VEC3F) == 3 * sizeof(float), "VEC3F must be three packed floats");
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D::COLOR_FIELD_2D(const int& rows, const int& cols) :
-  _xRes(rows), _yRes(cols)
+  _xRes(rows), _yRes(cols), _pitch(rows), _view(false)
 {
   _totalCells = _xRes * _yRes;
   _data = new VEC3F[_totalCells];
@@ -15,34 +20,102 @@ COLOR_FIELD_2D::COLOR_FIELD_2D(const int& rows, const int& cols) :
     _data[x] = 0.0;
 }
 
+///////////////////////////////////////////////////////////////////////
+// a copy of a view gets dense storage of its own
+///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D::COLOR_FIELD_2D(const COLOR_FIELD_2D& m) :
-  _xRes(m.xRes()), _yRes(m.yRes())
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL), _view(false)
 {
-  _totalCells = _xRes * _yRes;
-  _data = new VEC3F[_totalCells];
-
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = m[x];
+  reallocate(m.xRes(), m.yRes());
+  forEachCell(m, [](VEC3F& cell, const VEC3F& inputCell) { cell = inputCell; });
 }
 
 COLOR_FIELD_2D::COLOR_FIELD_2D() :
-  _xRes(0), _yRes(0), _totalCells(0), _data(NULL)
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL), _view(false)
+{
+}
+
+///////////////////////////////////////////////////////////////////////
+// a view doesn't own its storage, so there is nothing to steal from it
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D::COLOR_FIELD_2D(COLOR_FIELD_2D&& m) :
+  _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL), _view(false)
+{
+  if (m._view)
+    *this = (const COLOR_FIELD_2D&)m;
+  else
+    swap(m);
+}
+
+///////////////////////////////////////////////////////////////////////
+// wrap storage owned by another field, which has to outlive this one
+///////////////////////////////////////////////////////////////////////
+COLOR_FIELD_2D::COLOR_FIELD_2D(VEC3F* data, int xRes, int yRes, int pitch) :
+  _xRes(xRes), _yRes(yRes), _pitch(pitch), _totalCells(xRes * yRes), _data(data), _view(true)
 {
+  assert(pitch >= xRes);
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D::~COLOR_FIELD_2D()
 {
-  delete[] _data;
+  if (!_view)
+    delete[] _data;
+}
+
+///////////////////////////////////////////////////////////////////////
+// throw out the old storage and allocate new, dense storage. A view
+// lets go of its field and becomes a field of its own.
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::reallocate(int xRes, int yRes)
+{
+  if (!_view)
+    delete[] _data;
+  _view = false;
+
+  _xRes = xRes;
+  _yRes = yRes;
+  _pitch = xRes;
+  _totalCells = _xRes * _yRes;
+  _data = new VEC3F[_totalCells];
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void COLOR_FIELD_2D::forEachCell(OP op)
+{
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    for (int x = 0; x < _xRes; x++)
+      op(cells[x]);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class OP>
+void COLOR_FIELD_2D::forEachCell(const COLOR_FIELD_2D& input, OP op)
+{
+  assert(input.xRes() == _xRes);
+  assert(input.yRes() == _yRes);
+
+  for (int y = 0; y < _yRes; y++)
+  {
+    VEC3F* cells = row(y);
+    const VEC3F* inputCells = input.row(y);
+    for (int x = 0; x < _xRes; x++)
+      op(cells[x], inputCells[x]);
+  }
 }
   
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 void COLOR_FIELD_2D::clear()
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = 0.0;
+  forEachCell([](VEC3F& cell) { cell = 0.0; });
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -52,12 +125,14 @@ void COLOR_FIELD_2D::writePPM(string filename)
   FILE *fp;
   unsigned char* pixels = new unsigned char[3 * _totalCells];
 
-  for (int x = 0; x < _totalCells; x++)
-  {
-    pixels[3 * x] = 255 * _data[x][0];
-    pixels[3 * x + 1] = 255 * _data[x][1];
-    pixels[3 * x + 2] = 255 * _data[x][2];
-  }
+  int index = 0;
+  for (int y = 0; y < _yRes; y++)
+    for (int x = 0; x < _xRes; x++, index++)
+    {
+      pixels[3 * index] = 255 * (*this)(x, y)[0];
+      pixels[3 * index + 1] = 255 * (*this)(x, y)[1];
+      pixels[3 * index + 2] = 255 * (*this)(x, y)[2];
+    }
 
   fp = fopen(filename.c_str(), "wb");
   fprintf(fp, "P6\n%d %d\n255\n", _xRes, _yRes);
@@ -132,12 +207,7 @@ void COLOR_FIELD_2D::readPNG(string filename)
   fclose(fp);
 
   // push the data into the member variables
-  _xRes = width;
-  _yRes = height;
-  _totalCells = _xRes * _yRes;
-
-  if (_data) delete[] _data;
-  _data = new VEC3F[_totalCells];
+  reallocate(width, height);
 
   if (color_type == PNG_COLOR_TYPE_GRAY)
   {
@@ -345,20 +415,47 @@ void COLOR_FIELD_2D::writeJPG(string filename)
 ///////////////////////////////////////////////////////////////////////
 void COLOR_FIELD_2D::normalize()
 {
-  float maxFound = 0.0;
-  float minFound = _data[0].magnitude();
-  for (int x = 0; x < _totalCells; x++)
-    for (int y = 0; y < 3; y++)
+  if (_totalCells == 0) return;
+
+  // one range for all three channels
+  FIELD_2D_REDUCTION<3> stats = reduce();
+  float minFound = stats.minAll();
+  float maxFound = stats.maxAll();
+
+  // the max has always been clamped to at least zero
+  maxFound = (maxFound > 0.0) ? maxFound : 0.0;
+
+  float range = 1.0 / (maxFound - minFound);
+  const int minRows = 65536 / (3 * _xRes) + 1;
+  THREAD_POOL::shared().parallelFor(_yRes, [&](int begin, int end) {
+    for (int y = begin; y < end; y++)
     {
-      maxFound = (_data[x][y] > maxFound) ? _data[x][y] : maxFound;
-      minFound = (_data[x][y] < minFound) ? _data[x][y] : minFound;
+      float* floats = (float*)row(y);
+      for (int x = 0; x < 3 * _xRes; x++)
+        floats[x] = (floats[x] - minFound) * range;
     }
+  }, minRows);
+}
 
-  float range = 1.0 / (maxFound - minFound);
-  for (int x = 0; x < _totalCells; x++)
+///////////////////////////////////////////////////////////////////////
+// per-channel min, max and sum in a single parallel sweep
+///////////////////////////////////////////////////////////////////////
+FIELD_2D_REDUCTION<3> COLOR_FIELD_2D::reduce() const
+{
+  return FIELD_2D_REDUCE<3>(_yRes, _xRes,
+    [this](int y, FIELD_2D_REDUCTION<3>& partial) { partial.add((const float*)row(y), _xRes); });
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+void COLOR_FIELD_2D::minMaxSum(VEC3F& minFound, VEC3F& maxFound, VEC3F& total) const
+{
+  FIELD_2D_REDUCTION<3> stats = reduce();
+  for (int x = 0; x < 3; x++)
   {
-    _data[x] -= minFound;
-    _data[x] *= range;
+    minFound[x] = stats.minFound[x];
+    maxFound[x] = stats.maxFound[x];
+    total[x] = stats.total[x];
   }
 }
 
@@ -366,14 +463,16 @@ void COLOR_FIELD_2D::normalize()
 ///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D& COLOR_FIELD_2D::abs()
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = VEC3F::fabs(_data[x]);
+  forEachCell([](VEC3F& cell) { cell = VEC3F::fabs(cell); });
 
   return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
+// a view stays a view if the size doesn't change, and gets storage of
+// its own if it does
+///////////////////////////////////////////////////////////////////////
 void COLOR_FIELD_2D::resizeAndWipe(int xRes, int yRes)
 {
   if (_xRes == xRes && _yRes == yRes)
@@ -382,22 +481,14 @@ void COLOR_FIELD_2D::resizeAndWipe(int xRes, int yRes)
     return;
   }
 
-  if (_data)
-    delete[] _data;
-
-  _xRes = xRes;
-  _yRes = yRes;
-  _totalCells = _xRes * _yRes;
-
-  _data = new VEC3F[_xRes * _yRes];
+  reallocate(xRes, yRes);
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = alpha;
+  forEachCell([alpha](VEC3F& cell) { cell = alpha; });
 
   return *this;
 }
@@ -406,8 +497,7 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const float& alpha)
 ///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D& COLOR_FIELD_2D::operator*=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] *= alpha;
+  forEachCell([alpha](VEC3F& cell) { cell *= alpha; });
 
   return *this;
 }
@@ -416,8 +506,7 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator*=(const float& alpha)
 ///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D& COLOR_FIELD_2D::operator/=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] /= alpha;
+  forEachCell([alpha](VEC3F& cell) { cell /= alpha; });
 
   return *this;
 }
@@ -426,8 +515,7 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator/=(const float& alpha)
 ///////////////////////////////////////////////////////////////////////
 COLOR_FIELD_2D& COLOR_FIELD_2D::operator+=(const float& alpha)
 {
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] += alpha;
+  forEachCell([alpha](VEC3F& cell) { cell += alpha; });
 
   return *this;
 }
@@ -438,8 +526,7 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator-=(const COLOR_FIELD_2D& input)
 {
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] -= input[x];
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) { cell -= inputCell; });
 
   return *this;
 }
@@ -450,8 +537,7 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator+=(const COLOR_FIELD_2D& input)
 {
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] += input[x];
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) { cell += inputCell; });
 
   return *this;
 }
@@ -463,12 +549,11 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator*=(const COLOR_FIELD_2D& input)
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
 
-  for (int x = 0; x < _totalCells; x++)
-  {
-    _data[x][0] *= input[x][0];
-    _data[x][1] *= input[x][1];
-    _data[x][2] *= input[x][2];
-  }
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) {
+    cell[0] *= inputCell[0];
+    cell[1] *= inputCell[1];
+    cell[2] *= inputCell[2];
+  });
 
   return *this;
 }
@@ -480,85 +565,79 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator/=(const COLOR_FIELD_2D& input)
   assert(input.xRes() == _xRes);
   assert(input.yRes() == _yRes);
 
-  for (int x = 0; x < _totalCells; x++)
+  forEachCell(input, [](VEC3F& cell, const VEC3F& inputCell) {
     for (int y = 0; y < 3; y++)
-      if (fabs(input[x][y]) > 1e-6)
-        _data[x][y] /= input[x][y];
+      if (fabs(inputCell[y]) > 1e-6)
+        cell[y] /= inputCell[y];
       else
-        _data[x][y] = 0;
+        cell[y] = 0;
+  });
 
   return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D operator*(const COLOR_FIELD_2D& A, const float alpha)
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const COLOR_FIELD_2D& A)
 {
-  COLOR_FIELD_2D final(A);
-  final *= alpha;
-  return final;
-}
+  // every cell gets overwritten, so only touch the allocation
+  // if the size actually changed
+  if (A.xRes() != _xRes || A.yRes() != _yRes)
+    resizeAndWipe(A.xRes(), A.yRes());
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D operator/(const COLOR_FIELD_2D& A, const float alpha)
-{
-  COLOR_FIELD_2D final(A);
-  final /= alpha;
-  return final;
-}
+  forEachCell(A, [](VEC3F& cell, const VEC3F& inputCell) { cell = inputCell; });
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D operator+(const COLOR_FIELD_2D& A, const COLOR_FIELD_2D& B)
-{
-  COLOR_FIELD_2D final(A);
-  final += B;
-  return final;
+  return *this;
 }
 
+// moving into or out of a view copies the cells, since the view's
+// storage stays with its field
 ///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D operator-(const COLOR_FIELD_2D& A, const COLOR_FIELD_2D& B)
+COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(COLOR_FIELD_2D&& A)
 {
-  COLOR_FIELD_2D final(A);
-  final -= B;
-  return final;
-}
+  if (this == &A)
+    return *this;
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D operator+(const COLOR_FIELD_2D& A, const float alpha)
-{
-  COLOR_FIELD_2D final(A);
-  final += alpha;
-  return final;
-}
+  if (_view || A._view)
+    return *this = (const COLOR_FIELD_2D&)A;
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D operator*(const float alpha, const COLOR_FIELD_2D& A)
-{
-  return A * alpha;
-}
+  delete[] _data;
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D operator+(const float alpha, const COLOR_FIELD_2D& A)
-{
-  return A + alpha;
+  _xRes = A._xRes;
+  _yRes = A._yRes;
+  _pitch = A._pitch;
+  _totalCells = A._totalCells;
+  _data = A._data;
+
+  A._xRes = 0;
+  A._yRes = 0;
+  A._pitch = 0;
+  A._totalCells = 0;
+  A._data = NULL;
+
+  return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////
+// exchange contents with another field without copying
 ///////////////////////////////////////////////////////////////////////
-COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const COLOR_FIELD_2D& A)
+void COLOR_FIELD_2D::swap(COLOR_FIELD_2D& input)
 {
-  resizeAndWipe(A.xRes(), A.yRes());
-
-  for (int x = 0; x < _totalCells; x++)
-    _data[x] = A[x];
+  if (_view || input._view)
+  {
+    assert(input.xRes() == _xRes);
+    assert(input.yRes() == _yRes);
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        std::swap((*this)(x, y), input(x, y));
+    return;
+  }
 
-  return *this;
+  std::swap(_xRes, input._xRes);
+  std::swap(_yRes, input._yRes);
+  std::swap(_pitch, input._pitch);
+  std::swap(_totalCells, input._totalCells);
+  std::swap(_data, input._data);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -566,9 +645,8 @@ COLOR_FIELD_2D& COLOR_FIELD_2D::operator=(const COLOR_FIELD_2D& A)
 ///////////////////////////////////////////////////////////////////////
 VEC3F COLOR_FIELD_2D::sum()
 {
-  VEC3F total;
-  for (int x = 0; x < _totalCells; x++)
-    total += _data[x];
+  VEC3F minFound, maxFound, total;
+  minMaxSum(minFound, maxFound, total);
 
   return total;
 }
@@ -579,9 +657,10 @@ VEC3F COLOR_FIELD_2D::sum()
 void COLOR_FIELD_2D::log(float base)
 {
   float scale = 1.0 / std::log(base);
-  for (int x = 0; x < _totalCells; x++)
+  forEachCell([scale](VEC3F& cell) {
     for (int y = 0; y < 3; y++)
-      _data[x][y] = std::log(_data[x][y]) * scale;
+      cell[y] = std::log(cell[y]) * scale;
+  });
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -591,11 +670,8 @@ VEC3F COLOR_FIELD_2D::min()
 {
   assert(_xRes > 0);
   assert(_yRes > 0);
-  VEC3F final = _data[0];
-
-  for (int i = 0; i < _xRes * _yRes; i++)
-    for (int j = 0; j < 3; j++)
-      final[j] = (_data[i][j] < final[j]) ? _data[i][j] : final[j];
+  VEC3F final, maxFound, total;
+  minMaxSum(final, maxFound, total);
 
   return final;
 }
@@ -607,11 +683,8 @@ VEC3F COLOR_FIELD_2D::max()
 {
   assert(_xRes > 0);
   assert(_yRes > 0);
-  VEC3F final = _data[0];
-
-  for (int i = 0; i < _xRes * _yRes; i++)
-    for (int j = 0; j < 3; j++)
-      final[j] = (_data[i][j] > final[j]) ? _data[i][j] : final[j];
+  VEC3F minFound, final, total;
+  minMaxSum(minFound, final, total);
 
   return final;
 }
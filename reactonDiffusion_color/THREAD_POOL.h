@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////
+// A small persistent pool of worker threads for splitting loops over
+// the rows of a field.
+//
+// To use, call
+//
+//   THREAD_POOL::shared().parallelFor(total, function);
+//
+// where function(begin, end) handles the half-open range [begin, end).
+// The range gets cut into contiguous chunks, the calling thread works
+// on chunks too, and parallelFor only returns once all of them are
+// done. Loops can't be nested, so don't call parallelFor from a
+// function that is already running on the pool.
+//
+// Set the FIELD_2D_THREADS environment variable to override the number
+// of threads (1 turns threading off entirely).
+///////////////////////////////////////////////////////////////////////
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstdlib>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+class THREAD_POOL {
+
+public:
+  THREAD_POOL(int totalThreads) :
+    _function(NULL), _generation(0), _quit(false), _total(0), _chunkSize(1),
+    _totalChunks(0), _nextChunk(0), _chunksDone(0), _active(0)
+  {
+    for (int x = 1; x < totalThreads; x++)
+      _workers.push_back(std::thread(&THREAD_POOL::workerLoop, this));
+  };
+
+  ~THREAD_POOL() {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _quit = true;
+    }
+    _wake.notify_all();
+    for (unsigned int x = 0; x < _workers.size(); x++)
+      _workers[x].join();
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // the pool everybody shares, sized to the machine
+  ////////////////////////////////////////////////////////////////////////
+  static THREAD_POOL& shared()
+  {
+    static THREAD_POOL pool(defaultThreads());
+    return pool;
+  };
+
+  // worker threads plus the calling thread
+  const int threads() const { return (int)_workers.size() + 1; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // run function(begin, end) over [0, total) in parallel, never
+  // handing out fewer than minChunk items at once
+  ////////////////////////////////////////////////////////////////////////
+  void parallelFor(int total, const std::function<void(int, int)>& function, int minChunk = 1)
+  {
+    if (total <= 0) return;
+
+    // a few chunks per thread so uneven rows even out
+    int chunkSize = total / (4 * threads());
+    chunkSize = (chunkSize < minChunk) ? minChunk : chunkSize;
+    chunkSize = (chunkSize < 1) ? 1 : chunkSize;
+
+    if (_workers.size() == 0 || chunkSize >= total)
+    {
+      function(0, total);
+      return;
+    }
+
+    // only one loop in flight at a time
+    std::unique_lock<std::mutex> serial(_serial);
+
+    {
+      // wait for stragglers from the last loop to leave before
+      // touching anything they might still read
+      std::unique_lock<std::mutex> lock(_mutex);
+      _finished.wait(lock, [this] { return _active == 0; });
+      _function = &function;
+      _total = total;
+      _chunkSize = chunkSize;
+      _totalChunks = (total + chunkSize - 1) / chunkSize;
+      _nextChunk = 0;
+      _chunksDone = 0;
+      _generation++;
+    }
+    _wake.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finished.wait(lock, [this] { return _chunksDone == _totalChunks && _active == 0; });
+    _function = NULL;
+  };
+
+private:
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::mutex _serial;
+  std::condition_variable _wake;
+  std::condition_variable _finished;
+
+  // the loop currently being run
+  const std::function<void(int, int)>* _function;
+  unsigned int _generation;
+  bool _quit;
+  int _total;
+  int _chunkSize;
+  int _totalChunks;
+  std::atomic<int> _nextChunk;
+  int _chunksDone;
+
+  // workers currently inside runChunks()
+  int _active;
+
+  static int defaultThreads()
+  {
+    const char* environment = getenv("FIELD_2D_THREADS");
+    if (environment && atoi(environment) > 0)
+      return atoi(environment);
+
+    int hardware = (int)std::thread::hardware_concurrency();
+    return (hardware > 0) ? hardware : 1;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // grab chunks until there are none left
+  ////////////////////////////////////////////////////////////////////////
+  void runChunks()
+  {
+    int done = 0;
+    for (int chunk = _nextChunk++; chunk < _totalChunks; chunk = _nextChunk++)
+    {
+      int begin = chunk * _chunkSize;
+      int end = (begin + _chunkSize > _total) ? _total : begin + _chunkSize;
+      (*_function)(begin, end);
+      done++;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _chunksDone += done;
+    if (_chunksDone == _totalChunks)
+      _finished.notify_all();
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // what each worker does for its whole life
+  ////////////////////////////////////////////////////////////////////////
+  void workerLoop()
+  {
+    unsigned int seen = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [this, seen] { return _quit || _generation != seen; });
+        if (_quit) return;
+        seen = _generation;
+        _active++;
+      }
+      runChunks();
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _active--;
+      if (_active == 0)
+        _finished.notify_all();
+    }
+  };
+};
+
+#endif
@@ -0,0 +1,402 @@
+#ifndef FIELD_2D_TYPED_H
+#define FIELD_2D_TYPED_H
+
+///////////////////////////////////////////////////////////////////////
+// A 2D field of any scalar type, for when a float per cell is the
+// wrong size: automata only need a byte per cell, fractals want to
+// keep their doubles, and display buffers get by with half floats.
+//
+//   BYTE_FIELD_2D cells(xRes, yRes);
+//   ... step the automaton in cells ...
+//   FIELD_2D_CONVERT(cells, field);
+//
+// It only carries storage and accessors. The arithmetic, stencils and
+// IO all stay in FIELD_2D, so convert to one of those to use them.
+// Converting to an integer type rounds to the nearest value and
+// saturates, so 0.0 - 1.0 data should be scaled up before going to
+// bytes. Rows start on FIELD_2D_ALIGNMENT boundaries, and the
+// conversions use the 16-wide SIMD loops when built with -mavx512f.
+///////////////////////////////////////////////////////////////////////
+
+#include "FIELD_2D.h"
+#include "THREAD_POOL.h"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// GCC 12 warns about the placeholder operands in its own AVX-512
+// clamp and narrowing intrinsics when they get inlined (GCC PR 105593),
+// so under it the byte conversions take the plain loops, which it
+// vectorizes anyway
+#if defined(__AVX512F__) && !(defined(__GNUC__) && !defined(__clang__) && __GNUC__ == 12)
+#define FIELD_2D_TYPED_AVX512_BYTES 1
+#endif
+
+///////////////////////////////////////////////////////////////////////
+// 16-bit IEEE half float, as stored by OpenGL's GL_HALF_FLOAT. Math
+// on it goes through float.
+///////////////////////////////////////////////////////////////////////
+struct HALF {
+  unsigned short bits;
+
+  HALF() {};
+  HALF(const float value) : bits(fromFloat(value)) {};
+  operator float() const { return toFloat(bits); };
+
+  // round to nearest even, overflow goes to infinity
+  static inline unsigned short fromFloat(const float value)
+  {
+#if defined(__F16C__)
+    return _cvtss_sh(value, 0);
+#else
+    unsigned int f;
+    memcpy(&f, &value, sizeof(float));
+    const unsigned short sign = (f >> 16) & 0x8000;
+    f &= 0x7fffffff;
+
+    // infinity and NaN
+    if (f >= 0x7f800000)
+      return sign | 0x7c00 | ((f > 0x7f800000) ? 0x200 : 0);
+
+    // too big, 65520 and up rounds to infinity
+    if (f >= 0x477ff000)
+      return sign | 0x7c00;
+
+    // too small for a normal half, so shift into a denormal
+    if (f < 0x38800000)
+    {
+      if (f < 0x33000000)
+        return sign;
+      const unsigned int mantissa = (f & 0x7fffff) | 0x800000;
+      const int shift = 126 - (f >> 23);
+      unsigned int half = mantissa >> shift;
+      const unsigned int remainder = mantissa & ((1u << shift) - 1);
+      const unsigned int halfway = 1u << (shift - 1);
+      if (remainder > halfway || (remainder == halfway && (half & 1)))
+        half++;
+      return sign | half;
+    }
+
+    // rebias the exponent and round off the bottom 13 bits
+    unsigned int half = (f >> 13) - (112 << 10);
+    const unsigned int remainder = f & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+      half++;
+    return sign | half;
+#endif
+  };
+
+  // exact, every half is a float
+  static inline float toFloat(const unsigned short half)
+  {
+#if defined(__F16C__)
+    return _cvtsh_ss(half);
+#else
+    const unsigned int sign = (unsigned int)(half & 0x8000) << 16;
+    const unsigned int exponent = (half >> 10) & 0x1f;
+    const unsigned int mantissa = half & 0x3ff;
+
+    unsigned int f;
+    if (exponent == 0)
+    {
+      float value = mantissa * (1.0f / 16777216.0f);
+      memcpy(&f, &value, sizeof(float));
+      f |= sign;
+    }
+    else if (exponent == 31)
+      f = sign | 0x7f800000 | (mantissa << 13);
+    else
+      f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+    float value;
+    memcpy(&value, &f, sizeof(float));
+    return value;
+#endif
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+// How each storage type goes to and from float, a row at a time
+///////////////////////////////////////////////////////////////////////
+template <class T>
+struct FIELD_2D_STORAGE {
+  static void fromFloats(const float* input, T* output, const int size)
+  {
+    for (int x = 0; x < size; x++)
+      output[x] = (T)input[x];
+  };
+  static void toFloats(const T* input, float* output, const int size)
+  {
+    for (int x = 0; x < size; x++)
+      output[x] = (float)input[x];
+  };
+};
+
+template <>
+struct FIELD_2D_STORAGE<unsigned char> {
+  static inline unsigned char fromFloat(float value)
+  {
+    value += 0.5f;
+    value = (value > 0.0f) ? value : 0.0f;
+    value = (value < 255.0f) ? value : 255.0f;
+    return (unsigned char)value;
+  };
+
+  static void fromFloats(const float* input, unsigned char* output, const int size)
+  {
+    int x = 0;
+#if FIELD_2D_TYPED_AVX512_BYTES
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 top = _mm512_set1_ps(255.0f);
+    for (; x + 16 <= size; x += 16)
+    {
+      __m512 value = _mm512_add_ps(_mm512_loadu_ps(input + x), half);
+      value = _mm512_min_ps(_mm512_max_ps(value, zero), top);
+      _mm_storeu_si128((__m128i*)(output + x), _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(value)));
+    }
+#endif
+    for (; x < size; x++)
+      output[x] = fromFloat(input[x]);
+  };
+
+  static void toFloats(const unsigned char* input, float* output, const int size)
+  {
+    int x = 0;
+#if FIELD_2D_TYPED_AVX512_BYTES
+    for (; x + 16 <= size; x += 16)
+    {
+      __m512i value = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(input + x)));
+      _mm512_storeu_ps(output + x, _mm512_cvtepi32_ps(value));
+    }
+#endif
+    for (; x < size; x++)
+      output[x] = input[x];
+  };
+};
+
+template <>
+struct FIELD_2D_STORAGE<HALF> {
+  static void fromFloats(const float* input, HALF* output, const int size)
+  {
+    int x = 0;
+#if defined(__AVX512F__)
+    for (; x + 16 <= size; x += 16)
+      _mm256_storeu_si256((__m256i*)(output + x), _mm512_cvtps_ph(_mm512_loadu_ps(input + x), _MM_FROUND_TO_NEAREST_INT));
+#endif
+#if defined(__F16C__)
+    for (; x + 8 <= size; x += 8)
+      _mm_storeu_si128((__m128i*)(output + x), _mm256_cvtps_ph(_mm256_loadu_ps(input + x), _MM_FROUND_TO_NEAREST_INT));
+#endif
+    for (; x < size; x++)
+      output[x] = HALF(input[x]);
+  };
+
+  static void toFloats(const HALF* input, float* output, const int size)
+  {
+    int x = 0;
+#if defined(__AVX512F__)
+    for (; x + 16 <= size; x += 16)
+      _mm512_storeu_ps(output + x, _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)(input + x))));
+#endif
+#if defined(__F16C__)
+    for (; x + 8 <= size; x += 8)
+      _mm256_storeu_ps(output + x, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(input + x))));
+#endif
+    for (; x < size; x++)
+      output[x] = input[x];
+  };
+};
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+template <class T>
+class FIELD_2D_TYPED {
+public:
+  FIELD_2D_TYPED() :
+    _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL) {};
+  FIELD_2D_TYPED(const int& rows, const int& cols) :
+    _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL)
+  {
+    resizeAndWipe(rows, cols);
+  };
+  FIELD_2D_TYPED(const FIELD_2D_TYPED& m) :
+    _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL)
+  {
+    *this = m;
+  };
+  FIELD_2D_TYPED(FIELD_2D_TYPED&& m) :
+    _xRes(0), _yRes(0), _pitch(0), _totalCells(0), _data(NULL)
+  {
+    swap(m);
+  };
+  ~FIELD_2D_TYPED() { free(_data); };
+
+  // accessors
+  inline T& operator()(int x, int y) { return _data[y * _pitch + x]; };
+  inline const T operator()(int x, int y) const { return _data[y * _pitch + x]; };
+  inline T& operator[](int x) { return _data[x]; };
+  inline const T operator[](int x) const { return _data[x]; };
+  inline T* row(int y) { return _data + y * _pitch; };
+  inline const T* row(int y) const { return _data + y * _pitch; };
+  T* data() { return _data; };
+  T* const data() const { return _data; };
+  const int xRes() const { return _xRes; };
+  const int yRes() const { return _yRes; };
+  const int pitch() const { return _pitch; };
+  const int totalCells() const { return _totalCells; };
+
+  // common field operations
+  void clear()
+  {
+    if (_data)
+      memset((void*)_data, 0, _pitch * _yRes * sizeof(T));
+  };
+
+  void resizeAndWipe(int xRes, int yRes)
+  {
+    // pad rows out to the alignment, which every scalar type divides
+    const int perLine = FIELD_2D_ALIGNMENT / sizeof(T);
+    const int pitch = (xRes + perLine - 1) / perLine * perLine;
+
+    if (xRes != _xRes || yRes != _yRes)
+    {
+      free(_data);
+      _data = NULL;
+      _xRes = xRes;
+      _yRes = yRes;
+      _pitch = pitch;
+      _totalCells = xRes * yRes;
+
+      void* memory = NULL;
+      if (_pitch * _yRes > 0 &&
+          posix_memalign(&memory, FIELD_2D_ALIGNMENT, _pitch * _yRes * sizeof(T)) != 0)
+      {
+        std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+        std::cout << " FIELD_2D_TYPED could not allocate " << _pitch * _yRes << " cells! " << std::endl;
+        exit(0);
+      }
+      _data = (T*)memory;
+    }
+    clear();
+  };
+
+  void swap(FIELD_2D_TYPED& input)
+  {
+    std::swap(_xRes, input._xRes);
+    std::swap(_yRes, input._yRes);
+    std::swap(_pitch, input._pitch);
+    std::swap(_totalCells, input._totalCells);
+    std::swap(_data, input._data);
+  };
+
+  FIELD_2D_TYPED& operator=(const FIELD_2D_TYPED& A)
+  {
+    if (this == &A)
+      return *this;
+    resizeAndWipe(A._xRes, A._yRes);
+    if (_data)
+      memcpy((void*)_data, A._data, _pitch * _yRes * sizeof(T));
+    return *this;
+  };
+  FIELD_2D_TYPED& operator=(FIELD_2D_TYPED&& A)
+  {
+    swap(A);
+    return *this;
+  };
+
+  // set every cell to a value
+  FIELD_2D_TYPED& operator=(const T& value)
+  {
+    for (int y = 0; y < _yRes; y++)
+      for (int x = 0; x < _xRes; x++)
+        _data[y * _pitch + x] = value;
+    return *this;
+  };
+
+private:
+  int _xRes;
+  int _yRes;
+  int _pitch;
+  int _totalCells;
+  T* _data;
+};
+
+typedef FIELD_2D_TYPED<double> DOUBLE_FIELD_2D;
+typedef FIELD_2D_TYPED<HALF> HALF_FIELD_2D;
+typedef FIELD_2D_TYPED<unsigned char> BYTE_FIELD_2D;
+
+///////////////////////////////////////////////////////////////////////
+// Conversion kernels between a FIELD_2D and the typed fields. The
+// output gets resized to match, and rows are split across
+// THREAD_POOL::shared() for big fields.
+///////////////////////////////////////////////////////////////////////
+template <class T>
+void FIELD_2D_CONVERT(const FIELD_2D& input, FIELD_2D_TYPED<T>& output)
+{
+  if (output.xRes() != input.xRes() || output.yRes() != input.yRes())
+    output.resizeAndWipe(input.xRes(), input.yRes());
+
+  const int xRes = input.xRes();
+  THREAD_POOL::shared().parallelFor(input.yRes(), [&](int begin, int end) {
+    // the tiled layouts need their rows pulled out first
+    std::vector<float> scratch(xRes);
+    for (int y = begin; y < end; y++)
+    {
+      const float* row = &scratch[0];
+      if (input.layout() == FIELD_2D_ROW_MAJOR)
+        row = input.row(y);
+      else
+        input.getRun(0, y, xRes, &scratch[0]);
+      FIELD_2D_STORAGE<T>::fromFloats(row, output.row(y), xRes);
+    }
+  }, 65536 / (xRes > 0 ? xRes : 1) + 1);
+}
+
+template <class T>
+void FIELD_2D_CONVERT(const FIELD_2D_TYPED<T>& input, FIELD_2D& output)
+{
+  if (output.xRes() != input.xRes() || output.yRes() != input.yRes())
+    output.resizeAndWipe(input.xRes(), input.yRes());
+
+  const int xRes = input.xRes();
+  THREAD_POOL::shared().parallelFor(input.yRes(), [&](int begin, int end) {
+    std::vector<float> scratch(xRes);
+    for (int y = begin; y < end; y++)
+    {
+      if (output.layout() == FIELD_2D_ROW_MAJOR)
+        FIELD_2D_STORAGE<T>::toFloats(input.row(y), output.row(y), xRes);
+      else
+      {
+        FIELD_2D_STORAGE<T>::toFloats(input.row(y), &scratch[0], xRes);
+        output.setRun(0, y, xRes, &scratch[0]);
+      }
+    }
+  }, 65536 / (xRes > 0 ? xRes : 1) + 1);
+}
+
+// between two typed fields, by way of float
+template <class FROM, class TO>
+void FIELD_2D_CONVERT(const FIELD_2D_TYPED<FROM>& input, FIELD_2D_TYPED<TO>& output)
+{
+  if (output.xRes() != input.xRes() || output.yRes() != input.yRes())
+    output.resizeAndWipe(input.xRes(), input.yRes());
+
+  const int xRes = input.xRes();
+  THREAD_POOL::shared().parallelFor(input.yRes(), [&](int begin, int end) {
+    std::vector<float> scratch(xRes);
+    for (int y = begin; y < end; y++)
+    {
+      FIELD_2D_STORAGE<FROM>::toFloats(input.row(y), &scratch[0], xRes);
+      FIELD_2D_STORAGE<TO>::fromFloats(&scratch[0], output.row(y), xRes);
+    }
+  }, 65536 / (xRes > 0 ? xRes : 1) + 1);
+}
+
+#endif
@@ -4,6 +4,9 @@
 #include "VEC3F.h"
 #include "MERSENNE_TWISTER.h"
 #include "TimeStamper.h"
+#include "HEADLESS.h"
+#include "FIELD_2D_TEXTURE.h"
+#include "PHASE_TIMER.h"
 
 #if _WIN32
 #include <gl/glut.h>
@@ -18,8 +21,8 @@ using namespace std;
 const int N = 8;
 
 // resolution of the field
-int xRes = 400;
-int yRes = 400;
+int xRes = HEADLESS::xRes(400);
+int yRes = HEADLESS::yRes(400);
 
 // the field being drawn and manipulated
 FIELD_2D field(xRes, yRes);
@@ -72,6 +75,12 @@ float zoom = 1.0;
 // Quicktime movie to capture to
 QUICKTIME_MOVIE movie;
 
+// the field as a GL texture, see FIELD_2D_TEXTURE.h
+FIELD_2D_TEXTURE fieldTexture;
+
+// per-phase timings, shown with 't', see PHASE_TIMER.h
+PHASE_TIMER timings;
+
 // forward declare the caching function here so that we can
 // put it at the bottom of the file
 void runOnce();
@@ -139,27 +148,21 @@ void printGlString(string output)
 }
 
 ///////////////////////////////////////////////////////////////////////
-// dump the field contents to a GL texture for drawing
+// bring the GL texture up to date with the field, only sending
+// what changed, see FIELD_2D_TEXTURE.h
 ///////////////////////////////////////////////////////////////////////
 void updateTexture(const FIELD_2D& texture)
 {
+  PHASE_TIMER::SCOPE scope(timings, "updateTexture");
+
   FIELD_2D textureCopy(texture);
   if (normalizing)
+  {
+    PHASE_TIMER::SCOPE scope(timings, "normalize");
     textureCopy.normalize();
+  }
 
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-  glTexImage2D(GL_TEXTURE_2D, 0, 3, 
-      textureCopy.xRes(), 
-      textureCopy.yRes(), 0, 
-      GL_LUMINANCE, GL_FLOAT, 
-      textureCopy.data());
-
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-  glEnable(GL_TEXTURE_2D);
+  fieldTexture.upload(textureCopy);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -167,6 +170,8 @@ void updateTexture(const FIELD_2D& texture)
 ///////////////////////////////////////////////////////////////////////
 void drawGrid()
 {
+  PHASE_TIMER::SCOPE scope(timings, "drawGrid");
+
   glColor4f(0.1, 0.1, 0.1, 1.0);
 
   float dx = 1.0 / xRes;
@@ -191,11 +196,31 @@ void drawGrid()
   glEnd();
 }
 
+///////////////////////////////////////////////////////////////////////
+// print the per-phase timings down the top left corner
+///////////////////////////////////////////////////////////////////////
+void drawTimings()
+{
+  glLoadIdentity();
+  float halfZoom = 0.5 * zoom;
+
+  vector<string> lines = timings.lines();
+  for (unsigned int x = 0; x < lines.size(); x++)
+  {
+    // must set color before setting raster position, otherwise it won't take
+    glColor4f(1.0f, 0.0f, 0.0f, 1.0f);
+    glRasterPos3f(-halfZoom * 0.95, halfZoom * (0.9 - 0.06 * x), 0);
+    printGlString(lines[x]);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////
 // GL and GLUT callbacks
 ///////////////////////////////////////////////////////////////////////
 void glutDisplay()
 {
+  PHASE_TIMER::SCOPE scope(timings, "glutDisplay");
+
   // Make ensuing transforms affect the projection matrix
   glMatrixMode(GL_PROJECTION);
 
@@ -224,14 +249,7 @@ void glutDisplay()
   if (yRes < xRes)
     yLength = (float)yRes / xRes;
 
-  glEnable(GL_TEXTURE_2D); 
-  glBegin(GL_QUADS);
-    glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, 0.0);
-    glTexCoord2f(0.0, 1.0); glVertex3f(0.0, yLength, 0.0);
-    glTexCoord2f(1.0, 1.0); glVertex3f(xLength, yLength, 0.0);
-    glTexCoord2f(1.0, 0.0); glVertex3f(xLength, 0.0, 0.0);
-  glEnd();
-  glDisable(GL_TEXTURE_2D); 
+  fieldTexture.draw(xLength, yLength);
 
   // draw the grid, but only if the user wants
   if (drawingGrid)
@@ -274,7 +292,14 @@ void glutDisplay()
 
   // if we're recording a movie, capture a frame
   if (captureMovie)
+  {
+    PHASE_TIMER::SCOPE scope(timings, "movie");
     movie.addFrameGL();
+  }
+
+  // print the phase timings, but only if the user wants
+  if (timings.showing())
+    drawTimings();
 
   glutSwapBuffers();
 }
@@ -288,7 +313,9 @@ void printCommands()
   cout << "=============================================================== " << endl;
   cout << " q           - quit" << endl;
   cout << " v           - type the value of the cell under the mouse" << endl;
+  cout << " k           - cycle through the colormaps" << endl;
   cout << " g           - throw a grid over everything" << endl;
+  cout << " t           - time each part of a frame, see PHASE_TIMER.h" << endl;
   cout << " m           - start/stop capturing a movie" << endl;
   cout << " r           - read in a PNG file " << endl;
   cout << " w           - write out a PNG file " << endl;
@@ -332,6 +359,9 @@ void glutKeyboard(unsigned char key, int x, int y)
     case '?':
       printCommands();
       break;
+    case 'k':
+      cout << " Colormap: " << fieldTexture.nextColormap() << endl;
+      break;
     case 'v':
       drawingValues = !drawingValues;
       break;
@@ -351,6 +381,7 @@ void glutKeyboard(unsigned char key, int x, int y)
       else
       {
         cout << " Starting to capture movie. " << endl;
+        movie.streamTo("movie.mov");
         captureMovie = true;
       }
       break;
@@ -380,6 +411,9 @@ void glutKeyboard(unsigned char key, int x, int y)
           cout << " Drawing imaginary field" << endl;
       }
       break;
+    case 't':
+      timings.toggle();
+      break;
     case 'q':
       exit(0);
       break;
@@ -462,7 +496,10 @@ void glutPassiveMouseMotion(int x, int y)
 ///////////////////////////////////////////////////////////////////////
 void glutIdle()
 {
-  runEverytime();
+  {
+    PHASE_TIMER::SCOPE scope(timings, "runEverytime");
+    runEverytime();
+  }
   switch (drawingField)
   {
     case 1:
@@ -528,6 +565,13 @@ int main(int argc, char** argv)
   }
 
   runOnce();
+  
+  // run without a window if asked to, see HEADLESS.h
+  HEADLESS headless(argc, argv);
+  // the state a -restart has to bring back
+  headless.checkpoint().add("field", field);
+  if (headless.enabled())
+    return headless.run(runEverytime, field);
 
   // initialize GLUT and GL
   glutInit(&argc, argv);
@@ -0,0 +1,72 @@
+#ifndef FIELD_2D_TRIPLE_H
+#define FIELD_2D_TRIPLE_H
+
+///////////////////////////////////////////////////////////////////////
+// Three same-sized fields for handing finished frames from one thread
+// to another without either of them ever waiting on the other.
+//
+// The writer fills back() and publishes it, the reader picks up the
+// newest published frame, if there is one, and reads front():
+//
+//   // simulation thread           // display thread
+//   frames.back() = field;         if (frames.update())
+//   frames.publish();                draw(frames.front());
+//
+// Whichever frame is in the middle is the newest one not picked up
+// yet. Publishing and picking up just trade indices with the middle
+// through a single atomic, so the writer can publish as often as it
+// likes, and frames the reader never got around to simply get reused.
+// Works for both FIELD_2D and COLOR_FIELD_2D.
+///////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+
+template <class FIELD>
+class FIELD_2D_TRIPLE {
+public:
+  FIELD_2D_TRIPLE(const int& xRes, const int& yRes) :
+    _back(0), _middle(1), _front(2)
+  {
+    for (int x = 0; x < 3; x++)
+      _fields[x] = FIELD(xRes, yRes);
+  };
+
+  // only for the writer
+  inline FIELD& back() { return _fields[_back]; };
+
+  // only for the reader
+  inline const FIELD& front() const { return _fields[_front]; };
+
+  ////////////////////////////////////////////////////////////////////////
+  // writer: hand back() over as the newest frame, and get the old
+  // middle back to fill next
+  ////////////////////////////////////////////////////////////////////////
+  void publish()
+  {
+    _back = _middle.exchange(_back | FRESH, std::memory_order_acq_rel) & INDEX;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // reader: if something was published since the last call, make it
+  // front() and return true
+  ////////////////////////////////////////////////////////////////////////
+  bool update()
+  {
+    if (!(_middle.load(std::memory_order_relaxed) & FRESH))
+      return false;
+
+    _front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX;
+    return true;
+  };
+
+private:
+  // the middle index, plus a bit for whether it's been picked up
+  enum { INDEX = 3, FRESH = 4 };
+
+  FIELD _fields[3];
+  int _back;
+  std::atomic<int> _middle;
+  int _front;
+};
+
+#endif
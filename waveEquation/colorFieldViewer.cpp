@@ -2,6 +2,8 @@
 #include <complex>
 #include "COLOR_FIELD_2D.h"
 #include "FIELD_2D.h"
+#include "FIELD_2D_BUFFER.h"
+#include "FIELD_2D_TRIPLE.h"
 #include "VEC3F.h"
 #include "MERSENNE_TWISTER.h"
 #include <iostream>
@@ -9,6 +11,10 @@
 #include "MATRIX.h"
 #include "VECTOR.h"
 #include "TimeStamper.h"
+#include "HEADLESS.h"
+#include "FIELD_2D_TEXTURE.h"
+#include "PHASE_TIMER.h"
+#include "SIMULATION_THREAD.h"
 
 #if _WIN32
 #include <gl/glut.h>
@@ -19,18 +25,27 @@
 using namespace std;
 
 // resolution of the field
-int xRes = 600;
-int yRes = 600;
-
-// the field being drawn and manipulated
-COLOR_FIELD_2D field(xRes, yRes);
-COLOR_FIELD_2D height(xRes, yRes);
-COLOR_FIELD_2D heightOld(xRes, yRes);
-COLOR_FIELD_2D backup(xRes, yRes);
+int xRes = HEADLESS::xRes(600);
+int yRes = HEADLESS::yRes(600);
+
+// the current and previous wave heights
+FIELD_2D_BUFFER<COLOR_FIELD_2D> heights(xRes, yRes);
+
+// the field being drawn and manipulated, always the current height
+COLOR_FIELD_2D& field = heights.current();
 COLOR_FIELD_2D laplacian(xRes, yRes);
 COLOR_FIELD_2D A(xRes, yRes);
 COLOR_FIELD_2D B(xRes, yRes);
 
+// finished frames, handed from the simulation thread to the display
+FIELD_2D_TRIPLE<COLOR_FIELD_2D> frames(xRes, yRes);
+
+// per-phase timings, shown with 't', see PHASE_TIMER.h
+PHASE_TIMER timings;
+
+// runs runEverytime() off of the GL thread, see SIMULATION_THREAD.h
+SIMULATION_THREAD simulation;
+
 // the resolution of the OpenGL window -- independent of the field resolution
 int xScreenRes = 800;
 int yScreenRes = 800;
@@ -70,6 +85,9 @@ float zoom = 1.0;
 // Quicktime movie to capture to
 QUICKTIME_MOVIE movie;
 
+// the field as a GL texture, see FIELD_2D_TEXTURE.h
+FIELD_2D_TEXTURE fieldTexture;
+
 // a random number generator
 MERSENNE_TWISTER twister(123456);
 
@@ -81,6 +99,9 @@ void runOnce();
 // put it at the bottom of the file
 void runEverytime();
 
+// copy the field over for the display, see SIMULATION_THREAD.h
+void publishFrame();
+
 ///////////////////////////////////////////////////////////////////////
 // Figure out which field element is being pointed at, set xField and
 // yField to them
@@ -140,39 +161,14 @@ void printGlString(string output)
 }
 
 ///////////////////////////////////////////////////////////////////////
-// dump the field contents to a GL texture for drawing
+// bring the GL texture up to date with the field, only sending
+// what changed, see FIELD_2D_TEXTURE.h
 ///////////////////////////////////////////////////////////////////////
 void updateTexture(const COLOR_FIELD_2D& texture)
 {
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  PHASE_TIMER::SCOPE scope(timings, "updateTexture");
 
-  // create a flatten array of the color values
-  int totalCells = texture.xRes() * texture.yRes();
-  float* flatData = new float[totalCells * 3];
-
-  for (int x = 0; x < totalCells; x++)
-  {
-    flatData[3 * x] = texture[x][0];
-    flatData[3 * x + 1] = texture[x][1];
-    flatData[3 * x + 2] = texture[x][2];
-  }
-
-  // send the data to the texture
-  glTexImage2D(GL_TEXTURE_2D, 0, 3, 
-      texture.xRes(), 
-      texture.yRes(), 0, 
-      GL_RGB, GL_FLOAT, 
-      flatData);
-
-  // remember to clean up after ourselves
-  delete[] flatData;
-
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-  glEnable(GL_TEXTURE_2D);
+  fieldTexture.upload(texture);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -180,6 +176,8 @@ void updateTexture(const COLOR_FIELD_2D& texture)
 ///////////////////////////////////////////////////////////////////////
 void drawGrid()
 {
+  PHASE_TIMER::SCOPE scope(timings, "drawGrid");
+
   glColor4f(0.1, 0.1, 0.1, 1.0);
 
   float dx = 1.0 / xRes;
@@ -191,12 +189,12 @@ void drawGrid()
     dy *= (float)yRes / xRes;
 
   glBegin(GL_LINES);
-  for (int x = 0; x < field.xRes() + 1; x++)
+  for (int x = 0; x < frames.front().xRes() + 1; x++)
   {
     glVertex3f(x * dx, 0, 1);
     glVertex3f(x * dx, 1, 1);
   }
-  for (int y = 0; y < field.yRes() + 1; y++)
+  for (int y = 0; y < frames.front().yRes() + 1; y++)
   {
     glVertex3f(0, y * dy, 1);
     glVertex3f(1, y * dy, 1);
@@ -204,11 +202,31 @@ void drawGrid()
   glEnd();
 }
 
+///////////////////////////////////////////////////////////////////////
+// print the per-phase timings down the top left corner
+///////////////////////////////////////////////////////////////////////
+void drawTimings()
+{
+  glLoadIdentity();
+  float halfZoom = 0.5 * zoom;
+
+  vector<string> lines = timings.lines();
+  for (unsigned int x = 0; x < lines.size(); x++)
+  {
+    // must set color before setting raster position, otherwise it won't take
+    glColor4f(1.0f, 0.0f, 0.0f, 1.0f);
+    glRasterPos3f(-halfZoom * 0.95, halfZoom * (0.9 - 0.06 * x), 0);
+    printGlString(lines[x]);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////
 // GL and GLUT callbacks
 ///////////////////////////////////////////////////////////////////////
 void glutDisplay()
 {
+  PHASE_TIMER::SCOPE scope(timings, "glutDisplay");
+
   // Make ensuing transforms affect the projection matrix
   glMatrixMode(GL_PROJECTION);
 
@@ -237,14 +255,7 @@ void glutDisplay()
   if (yRes < xRes)
     yLength = (float)yRes / xRes;
 
-  glEnable(GL_TEXTURE_2D); 
-  glBegin(GL_QUADS);
-    glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, 0.0);
-    glTexCoord2f(0.0, 1.0); glVertex3f(0.0, yLength, 0.0);
-    glTexCoord2f(1.0, 1.0); glVertex3f(xLength, yLength, 0.0);
-    glTexCoord2f(1.0, 0.0); glVertex3f(xLength, 0.0, 0.0);
-  glEnd();
-  glDisable(GL_TEXTURE_2D); 
+  fieldTexture.draw(xLength, yLength);
 
   // draw the grid, but only if the user wants
   if (drawingGrid)
@@ -271,7 +282,7 @@ void glutDisplay()
     sprintf(buffer, "%i", yField);
     fieldValue = fieldValue + string(", ") + string(buffer) + string(") = ");
 
-    VEC3F value = field(xField, yField);
+    VEC3F value = frames.front()(xField, yField);
     sprintf(buffer, "(%f %f %f)", value[0], value[1], value[2]);
     fieldValue = fieldValue + string(buffer);
 
@@ -282,7 +293,14 @@ void glutDisplay()
 
   // if we're recording a movie, capture a frame
   if (captureMovie)
-    movie.addFrameGL();
+  {
+    PHASE_TIMER::SCOPE scope(timings, "movie");
+    movie.addFrameCOLOR_FIELD_2D(frames.front());
+  }
+
+  // print the phase timings, but only if the user wants
+  if (timings.showing())
+    drawTimings();
 
   glutSwapBuffers();
 }
@@ -297,6 +315,7 @@ void printCommands()
   cout << " q           - quit" << endl;
   cout << " v           - type the value of the cell under the mouse" << endl;
   cout << " g           - throw a grid over everything" << endl;
+  cout << " t           - time each part of a frame, see PHASE_TIMER.h" << endl;
   cout << " a           - start/stop animation" << endl;  
   cout << " m           - start/stop capturing a movie" << endl;
   cout << " r           - read in a PNG file " << endl;
@@ -335,6 +354,7 @@ void glutKeyboard(unsigned char key, int x, int y)
   {
     case 'a':
       animate = !animate;
+      simulation.setRunning(animate);
       break;      
     case 'g':
       drawingGrid = !drawingGrid;
@@ -361,25 +381,34 @@ void glutKeyboard(unsigned char key, int x, int y)
       else
       {
         cout << " Starting to capture movie. " << endl;
+        movie.streamTo("movie.mov");
         captureMovie = true;
       }
       break;
     case 'r':
+    {
+      lock_guard<mutex> guard(simulation.lock());
       field.readPNG("input.png");
       xRes = field.xRes();
       yRes = field.yRes();
+    }
+      simulation.refresh();
       break;
     case 'w':
     {
       TimeStamper ts;
+      lock_guard<mutex> guard(simulation.lock());
       field.writePNG(ts.timestampedFilename("output",".png"));
     }
       break;
+    case 't':
+      timings.toggle();
+      break;
     case 'q':
       exit(0);
       break;
     case ' ':
-      runEverytime();
+      simulation.step();
       break;
     default:
       break;
@@ -402,7 +431,11 @@ void glutMouseClick(int button, int state, int x, int y)
     refreshMouseFieldIndex(x,y);
     
     // set the cell - sets to RED in this case
-    field(xField, yField)[0] = 1;
+    {
+      lock_guard<mutex> guard(simulation.lock());
+      field(xField, yField)[0] = 1;
+    }
+    simulation.refresh();
     
     // make sure nothing else is called
     return;
@@ -425,7 +458,11 @@ void glutMouseMotion(int x, int y)
     refreshMouseFieldIndex(x,y);
     
     // set the cell - sets to RED in this case
-    field(xField, yField)[0] = 1;
+    {
+      lock_guard<mutex> guard(simulation.lock());
+      field(xField, yField)[0] = 1;
+    }
+    simulation.refresh();
     
     // make sure nothing else is called
     return;
@@ -455,15 +492,24 @@ void glutPassiveMouseMotion(int x, int y)
   refreshMouseFieldIndex(x,y);
 }
 
+///////////////////////////////////////////////////////////////////////
+// runEverytime(), timed for the overlay
+///////////////////////////////////////////////////////////////////////
+void timedRunEverytime()
+{
+  PHASE_TIMER::SCOPE scope(timings, "runEverytime");
+  runEverytime();
+}
+
 ///////////////////////////////////////////////////////////////////////
 // animate and display new result
 ///////////////////////////////////////////////////////////////////////
 void glutIdle()
 {
-  if(animate){
-      runEverytime();      
-  }
-  updateTexture(field);
+  // the simulation thread does the stepping, so just pick up
+  // whatever it finished last, if anything
+  if (frames.update())
+    updateTexture(frames.front());
   glutPostRedisplay();
 }
 
@@ -516,6 +562,19 @@ int main(int argc, char** argv)
   }
 
   runOnce();
+  
+  // run without a window if asked to, see HEADLESS.h
+  HEADLESS headless(argc, argv);
+  // the state a -restart has to bring back
+  headless.checkpoint().add("height", heights[0]);
+  headless.checkpoint().add("heightOld", heights[1]);
+  headless.checkpoint().add("A", A);
+  headless.checkpoint().add("B", B);
+  if (headless.enabled())
+    return headless.run(runEverytime, field);
+
+  // step on a thread of our own, paused until 'a' gets pressed
+  simulation.start(timedRunEverytime, publishFrame);
 
   // initialize GLUT and GL
   glutInit(&argc, argv);
@@ -549,7 +608,8 @@ void runEverytime()
   float xLen = 1.0;
   float dx = xLen / (float) xRes;
 
-  height = field;
+  COLOR_FIELD_2D& height = heights[0];
+  COLOR_FIELD_2D& heightOld = heights[1];
   for (int x = 1; x < xRes-1; x++) for (int y = 1; y < yRes-1; y++){
     complex<double> z(x * 10.0/xRes-1, y * 10.0/yRes-1);
       float reactA = R_A( A(x,y),B(x,y) );
@@ -568,16 +628,26 @@ void runEverytime()
 
     }
   }
-  backup = height;
-  height = ((dt * dt) / (dx * dx)) * C * laplacian + (2 * height);
-  height -= heightOld;
-  heightOld = backup;
-  field = height;
+
+  // the old heights are only needed cell by cell, so the new ones
+  // can overwrite them in place and then become current
+  heightOld = ((dt * dt) / (dx * dx)) * C * laplacian + (2 * height) - heightOld;
+  heights.rotate();
   // field += 0.5;
   // field *= 0.5;
 
 }
 
+///////////////////////////////////////////////////////////////////////
+// Called on the simulation thread after every step, to hand a copy
+// of the field over to the display
+///////////////////////////////////////////////////////////////////////
+void publishFrame()
+{
+  frames.back() = field;
+  frames.publish();
+}
+
 ///////////////////////////////////////////////////////////////////////
 // This is called once at the beginning so you can precache
 // something here
@@ -0,0 +1,218 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+///////////////////////////////////////////////////////////////////////
+// Runs a viewer's simulation without opening a window
+//
+// Every viewer checks its command line before starting up GLUT:
+//
+//   ./fieldViewer -headless 1000 -dump 100 frames/step
+//
+// calls runOnce(), then runEverytime() 1000 times as fast as it will
+// go, and writes the field out to frames/step.0000100.png and so on
+// every 100 steps. -dump and the prefix after it are both optional.
+// When it's done, it prints steps per second, and the time spent
+// writing frames doesn't count against it.
+//
+// The fields are globals that get built before main() runs, so the
+// resolution comes from the environment instead, the same as
+// FIELD_2D_THREADS in THREAD_POOL.h:
+//
+//   FIELD_2D_RES=1024 ./fieldViewer -headless 1000
+//   FIELD_2D_RES=1024x512 ./fieldViewer -headless 1000
+//
+// Viewers that load an image can still override it. Viewers that
+// seed patterns at fixed spots pass the smallest size they fit in,
+// and anything asked for below that gets bumped up to it:
+//
+//   int xRes = HEADLESS::xRes(100, 92);
+//
+// The frames can also go into one compressed FIELD_2D_SERIES.h file
+// instead, which reads back losslessly and takes far less room:
+//
+//   ./fieldViewer -headless 1000 -series 10 frames.series
+//
+// Long runs can be checkpointed and picked up again later:
+//
+//   ./fieldViewer -headless 100000 -checkpoint 5000 run.snap
+//   ./fieldViewer -headless 100000 -restart run.snap
+//
+// saves a FIELD_2D_SNAPSHOT.h snapshot every 5000 steps, and the
+// second run carries on from whatever step the snapshot was taken at.
+// The viewer has to register everything its steps depend on with
+// checkpoint() before calling run(). The displayed field is often
+// only part of that, so viewers that haven't registered anything
+// refuse both flags rather than restart from the wrong state.
+// cymatics and noise_modified are the ones that still do: their
+// steps also advance a plain counter that no field holds.
+//
+// A restart with -series carries on the series the first run left,
+// writing over any frames it got to after the snapshot.
+///////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "FIELD_2D_SERIES.h"
+#include "FIELD_2D_SNAPSHOT.h"
+
+class HEADLESS {
+public:
+  HEADLESS(int argc, char** argv) :
+    _steps(0), _dumpEvery(0), _dumpPrefix("frame"),
+    _seriesEvery(0), _seriesFile("frames.series"),
+    _checkpointEvery(0), _checkpointFile("checkpoint.snap")
+  {
+    for (int x = 1; x < argc; x++)
+    {
+      if (strcmp(argv[x], "-headless") == 0 && x + 1 < argc)
+        _steps = atoi(argv[++x]);
+      else if (strcmp(argv[x], "-dump") == 0 && x + 1 < argc)
+      {
+        _dumpEvery = atoi(argv[++x]);
+        if (x + 1 < argc && argv[x + 1][0] != '-')
+          _dumpPrefix = argv[++x];
+      }
+      else if (strcmp(argv[x], "-series") == 0 && x + 1 < argc)
+      {
+        _seriesEvery = atoi(argv[++x]);
+        if (x + 1 < argc && argv[x + 1][0] != '-')
+          _seriesFile = argv[++x];
+      }
+      else if (strcmp(argv[x], "-checkpoint") == 0 && x + 1 < argc)
+      {
+        _checkpointEvery = atoi(argv[++x]);
+        if (x + 1 < argc && argv[x + 1][0] != '-')
+          _checkpointFile = argv[++x];
+      }
+      else if (strcmp(argv[x], "-restart") == 0 && x + 1 < argc)
+        _restartFile = argv[++x];
+    }
+  };
+
+  // was -headless passed in?
+  const bool enabled() const { return _steps > 0; };
+
+  // everything a restart needs, see FIELD_2D_SNAPSHOT.h
+  FIELD_2D_CHECKPOINT& checkpoint() { return _checkpoint; };
+
+  // resolution asked for in FIELD_2D_RES, otherwise the fallback,
+  // and never less than minimum
+  static int xRes(int fallback, int minimum = 1)
+  {
+    const char* environment = getenv("FIELD_2D_RES");
+    if (environment && atoi(environment) > 0)
+      return atLeast(atoi(environment), minimum);
+    return fallback;
+  };
+  static int yRes(int fallback, int minimum = 1)
+  {
+    const char* environment = getenv("FIELD_2D_RES");
+    if (environment == NULL || atoi(environment) <= 0)
+      return fallback;
+
+    const char* separator = strchr(environment, 'x');
+    if (separator && atoi(separator + 1) > 0)
+      return atLeast(atoi(separator + 1), minimum);
+    return atLeast(atoi(environment), minimum);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // take all the steps, dumping field along the way, and return what
+  // main() should
+  ////////////////////////////////////////////////////////////////////////
+  template <class FIELD>
+  int run(void (*runEverytime)(), FIELD& field)
+  {
+    if (_checkpoint.empty() && (_checkpointEvery > 0 || !_restartFile.empty()))
+    {
+      std::cout << __FILE__ << " " << __FUNCTION__ << " " << __LINE__ << " : " << std::endl;
+      std::cout << " This viewer doesn't register its state with checkpoint(), so it can't -checkpoint or -restart" << std::endl;
+      return 1;
+    }
+
+    int first = 1;
+    if (!_restartFile.empty())
+    {
+      first = (int)_checkpoint.restore(_restartFile) + 1;
+      printf(" restarting from step %i of %s\n", first - 1, _restartFile.c_str());
+    }
+
+    // a restart carries on the series the first run left, if there is one
+    FIELD_2D_SERIES_WRITER series(_seriesFile);
+    if (_seriesEvery > 0 && !_restartFile.empty())
+      series.resume(first);
+    const int seriesKept = series.totalFrames();
+
+    double seconds = 0.0;
+    int dumps = 0;
+    int checkpoints = 0;
+    for (int x = first; x <= _steps; x++)
+    {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      runEverytime();
+      seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      if (_dumpEvery > 0 && x % _dumpEvery == 0)
+      {
+        char filename[1024];
+        snprintf(filename, sizeof(filename), "%s.%07i.png", _dumpPrefix.c_str(), x);
+        field.writePNG(filename);
+        dumps++;
+      }
+
+      if (_seriesEvery > 0 && x % _seriesEvery == 0)
+        series.append(field, x);
+
+      if (_checkpointEvery > 0 && x % _checkpointEvery == 0)
+      {
+        _checkpoint.save(_checkpointFile, x);
+        checkpoints++;
+      }
+    }
+
+    const int steps = (_steps >= first) ? _steps - first + 1 : 0;
+    const double cells = (double)field.xRes() * field.yRes();
+    printf(" %i steps at %i x %i in %.3f seconds\n", steps, field.xRes(), field.yRes(), seconds);
+    if (steps > 0)
+      printf(" %.2f steps/sec, %.3f ms/step, %.2f Mcells/sec\n",
+             steps / seconds, 1000.0 * seconds / steps, cells * steps / (seconds * 1e6));
+    if (series.totalFrames() > 0)
+    {
+      series.close();
+      printf(" %i frames written to %s, %.1f MB, %.2f:1\n", series.totalFrames() - seriesKept, _seriesFile.c_str(),
+             series.bytesWritten() / 1e6, (double)series.rawBytes() / series.bytesWritten());
+      if (seriesKept > 0)
+        printf(" after the %i it already had\n", seriesKept);
+    }
+    if (checkpoints > 0)
+      printf(" %i checkpoints written to %s\n", checkpoints, _checkpointFile.c_str());
+    if (dumps > 0)
+      printf(" %i frames written to %s.*.png\n", dumps, _dumpPrefix.c_str());
+    return 0;
+  };
+
+private:
+  static int atLeast(int resolution, int minimum)
+  {
+    if (resolution >= minimum)
+      return resolution;
+    printf(" FIELD_2D_RES asked for %i, but this viewer needs at least %i\n", resolution, minimum);
+    return minimum;
+  };
+
+  int _steps;
+  int _dumpEvery;
+  std::string _dumpPrefix;
+  int _seriesEvery;
+  std::string _seriesFile;
+  int _checkpointEvery;
+  std::string _checkpointFile;
+  std::string _restartFile;
+  FIELD_2D_CHECKPOINT _checkpoint;
+};
+
+#endif